@@ -0,0 +1,30 @@
+#!/bin/bash
+
+set -o nounset
+set -e
+
+ProjectDir=`pwd`
+OutputDir="Release/"
+ProjectOutputDir="${ProjectDir}/${OutputDir}"
+CommonInclude=""
+CommonCPPFlags="-Werror -std=c++11 -g -lc++abi -lc++"
+CommonExtDepsFlags=""
+CommonLinkerFlags="-L${ProjectOutputDir}"
+
+CommonReleaseCPPFlags="${CommonCPPFlags} -O2"
+
+# Pass arguments through to every benchmark, eg ./bench.sh 64M
+BenchArgs="$@"
+
+
+# BENCH VTB_HASH
+echo "building vtb_hash benchmark..."
+mkdir -p $ProjectOutputDir/o/vtb_hash
+
+clang $CommonInclude $CommonReleaseCPPFlags $ProjectDir/bench/vtb_hash.cpp -o $ProjectOutputDir/o/vtb_hash_bench $CommonLinkerFlags
+
+echo "vtb_hash_bench..."
+$ProjectOutputDir/o/vtb_hash_bench $BenchArgs
+
+
+echo "ALL BENCHMARKS DONE"
@@ -0,0 +1,504 @@
+#define VTB_HASH_IMPLEMENTATION
+
+#include "../vtb_hash.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <math.h>
+#include <chrono>
+
+#if defined(__i386__) || defined(__x86_64__)
+#include <x86intrin.h>
+#define VTBB_HAS_TSC
+#endif
+
+// Benchmark and quality harness for vtb_hash. Build with optimizations on
+// (see bench.sh) and run:
+//
+//     vtb_hash_bench [max_bytes]
+//
+// max_bytes is the largest input size for the throughput test. It defaults to
+// 1 GB, and accepts a K, M or G suffix.
+//
+// Every hash in g_hashes is run through the same throughput, small key latency
+// and quality tests, so that a change to vtb_hash can be compared against
+// itself and against the baselines in one run.
+
+typedef uint32_t (*hash_function)(const unsigned char* bytes, size_t num_bytes);
+
+static uint32_t hash_vtb(const unsigned char* bytes, size_t num_bytes)
+{
+	vtb_hash h = vtbh_new();
+	vtbh_bytes(&h, bytes, num_bytes);
+	return h.hash;
+}
+
+// Should cost exactly what hash_vtb does, the seed only changes the start.
+static const vtb_hash g_seeded = vtbh_new_seeded(0x5EED);
+
+static uint32_t hash_vtb_seeded(const unsigned char* bytes, size_t num_bytes)
+{
+	vtb_hash h = g_seeded;
+	vtbh_bytes(&h, bytes, num_bytes);
+	return h.hash;
+}
+
+// Through vtbh_ints, which with a seed should cost the same as the bytes.
+static uint32_t hash_vtb_seeded_ints(const unsigned char* bytes, size_t num_bytes)
+{
+	size_t num_ints = num_bytes / sizeof(unsigned int);
+
+	vtb_hash h = g_seeded;
+	vtbh_ints(&h, (unsigned int*)bytes, num_ints);
+	vtbh_bytes(&h, bytes + num_ints*sizeof(unsigned int), num_bytes - num_ints*sizeof(unsigned int));
+	return h.hash;
+}
+
+// FNV-1a, 32 bit. http://www.isthe.com/chongo/tech/comp/fnv/
+static uint32_t hash_fnv1a(const unsigned char* bytes, size_t num_bytes)
+{
+	uint32_t hash = 0x811C9DC5;
+
+	for (size_t k = 0; k < num_bytes; k++)
+	{
+		hash ^= bytes[k];
+		hash *= 0x01000193;
+	}
+
+	return hash;
+}
+
+// A minimal word-at-a-time multiply-rotate hash, in the style of the
+// Murmur family's inner loop. A baseline for what a word-wise kernel costs.
+static uint32_t hash_mulrot(const unsigned char* bytes, size_t num_bytes)
+{
+	uint64_t hash = 0x9E3779B97F4A7C15ull ^ num_bytes;
+
+	size_t k = 0;
+	for (; k + 8 <= num_bytes; k += 8)
+	{
+		uint64_t word;
+		memcpy(&word, bytes + k, sizeof(word));
+
+		word *= 0x87C37B91114253D5ull;
+		word = (word << 31) | (word >> 33);
+		word *= 0x4CF5AD432745937Full;
+
+		hash ^= word;
+		hash = (hash << 27) | (hash >> 37);
+		hash = hash*5 + 0x52DCE729;
+	}
+
+	uint64_t tail = 0;
+	for (size_t j = 0; k + j < num_bytes; j++)
+		tail |= (uint64_t)bytes[k + j] << (j*8);
+
+	hash ^= tail * 0x87C37B91114253D5ull;
+
+	hash ^= hash >> 33;
+	hash *= 0xFF51AFD7ED558CCDull;
+	hash ^= hash >> 33;
+
+	return (uint32_t)hash;
+}
+
+// vtbh_floats_canonical over the whole words, vtbh_bytes over the rest.
+// The text keys in the quality tests aren't floats, but NaN payloads and -0
+// are rare enough in them not to matter.
+static uint32_t hash_vtb_floats(const unsigned char* bytes, size_t num_bytes)
+{
+	size_t num_floats = num_bytes / sizeof(float);
+
+	vtb_hash h = vtbh_new();
+	vtbh_floats_canonical(&h, (const float*)bytes, num_floats);
+	vtbh_bytes(&h, bytes + num_floats*sizeof(float), num_bytes - num_floats*sizeof(float));
+	return h.hash;
+}
+
+static uint32_t hash_vtb_chash(const unsigned char* bytes, size_t num_bytes)
+{
+	vtb_chash c = vtbh_chash_new();
+	vtbh_chash_bytes(&c, bytes, num_bytes);
+	return (uint32_t)vtbh_chash_digest(c);
+}
+
+static uint32_t hash_crc32c(const unsigned char* bytes, size_t num_bytes)
+{
+	vtb_crc32c c = vtbh_crc32c_new();
+	vtbh_crc32c(&c, bytes, num_bytes);
+	return c.crc;
+}
+
+struct named_hash
+{
+	const char*   name;
+	hash_function function;
+};
+
+static named_hash g_hashes[] =
+{
+	{ "vtb_hash", hash_vtb },
+	{ "vtb_seeded", hash_vtb_seeded },
+	{ "vtb_seedints", hash_vtb_seeded_ints },
+	{ "vtb_floats", hash_vtb_floats },
+	{ "vtb_chash",  hash_vtb_chash },
+	{ "crc32c",     hash_crc32c },
+	{ "fnv1a",    hash_fnv1a },
+	{ "mulrot",   hash_mulrot },
+};
+
+#define VTBB_ARRAY_SIZE(x) (sizeof(x)/sizeof(x[0]))
+
+// Keeps results alive so the compiler can't drop the work.
+static volatile uint32_t g_sink;
+
+static double seconds_now()
+{
+	using namespace std::chrono;
+	return duration_cast<duration<double> >(steady_clock::now().time_since_epoch()).count();
+}
+
+static uint64_t ticks_now()
+{
+#ifdef VTBB_HAS_TSC
+	return __rdtsc();
+#else
+	return 0;
+#endif
+}
+
+static uint64_t g_random_state = 0x2545F4914F6CDD1Dull;
+
+// xorshift64*, so results don't depend on the platform's rand().
+static uint64_t random_u64()
+{
+	g_random_state ^= g_random_state >> 12;
+	g_random_state ^= g_random_state << 25;
+	g_random_state ^= g_random_state >> 27;
+	return g_random_state * 0x2545F4914F6CDD1Dull;
+}
+
+static void random_fill(unsigned char* bytes, size_t num_bytes)
+{
+	for (size_t k = 0; k < num_bytes; k++)
+		bytes[k] = (unsigned char)(random_u64() >> 56);
+}
+
+static size_t parse_size(const char* s)
+{
+	char* end;
+	double value = strtod(s, &end);
+
+	if (*end == 'k' || *end == 'K')
+		value *= 1024;
+	else if (*end == 'm' || *end == 'M')
+		value *= 1024*1024;
+	else if (*end == 'g' || *end == 'G')
+		value *= 1024*1024*1024;
+
+	return (size_t)value;
+}
+
+static void format_size(char* out, size_t out_size, size_t bytes)
+{
+	if (bytes >= 1024*1024*1024 && bytes % (1024*1024*1024) == 0)
+		snprintf(out, out_size, "%dG", (int)(bytes/(1024*1024*1024)));
+	else if (bytes >= 1024*1024 && bytes % (1024*1024) == 0)
+		snprintf(out, out_size, "%dM", (int)(bytes/(1024*1024)));
+	else if (bytes >= 1024 && bytes % 1024 == 0)
+		snprintf(out, out_size, "%dK", (int)(bytes/1024));
+	else
+		snprintf(out, out_size, "%dB", (int)bytes);
+}
+
+// Throughput: hash a buffer of each size repeatedly, take the best of a few
+// trials. Each trial runs at least g_min_trial_bytes so that small sizes
+// aren't dominated by timer resolution.
+static const int g_trials = 3;
+static const size_t g_min_trial_bytes = 64*1024*1024;
+
+static void bench_throughput(const unsigned char* buffer, size_t max_bytes)
+{
+	printf("\nTHROUGHPUT (best of %d)\n", g_trials);
+	printf("%-12s %8s %10s %12s\n", "hash", "size", "GB/s", "cycles/byte");
+
+	for (size_t h = 0; h < VTBB_ARRAY_SIZE(g_hashes); h++)
+	{
+		for (size_t size = 4; size <= max_bytes; size *= 4)
+		{
+			size_t repetitions = g_min_trial_bytes/size;
+			if (repetitions < 1)
+				repetitions = 1;
+
+			double best_seconds = 1e100;
+			uint64_t best_ticks = ~(uint64_t)0;
+
+			for (int trial = 0; trial < g_trials; trial++)
+			{
+				uint32_t sink = 0;
+
+				double start = seconds_now();
+				uint64_t start_ticks = ticks_now();
+
+				for (size_t r = 0; r < repetitions; r++)
+					sink += g_hashes[h].function(buffer + (r & 3), size);
+
+				uint64_t ticks = ticks_now() - start_ticks;
+				double seconds = seconds_now() - start;
+
+				g_sink = sink;
+
+				if (seconds < best_seconds)
+					best_seconds = seconds;
+				if (ticks < best_ticks)
+					best_ticks = ticks;
+			}
+
+			double total_bytes = (double)size * repetitions;
+
+			char size_string[32];
+			format_size(size_string, sizeof(size_string), size);
+
+#ifdef VTBB_HAS_TSC
+			printf("%-12s %8s %10.3f %12.3f\n", g_hashes[h].name, size_string, total_bytes/best_seconds/1e9, best_ticks/total_bytes);
+#else
+			printf("%-12s %8s %10.3f %12s\n", g_hashes[h].name, size_string, total_bytes/best_seconds/1e9, "n/a");
+#endif
+		}
+	}
+}
+
+// Latency: each key's position depends on the previous hash, so hashes can't
+// overlap in the pipeline. This is the cost a hash table lookup sees.
+static void bench_latency(const unsigned char* buffer, size_t buffer_size)
+{
+	static const size_t key_sizes[] = { 4, 8, 16, 32, 64 };
+	static const int lookups = 4*1024*1024;
+
+	printf("\nSMALL KEY LATENCY\n");
+	printf("%-12s %8s %10s %12s\n", "hash", "key", "ns/hash", "cycles/hash");
+
+	for (size_t h = 0; h < VTBB_ARRAY_SIZE(g_hashes); h++)
+	{
+		for (size_t s = 0; s < VTBB_ARRAY_SIZE(key_sizes); s++)
+		{
+			size_t key_size = key_sizes[s];
+			size_t mask = 4096 - 1;
+			VTBH_ASSERT(buffer_size >= mask + key_size);
+
+			uint32_t hash = 0;
+
+			double start = seconds_now();
+			uint64_t start_ticks = ticks_now();
+
+			for (int k = 0; k < lookups; k++)
+				hash = g_hashes[h].function(buffer + (hash & mask), key_size);
+
+			uint64_t ticks = ticks_now() - start_ticks;
+			double seconds = seconds_now() - start;
+
+			g_sink = hash;
+
+#ifdef VTBB_HAS_TSC
+			printf("%-12s %7dB %10.2f %12.1f\n", g_hashes[h].name, (int)key_size, seconds*1e9/lookups, (double)ticks/lookups);
+#else
+			printf("%-12s %7dB %10.2f %12s\n", g_hashes[h].name, (int)key_size, seconds*1e9/lookups, "n/a");
+#endif
+		}
+	}
+}
+
+// A composite key, hashed one field at a time the C way and as one block
+// with vtb::hash.
+struct bench_key
+{
+	uint32_t a;
+	uint32_t b;
+	uint32_t c;
+	uint32_t d;
+};
+
+namespace vtb
+{
+	template <>
+	struct is_uniquely_represented<bench_key> : std::true_type
+	{
+	};
+}
+
+static void bench_struct_keys(const unsigned char* buffer, size_t buffer_size)
+{
+	static const int lookups = 4*1024*1024;
+
+	printf("\nSTRUCT KEYS (%d bytes)\n", (int)sizeof(bench_key));
+	printf("%-12s %10s\n", "hash", "ns/hash");
+
+	size_t mask = 4096 - 1;
+	VTBH_ASSERT(buffer_size >= mask + sizeof(bench_key));
+
+	for (int by_field = 1; by_field >= 0; by_field--)
+	{
+		uint32_t hash = 0;
+		double start = seconds_now();
+
+		for (int k = 0; k < lookups; k++)
+		{
+			bench_key key;
+			memcpy(&key, buffer + (hash & mask), sizeof(key));
+
+			if (by_field)
+			{
+				vtb_hash h = vtbh_new();
+				vtbh_int(&h, key.a);
+				vtbh_int(&h, key.b);
+				vtbh_int(&h, key.c);
+				vtbh_int(&h, key.d);
+				hash = h.hash;
+			}
+			else
+				hash = (uint32_t)vtb::hash<bench_key>()(key);
+		}
+
+		double seconds = seconds_now() - start;
+		g_sink = hash;
+
+		printf("%-12s %10.2f\n", by_field ? "vtbh_int x4" : "vtb::hash", seconds*1e9/lookups);
+	}
+}
+
+// Avalanche: flipping any single input bit should flip each output bit with
+// probability 1/2. Reports the worst and mean deviation from 1/2 over every
+// (input bit, output bit) pair. Anything above a few percent is a weak mix.
+static void quality_avalanche(hash_function function, size_t key_size, double* worst, double* mean)
+{
+	static const int samples = 20000;
+
+	int input_bits = (int)key_size*8;
+	int* flips = (int*)calloc(input_bits*32, sizeof(int));
+
+	unsigned char key[64];
+	VTBH_ASSERT(key_size <= sizeof(key));
+
+	for (int k = 0; k < samples; k++)
+	{
+		random_fill(key, key_size);
+		uint32_t base = function(key, key_size);
+
+		for (int bit = 0; bit < input_bits; bit++)
+		{
+			key[bit/8] ^= (unsigned char)(1 << (bit%8));
+			uint32_t diff = base ^ function(key, key_size);
+			key[bit/8] ^= (unsigned char)(1 << (bit%8));
+
+			for (int out = 0; out < 32; out++)
+				flips[bit*32 + out] += (diff >> out) & 1;
+		}
+	}
+
+	*worst = 0;
+	*mean = 0;
+
+	for (int k = 0; k < input_bits*32; k++)
+	{
+		double bias = fabs((double)flips[k]/samples - 0.5);
+		*worst = bias > *worst ? bias : *worst;
+		*mean += bias;
+	}
+
+	*mean /= input_bits*32;
+
+	free(flips);
+}
+
+// Bucket distribution: hash sequential keys into a power of two number of
+// buckets using the low bits, the way most hash tables do, and report
+// chi-squared divided by degrees of freedom. Values near 1.0 are uniform.
+static double quality_buckets(hash_function function, int sequential_text)
+{
+	static const int num_buckets = 64*1024;
+	static const int num_keys = 16*num_buckets;
+
+	int* buckets = (int*)calloc(num_buckets, sizeof(int));
+
+	for (int k = 0; k < num_keys; k++)
+	{
+		uint32_t hash;
+
+		if (sequential_text)
+		{
+			char key[32];
+			int length = snprintf(key, sizeof(key), "key%d", k);
+			hash = function((const unsigned char*)key, length);
+		}
+		else
+		{
+			uint32_t key = (uint32_t)k;
+			hash = function((const unsigned char*)&key, sizeof(key));
+		}
+
+		buckets[hash & (num_buckets-1)]++;
+	}
+
+	double expected = (double)num_keys/num_buckets;
+	double chi_squared = 0;
+	for (int k = 0; k < num_buckets; k++)
+	{
+		double diff = buckets[k] - expected;
+		chi_squared += diff*diff/expected;
+	}
+
+	free(buckets);
+
+	return chi_squared/(num_buckets-1);
+}
+
+static void bench_quality()
+{
+	printf("\nQUALITY\n");
+	printf("%-12s %14s %14s %14s %14s %14s\n", "hash", "aval4 worst", "aval16 worst", "aval16 mean", "chi2/df ints", "chi2/df text");
+
+	for (size_t h = 0; h < VTBB_ARRAY_SIZE(g_hashes); h++)
+	{
+		double worst4, mean4, worst16, mean16;
+		quality_avalanche(g_hashes[h].function, 4, &worst4, &mean4);
+		quality_avalanche(g_hashes[h].function, 16, &worst16, &mean16);
+
+		double ints = quality_buckets(g_hashes[h].function, 0);
+		double text = quality_buckets(g_hashes[h].function, 1);
+
+		printf("%-12s %14.4f %14.4f %14.4f %14.3f %14.3f\n", g_hashes[h].name, worst4, worst16, mean16, ints, text);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	size_t max_bytes = (size_t)1024*1024*1024;
+
+	if (argc > 1)
+		max_bytes = parse_size(argv[1]);
+
+	if (max_bytes < 4)
+		max_bytes = 4;
+
+	// A little extra so the throughput test can shift the start address
+	// and the latency test can index anywhere in its window.
+	size_t buffer_size = max_bytes + 4096 + 64;
+	unsigned char* buffer = (unsigned char*)malloc(buffer_size);
+	if (!buffer)
+	{
+		fprintf(stderr, "Couldn't allocate %zu bytes.\n", buffer_size);
+		return 1;
+	}
+
+	random_fill(buffer, buffer_size);
+
+	bench_throughput(buffer, max_bytes);
+	bench_latency(buffer, buffer_size);
+	bench_struct_keys(buffer, buffer_size);
+	bench_quality();
+
+	free(buffer);
+
+	return 0;
+}
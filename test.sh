@@ -18,6 +18,26 @@ CommonDebugCFlags="${CommonCFlags} -D_DEBUG"
 CommonReleaseCFlags="${CommonCFlags} -O2"
 
 
+# TEST VTB
+echo "testing vtb..."
+mkdir -p $ProjectOutputDir/o/vtb
+
+pushd $ProjectOutputDir/o/vtb > /dev/null
+
+clang $CommonInclude $CommonDebugCPPFlags $ProjectDir/tests/vtb.cpp -o $ProjectOutputDir/o/vtb_cpp $CommonLinkerFlags
+clang $CommonInclude $CommonDebugCPPFlags -DVTB_PROFILE_RDTSC $ProjectDir/tests/vtb.cpp -o $ProjectOutputDir/o/vtb_cpp_rdtsc $CommonLinkerFlags
+clang $CommonInclude $CommonReleaseCPPFlags -DVTB_DISABLE_ASSERTS -DVTB_ASSUME_ASSERTS $ProjectDir/tests/vtb.cpp -o $ProjectOutputDir/o/vtb_cpp_assume $CommonLinkerFlags
+
+echo "vtb_cpp..."
+$ProjectOutputDir/o/vtb_cpp || exit
+
+echo "vtb_cpp_rdtsc..."
+$ProjectOutputDir/o/vtb_cpp_rdtsc || exit
+
+echo "vtb_cpp_assume..."
+$ProjectOutputDir/o/vtb_cpp_assume || exit
+
+
 # TEST VTB_ALLOC_RING
 echo "testing vtb_alloc_ring..."
 mkdir -p $ProjectOutputDir/o/vtb_alloc_ring
@@ -38,6 +58,46 @@ echo "vtb_alloc_ring_cpp_nomalloc..."
 $ProjectOutputDir/o/vtb_alloc_ring_cpp_nomalloc || exit
 
 
+# TEST VTB_DIRTY
+echo "testing vtb_dirty..."
+mkdir -p $ProjectOutputDir/o/vtb_dirty
+
+pushd $ProjectOutputDir/o/vtb_dirty > /dev/null
+
+clang $CommonInclude $CommonDebugCFlags -D_POSIX_C_SOURCE=200809L $ProjectDir/tests/vtb_dirty.c -o $ProjectOutputDir/o/vtb_dirty_c $CommonLinkerFlags
+clang $CommonInclude $CommonDebugCPPFlags $ProjectDir/tests/vtb_dirty.cpp -o $ProjectOutputDir/o/vtb_dirty_cpp $CommonLinkerFlags
+clang $CommonInclude $CommonDebugCPPFlags -DVTBD_NO_MALLOC $ProjectDir/tests/vtb_dirty.cpp -o $ProjectOutputDir/o/vtb_dirty_cpp_nomalloc $CommonLinkerFlags
+
+echo "vtb_dirty_c..."
+$ProjectOutputDir/o/vtb_dirty_c || exit
+
+echo "vtb_dirty_cpp..."
+$ProjectOutputDir/o/vtb_dirty_cpp || exit
+
+echo "vtb_dirty_cpp_nomalloc..."
+$ProjectOutputDir/o/vtb_dirty_cpp_nomalloc || exit
+
+
+# TEST VTB_FILTER
+echo "testing vtb_filter..."
+mkdir -p $ProjectOutputDir/o/vtb_filter
+
+pushd $ProjectOutputDir/o/vtb_filter > /dev/null
+
+clang $CommonInclude $CommonDebugCFlags $ProjectDir/tests/vtb_filter.c -o $ProjectOutputDir/o/vtb_filter_c $CommonLinkerFlags
+clang $CommonInclude $CommonDebugCPPFlags $ProjectDir/tests/vtb_filter.cpp -o $ProjectOutputDir/o/vtb_filter_cpp $CommonLinkerFlags
+clang $CommonInclude $CommonDebugCPPFlags -mavx2 $ProjectDir/tests/vtb_filter.cpp -o $ProjectOutputDir/o/vtb_filter_cpp_avx2 $CommonLinkerFlags
+
+echo "vtb_filter_c..."
+$ProjectOutputDir/o/vtb_filter_c || exit
+
+echo "vtb_filter_cpp..."
+$ProjectOutputDir/o/vtb_filter_cpp || exit
+
+echo "vtb_filter_cpp_avx2..."
+$ProjectOutputDir/o/vtb_filter_cpp_avx2 || exit
+
+
 # TEST VTB_HASH
 echo "testing vtb_hash..."
 mkdir -p $ProjectOutputDir/o/vtb_hash
@@ -46,6 +106,9 @@ pushd $ProjectOutputDir/o/vtb_hash > /dev/null
 
 clang $CommonInclude $CommonDebugCFlags $ProjectDir/tests/vtb_hash.c -o $ProjectOutputDir/o/vtb_hash_c $CommonLinkerFlags
 clang $CommonInclude $CommonDebugCPPFlags $ProjectDir/tests/vtb_hash.cpp -o $ProjectOutputDir/o/vtb_hash_cpp $CommonLinkerFlags
+clang $CommonInclude $CommonDebugCPPFlags -DVTBH_NO_SIMD $ProjectDir/tests/vtb_hash.cpp -o $ProjectOutputDir/o/vtb_hash_cpp_nosimd $CommonLinkerFlags
+clang $CommonInclude $CommonDebugCPPFlags -mavx2 $ProjectDir/tests/vtb_hash.cpp -o $ProjectOutputDir/o/vtb_hash_cpp_avx2 $CommonLinkerFlags
+clang $CommonInclude $CommonDebugCPPFlags -DVTBH_CRC32C_NO_CLMUL $ProjectDir/tests/vtb_hash.cpp -o $ProjectOutputDir/o/vtb_hash_cpp_noclmul $CommonLinkerFlags
 
 echo "vtb_hash_c..."
 $ProjectOutputDir/o/vtb_hash_c || exit
@@ -53,6 +116,57 @@ $ProjectOutputDir/o/vtb_hash_c || exit
 echo "vtb_hash_cpp..."
 $ProjectOutputDir/o/vtb_hash_cpp || exit
 
+echo "vtb_hash_cpp_nosimd..."
+$ProjectOutputDir/o/vtb_hash_cpp_nosimd || exit
+
+echo "vtb_hash_cpp_avx2..."
+$ProjectOutputDir/o/vtb_hash_cpp_avx2 || exit
+
+echo "vtb_hash_cpp_noclmul..."
+$ProjectOutputDir/o/vtb_hash_cpp_noclmul || exit
+
+
+# TEST VTB_JOBS
+echo "testing vtb_jobs..."
+mkdir -p $ProjectOutputDir/o/vtb_jobs
+
+pushd $ProjectOutputDir/o/vtb_jobs > /dev/null
+
+clang $CommonInclude $CommonDebugCPPFlags $ProjectDir/tests/vtb_jobs.cpp -o $ProjectOutputDir/o/vtb_jobs_cpp $CommonLinkerFlags
+
+echo "vtb_jobs_cpp..."
+$ProjectOutputDir/o/vtb_jobs_cpp || exit
+
+
+# TEST VTB_LOG
+echo "testing vtb_log..."
+mkdir -p $ProjectOutputDir/o/vtb_log
+
+pushd $ProjectOutputDir/o/vtb_log > /dev/null
+
+clang $CommonInclude $CommonDebugCPPFlags $ProjectDir/tests/vtb_log.cpp -o $ProjectOutputDir/o/vtb_log_cpp $CommonLinkerFlags
+
+echo "vtb_log_cpp..."
+$ProjectOutputDir/o/vtb_log_cpp || exit
+
+
+# TEST VTB_TRACE
+echo "testing vtb_trace..."
+mkdir -p $ProjectOutputDir/o/vtb_trace
+
+pushd $ProjectOutputDir/o/vtb_trace > /dev/null
+
+clang $CommonInclude $CommonDebugCPPFlags $ProjectDir/tests/vtb_trace.cpp -o $ProjectOutputDir/o/vtb_trace_cpp $CommonLinkerFlags
+clang $CommonInclude $CommonDebugCPPFlags $ProjectDir/tools/vtb_trace_decode.cpp -o $ProjectOutputDir/o/vtb_trace_decode $CommonLinkerFlags
+
+echo "vtb_trace_cpp..."
+$ProjectOutputDir/o/vtb_trace_cpp || exit
+
+# The test leaves vtb_trace_test.vtbt behind for the decoder.
+echo "vtb_trace_decode..."
+$ProjectOutputDir/o/vtb_trace_decode vtb_trace_test.vtbt > vtb_trace_test.json || exit
+$ProjectOutputDir/o/vtb_trace_decode -s vtb_trace_test.vtbt > /dev/null || exit
+
 
 popd > /dev/null
 
@@ -0,0 +1,428 @@
+#define VTB_IMPLEMENTATION
+#include "../vtb.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <thread>
+
+const char* g_test;
+int g_line;
+
+static void catch_sigbus(int signal)
+{
+    printf("Bus error during test '%s' after line %d\n", g_test, g_line);
+    exit(1);
+}
+
+static void catch_sigfpe(int signal)
+{
+    printf("Floating point exception during test '%s' after line %d\n", g_test, g_line);
+    exit(1);
+}
+
+static void catch_sigill(int signal)
+{
+    printf("Illegal instruction during test '%s' after line %d\n", g_test, g_line);
+    exit(1);
+}
+
+static void catch_sigsegv(int signal)
+{
+    printf("Segfault during test '%s' after line %d\n", g_test, g_line);
+    exit(1);
+}
+
+#define TEST(x) g_line = __LINE__; { if (!(x)) { printf("Test '" #x "' on line %d during '%s' failed.\n", __LINE__, g_test); return 1; } }
+
+static char g_printed[256];
+static int g_flushed;
+
+static void capture_print(const char* text)
+{
+	strncat(g_printed, text, sizeof(g_printed) - strlen(g_printed) - 1);
+}
+
+static void capture_flush()
+{
+	g_flushed++;
+}
+
+static int count_occurrences(const char* haystack, const char* needle)
+{
+	int count = 0;
+	for (const char* s = strstr(haystack, needle); s; s = strstr(s + 1, needle))
+		count++;
+	return count;
+}
+
+// Exports the chrome trace into a string so the tests can look at it.
+static char* export_trace()
+{
+	FILE* file = tmpfile();
+	vtb_profile_write_chrome_trace(file);
+
+	long size = ftell(file);
+	rewind(file);
+
+	char* trace = (char*)malloc(size + 1);
+	trace[fread(trace, 1, size, file)] = '\0';
+	fclose(file);
+
+	return trace;
+}
+
+struct counted
+{
+	counted() { s_alive++; }
+	~counted() { s_alive--; }
+	static int s_alive;
+	int m_value;
+};
+
+int counted::s_alive = 0;
+
+template <typename T, size_t N>
+static bool is_inline(VScratchBuffer<T, N>& buffer)
+{
+	return (unsigned char*)buffer.data() >= (unsigned char*)&buffer && (unsigned char*)buffer.data() < (unsigned char*)(&buffer + 1);
+}
+
+// The fallbacks after VCheck and VUntested have to survive
+// VTB_ASSUME_ASSERTS, only VAssert is assumed.
+static int checked_parameter(int value)
+{
+	VCheck(value != 3);
+	return value == 3 ? -1 : 0;
+}
+
+static int untested_branch(int value)
+{
+	if (value == 3)
+	{
+		VUntested();
+		return -1;
+	}
+
+	return 0;
+}
+
+static void profiled_work(int depth)
+{
+	VProfileZone("profiled_work");
+
+	if (depth > 0)
+		profiled_work(depth - 1);
+}
+
+int main()
+{
+	if (signal(SIGBUS, catch_sigbus) == SIG_ERR ||
+		signal(SIGFPE, catch_sigfpe) == SIG_ERR ||
+		signal(SIGILL, catch_sigill) == SIG_ERR ||
+		signal(SIGSEGV, catch_sigsegv) == SIG_ERR)
+	{
+		fputs("An error occurred while setting a signal handler.\n", stderr);
+		return 1;
+	}
+
+	char* trace;
+
+	g_test = "Asserts";
+
+	{
+		// The condition is evaluated exactly once in every assert mode.
+		int evaluated = 0;
+		VAssert(++evaluated == 1);
+		VCheck(++evaluated == 2);
+		VAssume(++evaluated == 3);
+		TEST(evaluated == 3);
+
+		TEST(VLikely(evaluated == 3));
+		TEST(!VUnlikely(evaluated != 3));
+
+#ifdef VTB_DISABLE_ASSERTS
+		TEST(checked_parameter(evaluated) == -1);
+		TEST(untested_branch(evaluated) == -1);
+#endif
+	}
+
+	g_test = "Debug print hook";
+
+	{
+		vtb_set_debug_print(capture_print, capture_flush);
+		vtb_debug_print("one ");
+		vtb_debug_print("two");
+		vtb_debug_flush();
+		TEST(strcmp(g_printed, "one two") == 0);
+		TEST(g_flushed == 1);
+
+		vtb_set_debug_print(0, 0);
+		vtb_debug_flush();
+		TEST(g_flushed == 1);
+	}
+
+	g_test = "Scratch buffer inline";
+
+	{
+		VScratchBuffer<int, 16> small(16);
+		TEST(small.size() == 16);
+		TEST(is_inline(small));
+		TEST(vtb_scratch_arena_used() == 0);
+
+		for (int k = 0; k < 16; k++)
+			small[k] = k;
+		TEST(small.data()[15] == 15);
+	}
+
+	g_test = "Scratch buffer arena";
+
+	{
+		VScratchBuffer<int, 16> outer(17);
+		TEST(!is_inline(outer));
+		TEST(vtb_scratch_arena_used() == 17*sizeof(int));
+
+		{
+			VScratchBuffer<double, 1> inner(3);
+			TEST(((size_t)inner.data() & (alignof(double) - 1)) == 0);
+			TEST(vtb_scratch_arena_used() >= 17*sizeof(int) + 3*sizeof(double));
+
+			for (int k = 0; k < 3; k++)
+				inner[k] = k;
+			for (int k = 0; k < 17; k++)
+				outer[k] = -k;
+			TEST(inner[2] == 2 && outer[16] == -16);
+		}
+
+		TEST(vtb_scratch_arena_used() == 17*sizeof(int));
+	}
+
+	TEST(vtb_scratch_arena_used() == 0);
+
+	g_test = "Scratch buffer heap";
+
+	{
+		VScratchBuffer<char, 16> arena_full(VTB_SCRATCH_ARENA_SIZE);
+		TEST(vtb_scratch_arena_used() == VTB_SCRATCH_ARENA_SIZE);
+
+		VScratchBuffer<char, 16> heap(100);
+		TEST(!is_inline(heap));
+		TEST(vtb_scratch_arena_used() == VTB_SCRATCH_ARENA_SIZE);
+		memset(heap.data(), 1, 100);
+
+		VScratchBuffer<char, 16> huge(VTB_SCRATCH_ARENA_SIZE*2);
+		memset(huge.data(), 1, VTB_SCRATCH_ARENA_SIZE*2);
+	}
+
+	TEST(vtb_scratch_arena_used() == 0);
+
+	g_test = "Scratch buffer construction";
+
+	{
+		VScratchBuffer<counted, 4> a(4);
+		TEST(counted::s_alive == 4);
+
+		VScratchBuffer<counted, 4> b(100);
+		TEST(counted::s_alive == 104);
+	}
+
+	TEST(counted::s_alive == 0);
+
+	g_test = "Scratch allocate";
+
+	{
+		VScratchAllocate(int, numbers, 10);
+		VScratchAllocate(int, more_numbers, 100000);
+		numbers[9] = 9;
+		more_numbers[99999] = 99999;
+		TEST(numbers[9] + more_numbers[99999] == 100008);
+		TEST(vtb_scratch_arena_used() == 100000*sizeof(int));
+	}
+
+	g_test = "Profile zones";
+
+	{
+		VProfileZone("outer");
+		profiled_work(2);
+	}
+
+	trace = export_trace();
+	TEST(strncmp(trace, "{\"traceEvents\":[", 16) == 0);
+	TEST(count_occurrences(trace, "\"name\":\"outer\"") == 1);
+	TEST(count_occurrences(trace, "\"name\":\"profiled_work\"") == 3);
+	TEST(count_occurrences(trace, "\"ph\":\"X\"") == 4);
+	free(trace);
+
+	g_test = "Profile zone escaping";
+
+	{
+		VProfileZone("quote\"back\\slash");
+	}
+
+	trace = export_trace();
+	TEST(count_occurrences(trace, "\"name\":\"quote\\\"back\\\\slash\"") == 1);
+	free(trace);
+
+	g_test = "Profile reset";
+
+	vtb_profile_reset();
+
+	trace = export_trace();
+	TEST(count_occurrences(trace, "\"ph\":\"X\"") == 0);
+	free(trace);
+
+	g_test = "Profile ring wraps";
+
+	for (int k = 0; k < VTB_PROFILE_MAX_EVENTS + 10; k++)
+	{
+		VProfileZone("wrap");
+	}
+
+	trace = export_trace();
+	TEST(count_occurrences(trace, "\"name\":\"wrap\"") == VTB_PROFILE_MAX_EVENTS);
+	free(trace);
+
+	vtb_profile_reset();
+
+	g_test = "Profile threads";
+
+	std::thread worker1([]() { VProfileZone("worker"); });
+	std::thread worker2([]() { VProfileZone("worker"); });
+	worker1.join();
+	worker2.join();
+
+	{
+		VProfileZone("main");
+	}
+
+	trace = export_trace();
+	TEST(count_occurrences(trace, "\"name\":\"worker\"") == 2);
+	TEST(count_occurrences(trace, "\"name\":\"main\"") == 1);
+	TEST(count_occurrences(trace, "\"tid\":1,") >= 1);
+	TEST(count_occurrences(trace, "\"tid\":2,") == 1);
+	TEST(count_occurrences(trace, "\"tid\":3,") == 1);
+	free(trace);
+
+	g_test = "Profile exited threads";
+
+	// Reset frees the rings of threads that are gone and keeps the rest.
+	for (int k = 0; k < 16; k++)
+	{
+		std::thread worker([]() { VProfileZone("short lived"); });
+		worker.join();
+	}
+
+	vtb_profile_reset();
+
+	{
+		VProfileZone("main");
+	}
+
+	trace = export_trace();
+	TEST(count_occurrences(trace, "\"ph\":\"X\"") == 1);
+	TEST(count_occurrences(trace, "\"tid\":1,") == 1);
+	free(trace);
+
+	g_test = "Counters";
+
+	TEST(vtb_counter_read("counted") == 0);
+
+	for (int k = 0; k < 10; k++)
+		VCounter("counted", 1);
+
+	VCounter("counted", 5); // A second call site with the same name
+
+	TEST(vtb_counter_read("counted") == 15);
+
+	{
+		std::thread threads[VTB_METRIC_SHARDS + 3];
+		for (int k = 0; k < (int)VArraySize(threads); k++)
+			threads[k] = std::thread([]() { for (int j = 0; j < 1000; j++) VCounter("threaded", 1); });
+		for (int k = 0; k < (int)VArraySize(threads); k++)
+			threads[k].join();
+
+		TEST(vtb_counter_read("threaded") == 1000 * VArraySize(threads));
+	}
+
+	g_test = "Histogram buckets";
+
+	for (uint64_t v = 0; v < 100000; v++)
+	{
+		uint64_t top = vtb_histogram_bucket_value(vtb_histogram_bucket(v));
+		TEST(top >= v);
+		TEST(top - v <= v >> VTB_HISTOGRAM_SUB_BUCKET_BITS);
+		TEST(vtb_histogram_bucket(v) <= vtb_histogram_bucket(v + 1));
+	}
+
+	TEST(vtb_histogram_bucket(~(uint64_t)0) == VTB_HISTOGRAM_BUCKETS - 1);
+	TEST(vtb_histogram_bucket_value(VTB_HISTOGRAM_BUCKETS - 1) == ~(uint64_t)0);
+
+	g_test = "Histograms";
+
+	TEST(vtb_histogram_count("latency") == 0);
+	TEST(vtb_histogram_percentile("latency", 50) == 0);
+
+	for (int k = 1; k <= 1000; k++)
+		VHistogram("latency", k);
+
+	TEST(vtb_histogram_count("latency") == 1000);
+	TEST(vtb_histogram_mean("latency") == 500.5);
+	TEST(vtb_histogram_percentile("latency", 50) >= 500 && vtb_histogram_percentile("latency", 50) <= 500 + 500/8);
+	TEST(vtb_histogram_percentile("latency", 99) >= 990 && vtb_histogram_percentile("latency", 99) <= 990 + 990/8);
+	TEST(vtb_histogram_percentile("latency", 100) >= 1000 && vtb_histogram_percentile("latency", 100) <= 1000 + 1000/8);
+	TEST(vtb_histogram_percentile("latency", 0) == 1);
+
+	g_test = "Metrics reset";
+
+	vtb_metrics_reset();
+	TEST(vtb_counter_read("counted") == 0);
+	TEST(vtb_histogram_count("latency") == 0);
+
+	g_test = "Bits";
+
+	// All of them work at compile time.
+	static_assert(VClz((uint8_t)1) == 7 && VClz((uint16_t)1) == 15 && VClz(1u) == 31 && VClz((uint64_t)1) == 63, "VClz");
+	static_assert(VCtz((uint64_t)1 << 40) == 40 && VCtz((int8_t)-128) == 7, "VCtz");
+	static_assert(VPopCount((int8_t)-1) == 8 && VPopCount(~(uint64_t)0) == 64, "VPopCount");
+	static_assert(VLog2(1) == 0 && VLog2(1000) == 9 && VLog2((uint64_t)1 << 50) == 50, "VLog2");
+	static_assert(VIsPo2(64) && !VIsPo2(0) && !VIsPo2(96) && !VIsPo2(-64), "VIsPo2");
+	static_assert(VPo2(0) == 0 && VPo2(1) == 1 && VPo2(3) == 4 && VPo2(1024) == 1024 && VPo2(1025) == 2048, "VPo2");
+	static_assert(VPo2(((uint64_t)1 << 40) + 1) == (uint64_t)1 << 41 && VPo2(((uint64_t)1 << 63) + 1) == 0, "VPo2 64 bit");
+	static_assert(VAlignPo2(13, 8) == 16 && VAlignPo2(16, 8) == 16 && VAlignPo2(0, 8) == 0, "VAlignPo2");
+	static_assert(VAlign(13, 8) == 16 && VAlign(13, 12) == 24 && VAlign(24, 12) == 24, "VAlign");
+
+	{
+		// Against the obvious loops, at run time. volatile keeps the
+		// compiler from folding them.
+		bool same = true;
+		for (volatile uint64_t k = 1; k < ((uint64_t)1 << 62); k = k*3 + 1)
+		{
+			uint64_t x = k;
+
+			int log2 = 0;
+			while (x >> (log2 + 1))
+				log2++;
+
+			int popcount = 0;
+			for (uint64_t y = x; y; y >>= 1)
+				popcount += y & 1;
+
+			uint64_t po2 = 1;
+			while (po2 < x)
+				po2 <<= 1;
+
+			same = same && VLog2(x) == log2 && VClz(x) == 63 - log2;
+			same = same && VPopCount(x) == popcount;
+			same = same && VPo2(x) == po2 && VIsPo2(x) == (po2 == x);
+			same = same && VCtz(x << 5) == VCtz(x) + 5;
+			same = same && VAlign(x, (uint64_t)64) == VAlignPo2(x, (uint64_t)64) && VAlign(x, (uint64_t)64) % 64 == 0;
+			same = same && VAlign(x, (uint64_t)48) % 48 == 0 && VAlign(x, (uint64_t)48) - x < 48;
+
+			uint32_t low = (uint32_t)x;
+			same = same && (!low || VLog2(low) == 31 - VClz(low));
+		}
+		TEST(same);
+	}
+
+	return 0;
+}
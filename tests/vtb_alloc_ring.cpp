@@ -4,6 +4,11 @@
 
 #include <stdio.h>
 #include <string.h>
+#include <memory>
+#include <string>
+#include <atomic>
+#include <thread>
+#include <vector>
 
 const char* g_test;
 int g_line;
@@ -32,8 +37,104 @@ static void catch_sigsegv(int signal)
     exit(1);
 }
 
+static int g_constructed;
+static int g_destroyed;
+
+struct tracked
+{
+	int m_value;
+
+	tracked(int value)
+		: m_value(value)
+	{
+		g_constructed++;
+	}
+
+	~tracked()
+	{
+		g_destroyed++;
+	}
+};
+
+struct thrower
+{
+	thrower()
+	{
+		throw 1;
+	}
+};
+
 #define TEST(x) g_line = __LINE__; { if (!(x)) { printf("Test '" #x "' on line %d during '%s' failed.\n", __LINE__, g_test); return 1; } }
 
+// Remembers the first int of every section it's handed.
+struct drained
+{
+	int m_values[64];
+	int m_count;
+	vtb_ring_allocator* m_refill; // If set, allocs one more section the first time.
+};
+
+static void drain_section(void* data, void* start, int32_t length)
+{
+	drained* d = (drained*)data;
+	d->m_values[d->m_count++] = *(int*)start;
+
+	if (d->m_refill)
+	{
+		*(int*)vtbar_alloc(d->m_refill, sizeof(int)) = 100;
+		d->m_refill = 0;
+	}
+}
+
+// Records vtbar_setwatermarks events.
+struct pressure
+{
+	int m_events[16];
+	int32_t m_sizes[16];
+	int m_count;
+	vtb_ring_allocator* m_shed; // If set, frees the tail on every high event.
+};
+
+static void record_pressure(void* data, int event, int32_t size_allocations)
+{
+	pressure* p = (pressure*)data;
+	p->m_events[p->m_count] = event;
+	p->m_sizes[p->m_count++] = size_allocations;
+
+	if (p->m_shed && event == VTBAR_EVENT_HIGH)
+		vtbar_freetail(p->m_shed, 0, 0);
+}
+
+// Claims sections from r until done is set and there's nothing left,
+// holding two at a time and releasing them newest first.
+static void claim_sections(vtb_claim_ring* r, std::atomic<bool>* done, std::vector<int>* values)
+{
+	vtb_claim held[2];
+	int num_held = 0;
+
+	for (;;)
+	{
+		bool finished = done->load();
+		if (vtbar_claim_next(r, &held[num_held]))
+		{
+			values->push_back(*(int*)held[num_held].start);
+			if (++num_held == 2)
+			{
+				vtbar_claim_release(r, &held[1]);
+				vtbar_claim_release(r, &held[0]);
+				num_held = 0;
+			}
+		}
+		else if (finished)
+			break;
+		else
+			std::this_thread::yield();
+	}
+
+	if (num_held)
+		vtbar_claim_release(r, &held[0]);
+}
+
 int main()
 {
 	if (signal(SIGBUS, catch_sigbus) == SIG_ERR ||
@@ -380,6 +481,562 @@ int main()
 	vtbar_destroy(&a);
 #endif
 
+	g_test = "Realloc head";
+	vtbar_initialize(&a, m, sizeof(m));
+	{
+		int header = vtbar_getheadersize();
+
+		char* first = (char*)vtbar_alloc(&a, 16);
+		strcpy(first, test_string1);
+
+		// Serialize into the most we might need, then give the rest back.
+		char* second = (char*)vtbar_alloc(&a, 512);
+		strcpy(second, test_string2);
+		TEST(vtbar_realloc_head(&a, second, 13) == second);
+		TEST(vtbar_getsizeallocations(&a) == 16 + 16 + 2*header);
+
+		// The next allocation goes right after the shrunk one.
+		char* third = (char*)vtbar_alloc(&a, 8);
+		TEST(third == second + 16 + header);
+
+		// Grow up to the end of memory, but no further.
+		int32_t room = (int32_t)sizeof(m) - (int32_t)(third - m);
+		TEST(vtbar_realloc_head(&a, third, room) == third);
+		TEST(vtbar_getsizeallocations(&a) == 16 + 16 + room + 3*header);
+		TEST(!vtbar_realloc_head(&a, third, room + 8));
+		TEST(vtbar_getsizeallocations(&a) == 16 + 16 + room + 3*header);
+		TEST(!vtbar_alloc(&a, 8));
+
+		TEST(vtbar_realloc_head(&a, third, 8) == third);
+
+		vtbar_freetail(&a, &memory, &length);
+		TEST(memory == first && length == 16);
+		vtbar_freetail(&a, &memory, &length);
+		TEST(memory == second && length == 16 && strcmp(second, test_string2) == 0);
+
+		// Wrap around behind the tail, where growing stops at the tail.
+		vtbar_realloc_head(&a, third, (int32_t)sizeof(m) - (int32_t)(third - m));
+		char* wrapped = (char*)vtbar_alloc(&a, 8);
+		TEST(wrapped == m + header);
+		int32_t before_tail = (int32_t)(third - header - wrapped);
+		TEST(vtbar_realloc_head(&a, wrapped, before_tail) == wrapped);
+		TEST(!vtbar_realloc_head(&a, wrapped, before_tail + 8));
+
+		vtbar_freetail(&a, &memory, &length);
+		TEST(memory == third);
+		vtbar_freetail(&a, &memory, &length);
+		TEST(memory == wrapped && length == before_tail);
+		TEST(vtbar_isempty(&a));
+		TEST(vtbar_getsizeallocations(&a) == 0);
+	}
+	vtbar_destroy(&a);
+
+	g_test = "Free out of order";
+	vtbar_initialize(&a, m, sizeof(m));
+	{
+		int header = vtbar_getheadersize();
+
+		void* p[5];
+		for (int k = 0; k < 5; k++)
+			p[k] = vtbar_alloc(&a, 16);
+
+		// Freeing behind a live tail only marks the section dead.
+		vtbar_free(&a, p[1]);
+		vtbar_free(&a, p[3]);
+		TEST(vtbar_getnumallocations(&a) == 3);
+		TEST(vtbar_getsizeallocations(&a) == 3*(16 + header));
+		TEST(vtbar_getnumdead(&a) == 2);
+		TEST(vtbar_getsizedead(&a) == 2*(16 + header));
+
+		vtbar_peektail(&a, &memory, &length);
+		TEST(memory == p[0] && length == 16);
+
+		// Freeing the tail skips the dead run behind it.
+		vtbar_free(&a, p[0]);
+		vtbar_peektail(&a, &memory, &length);
+		TEST(memory == p[2] && length == 16);
+		TEST(vtbar_getnumdead(&a) == 1);
+
+		vtbar_freetail(&a, &memory, &length);
+		TEST(memory == p[2]);
+		vtbar_peektail(&a, &memory, &length);
+		TEST(memory == p[4]);
+		TEST(vtbar_getnumdead(&a) == 0 && vtbar_getsizedead(&a) == 0);
+
+		// A dead head still takes up room, the next section goes after it.
+		void* q = vtbar_alloc(&a, 8);
+		vtbar_free(&a, q);
+		TEST(vtbar_getnumdead(&a) == 1);
+		void* r = vtbar_alloc(&a, 8);
+		TEST((char*)r == (char*)q + 8 + header);
+
+		// Everything dead at once leaves the ring empty.
+		vtbar_free(&a, r);
+		vtbar_free(&a, p[4]);
+		TEST(vtbar_isempty(&a));
+		TEST(vtbar_getnumallocations(&a) == 0 && vtbar_getsizeallocations(&a) == 0);
+		TEST(vtbar_getnumdead(&a) == 0 && vtbar_getsizedead(&a) == 0);
+
+		// Dead sections are reclaimed across the wrap.
+		int32_t big = ((int32_t)sizeof(m) - 4*header)/4;
+		big -= big % (int32_t)sizeof(size_t);
+		void* w[4];
+		for (int k = 0; k < 4; k++)
+			w[k] = vtbar_alloc(&a, big);
+		TEST(!vtbar_alloc(&a, big));
+		vtbar_free(&a, w[2]);
+		vtbar_free(&a, w[1]);
+		TEST(!vtbar_alloc(&a, big));
+		vtbar_free(&a, w[0]);
+		vtbar_peektail(&a, &memory, &length);
+		TEST(memory == w[3]);
+		void* wrapped = vtbar_alloc(&a, big);
+		TEST(wrapped == w[0]);
+		vtbar_free(&a, wrapped);
+		vtbar_free(&a, w[3]);
+		TEST(vtbar_isempty(&a));
+	}
+	vtbar_destroy(&a);
+
+	g_test = "Drain";
+	vtbar_initialize(&a, m, sizeof(m));
+	{
+		int header = vtbar_getheadersize();
+		drained d;
+		memset(&d, 0, sizeof(d));
+
+		TEST(vtbar_drain(&a, drain_section, &d, 0) == 0);
+
+		void* p[8];
+		for (int k = 0; k < 8; k++)
+			*(int*)(p[k] = vtbar_alloc(&a, 24)) = k;
+
+		// Dead sections are skipped, and max stops early.
+		vtbar_free(&a, p[2]);
+		vtbar_free(&a, p[3]);
+		TEST(vtbar_drain(&a, drain_section, &d, 3) == 3);
+		TEST(d.m_count == 3 && d.m_values[0] == 0 && d.m_values[1] == 1 && d.m_values[2] == 4);
+		TEST(vtbar_getnumallocations(&a) == 3);
+		TEST(vtbar_getsizeallocations(&a) == 3*(24 + header));
+		TEST(vtbar_getnumdead(&a) == 0 && vtbar_getsizedead(&a) == 0);
+		vtbar_peektail(&a, &memory, &length);
+		TEST(memory == p[5]);
+
+		// The callback can alloc, and what it allocs gets drained too.
+		vtbar_free(&a, p[7]);
+		d.m_refill = &a;
+		TEST(vtbar_drain(&a, drain_section, &d, 0) == 3);
+		TEST(d.m_count == 6 && d.m_values[3] == 5 && d.m_values[4] == 6 && d.m_values[5] == 100);
+		TEST(vtbar_isempty(&a));
+		TEST(vtbar_getnumallocations(&a) == 0 && vtbar_getsizeallocations(&a) == 0);
+		TEST(vtbar_getnumdead(&a) == 0 && vtbar_getsizedead(&a) == 0);
+
+		// Across the wrap.
+		d.m_count = 0;
+		int32_t big = ((int32_t)sizeof(m) - 4*header)/4;
+		big -= big % (int32_t)sizeof(size_t);
+		for (int k = 0; k < 4; k++)
+			*(int*)(p[k] = vtbar_alloc(&a, big)) = k;
+		TEST(vtbar_drain(&a, drain_section, &d, 2) == 2);
+		*(int*)(p[4] = vtbar_alloc(&a, big)) = 4;
+		TEST(p[4] == p[0]);
+		TEST(vtbar_drain(&a, drain_section, &d, 0) == 3);
+		TEST(d.m_count == 5 && d.m_values[2] == 2 && d.m_values[3] == 3 && d.m_values[4] == 4);
+		TEST(vtbar_isempty(&a));
+	}
+	vtbar_destroy(&a);
+
+	g_test = "Watermarks";
+	vtbar_initialize(&a, m, sizeof(m));
+	{
+		int32_t section = 24 + vtbar_getheadersize();
+		pressure pr;
+		memset(&pr, 0, sizeof(pr));
+
+		void* p[64];
+		int n = 0;
+
+		vtbar_setwatermarks(&a, 6*section, 2*section, record_pressure, &pr);
+		TEST(!vtbar_isabovewatermark(&a));
+
+		// High fires once on reaching it, not again above it.
+		while (n < 5)
+			p[n++] = vtbar_alloc(&a, 24);
+		TEST(pr.m_count == 0);
+		p[n++] = vtbar_alloc(&a, 24);
+		TEST(pr.m_count == 1 && pr.m_events[0] == VTBAR_EVENT_HIGH && pr.m_sizes[0] == 6*section);
+		TEST(vtbar_isabovewatermark(&a));
+		p[n++] = vtbar_alloc(&a, 24);
+		TEST(pr.m_count == 1);
+
+		// Hovering between the marks doesn't fire anything.
+		for (int k = 0; k < 4; k++)
+			vtbar_freetail(&a, 0, 0);
+		TEST(vtbar_getsizeallocations(&a) == 3*section);
+		p[n++] = vtbar_alloc(&a, 24);
+		p[n++] = vtbar_alloc(&a, 24);
+		vtbar_freetail(&a, 0, 0);
+		vtbar_freetail(&a, 0, 0);
+		TEST(pr.m_count == 1 && vtbar_isabovewatermark(&a));
+
+		// Low fires on getting back down to it, out of order frees count.
+		vtbar_free(&a, p[8]);
+		TEST(pr.m_count == 2 && pr.m_events[1] == VTBAR_EVENT_LOW && pr.m_sizes[1] == 2*section);
+		TEST(!vtbar_isabovewatermark(&a));
+		vtbar_freetail(&a, 0, 0);
+		TEST(pr.m_count == 2);
+
+		// Drain and resizing the head count too.
+		drained d;
+		memset(&d, 0, sizeof(d));
+		while (vtbar_getsizeallocations(&a) + section <= 6*section)
+			vtbar_alloc(&a, 24);
+		TEST(pr.m_count == 3 && pr.m_events[2] == VTBAR_EVENT_HIGH);
+		vtbar_drain(&a, drain_section, &d, 0);
+		TEST(pr.m_count == 4 && pr.m_events[3] == VTBAR_EVENT_LOW && pr.m_sizes[3] == 0);
+		void* head = vtbar_alloc(&a, 24);
+		TEST(vtbar_realloc_head(&a, head, 6*section) == head);
+		TEST(pr.m_count == 5 && pr.m_events[4] == VTBAR_EVENT_HIGH);
+		TEST(vtbar_realloc_head(&a, head, 8) == head);
+		TEST(pr.m_count == 6 && pr.m_events[5] == VTBAR_EVENT_LOW);
+		vtbar_freetail(&a, 0, 0);
+
+		// Full fires on every failed alloc, and doesn't change the state.
+		pr.m_count = 0;
+		while (vtbar_alloc(&a, 24))
+			{}
+		TEST(pr.m_count == 2 && pr.m_events[0] == VTBAR_EVENT_HIGH && pr.m_events[1] == VTBAR_EVENT_FULL);
+		TEST(!vtbar_alloc(&a, 24));
+		TEST(pr.m_count == 3 && pr.m_events[2] == VTBAR_EVENT_FULL);
+		TEST(vtbar_isabovewatermark(&a));
+
+		// Turning them off stops the events. Turning them on while over
+		// the high mark fires right away.
+		vtbar_setwatermarks(&a, 0, 0, 0, 0);
+		TEST(!vtbar_isabovewatermark(&a));
+		TEST(!vtbar_alloc(&a, 24));
+		TEST(pr.m_count == 3);
+		vtbar_setwatermarks(&a, 6*section, 2*section, record_pressure, &pr);
+		TEST(pr.m_count == 4 && pr.m_events[3] == VTBAR_EVENT_HIGH);
+
+		// Polling without a function.
+		vtbar_setwatermarks(&a, 6*section, 2*section, 0, 0);
+		TEST(vtbar_isabovewatermark(&a));
+		vtbar_drain(&a, drain_section, &d, 0);
+		TEST(!vtbar_isabovewatermark(&a));
+		TEST(pr.m_count == 4);
+
+		// An alloc from a drain function can reach the high mark. The
+		// pressure function can't free then, and the counts come out right.
+		pr.m_count = 0;
+		vtbar_setwatermarks(&a, 2*section + 1, section, record_pressure, &pr);
+		for (int k = 0; k < 2; k++)
+			*(int*)vtbar_alloc(&a, 24) = k;
+		TEST(pr.m_count == 0);
+		d.m_count = 0;
+		d.m_refill = &a;
+		TEST(vtbar_drain(&a, drain_section, &d, 0) == 3);
+		TEST(d.m_count == 3 && d.m_values[0] == 0 && d.m_values[1] == 1 && d.m_values[2] == 100);
+		TEST(pr.m_count == 2 && pr.m_events[0] == VTBAR_EVENT_HIGH && pr.m_events[1] == VTBAR_EVENT_LOW);
+		TEST(pr.m_sizes[0] > 2*section && pr.m_sizes[1] == 0);
+		TEST(vtbar_isempty(&a) && vtbar_getnumallocations(&a) == 0 && vtbar_getsizeallocations(&a) == 0);
+
+		// Outside of a drain the function can free, shedding load as it goes.
+		pr.m_count = 0;
+		pr.m_shed = &a;
+		vtbar_setwatermarks(&a, 6*section, 5*section, record_pressure, &pr);
+		for (int k = 0; k < 10; k++)
+			vtbar_alloc(&a, 24);
+		TEST(vtbar_getsizeallocations(&a) == 5*section);
+		TEST(pr.m_count == 10 && pr.m_events[0] == VTBAR_EVENT_HIGH && pr.m_events[1] == VTBAR_EVENT_LOW);
+	}
+	vtbar_destroy(&a);
+
+	g_test = "Claim ring";
+	{
+		size_t claim_memory[64];
+		vtb_claim_ring r;
+		vtbar_claim_initialize(&r, claim_memory, sizeof(claim_memory), 4);
+
+		vtb_claim c[5];
+		TEST(!vtbar_claim_next(&r, &c[0]));
+
+		// Nothing can be claimed until it's published.
+		*(int*)vtbar_claim_alloc(&r, sizeof(int)) = 0;
+		TEST(!vtbar_claim_next(&r, &c[0]));
+		vtbar_claim_publish(&r);
+
+		for (int k = 1; k < 4; k++)
+		{
+			*(int*)vtbar_claim_alloc(&r, 12) = k;
+			vtbar_claim_publish(&r);
+		}
+
+		// The table only holds 4.
+		TEST(!vtbar_claim_alloc(&r, sizeof(int)));
+
+		// Claimed in order.
+		for (int k = 0; k < 4; k++)
+		{
+			TEST(vtbar_claim_next(&r, &c[k]));
+			TEST(c[k].sequence == k && *(int*)c[k].start == k);
+		}
+		TEST(c[0].length == 8 && c[1].length == 16);
+		TEST(!vtbar_claim_next(&r, &c[4]));
+
+		// Memory comes back only up to the oldest one still claimed.
+		vtbar_claim_release(&r, &c[1]);
+		vtbar_claim_release(&r, &c[3]);
+		TEST(vtbar_claim_reclaim(&r) == 4);
+		vtbar_claim_release(&r, &c[0]);
+		TEST(vtbar_claim_reclaim(&r) == 2);
+		void* reused = vtbar_claim_alloc(&r, sizeof(int));
+		TEST(reused);
+		*(int*)reused = 4;
+		vtbar_claim_publish(&r);
+		vtbar_claim_release(&r, &c[2]);
+		TEST(vtbar_claim_reclaim(&r) == 1);
+
+		TEST(vtbar_claim_next(&r, &c[4]));
+		TEST(c[4].sequence == 4 && c[4].start == reused);
+		vtbar_claim_release(&r, &c[4]);
+		TEST(vtbar_claim_reclaim(&r) == 0);
+
+		vtbar_claim_destroy(&r);
+	}
+
+	g_test = "Claim ring threads";
+	{
+		size_t claim_memory[512];
+		vtb_claim_ring r;
+		vtbar_claim_initialize(&r, claim_memory, sizeof(claim_memory), 64);
+
+		const int num_threads = 3;
+		const int num_sections = 20000;
+
+		std::atomic<bool> done(false);
+		std::vector<int> values[num_threads];
+		std::thread threads[num_threads];
+		for (int k = 0; k < num_threads; k++)
+			threads[k] = std::thread(claim_sections, &r, &done, &values[k]);
+
+		for (int k = 0; k < num_sections; k++)
+		{
+			int* section;
+			while (!(section = (int*)vtbar_claim_alloc(&r, sizeof(int)*(1 + k%5))))
+				std::this_thread::yield();
+			*section = k;
+			vtbar_claim_publish(&r);
+		}
+
+		done = true;
+		for (int k = 0; k < num_threads; k++)
+			threads[k].join();
+
+		// Every section went to exactly one consumer, and each consumer got
+		// them in order.
+		std::vector<int> seen(num_sections);
+		bool in_order = true;
+		for (int k = 0; k < num_threads; k++)
+		{
+			for (size_t n = 0; n < values[k].size(); n++)
+			{
+				seen[values[k][n]]++;
+				in_order = in_order && (n == 0 || values[k][n] > values[k][n-1]);
+			}
+		}
+		TEST(in_order);
+
+		bool once = true;
+		for (int k = 0; k < num_sections; k++)
+			once = once && seen[k] == 1;
+		TEST(once);
+
+		TEST(vtbar_claim_reclaim(&r) == 0);
+		vtbar_claim_destroy(&r);
+	}
+
+#ifndef VTBAR_NO_MALLOC
+	g_test = "Claim ring malloc";
+	{
+		vtb_claim_ring r;
+		vtbar_claim_initializememory(&r, 256, 8);
+
+		*(int*)vtbar_claim_alloc(&r, sizeof(int)) = 42;
+		vtbar_claim_publish(&r);
+
+		vtb_claim c;
+		TEST(vtbar_claim_next(&r, &c) && *(int*)c.start == 42);
+		vtbar_claim_release(&r, &c);
+		TEST(vtbar_claim_reclaim(&r) == 0);
+
+		vtbar_claim_destroy(&r);
+	}
+#endif
+
+	g_test = "C++ ring";
+	{
+		char ring_memory[1024];
+		vtb::ring<tracked> r(ring_memory, sizeof(ring_memory));
+
+		TEST(r.empty());
+		TEST(!r.pop_front());
+
+		TEST(r.emplace_back(1)->m_value == 1);
+		TEST(r.emplace_back(2)->m_value == 2);
+		TEST(r.size() == 2);
+		TEST(g_constructed == 2 && g_destroyed == 0);
+
+		{
+			vtb::ring<tracked>::handle h = r.pop_front();
+			TEST(h && h.get()->m_value == 1);
+			TEST(g_destroyed == 0);
+
+			// Moving doesn't destroy anything, only the last owner does.
+			vtb::ring<tracked>::handle moved = std::move(h);
+			TEST(!h && moved);
+			TEST(g_destroyed == 0);
+		}
+
+		TEST(g_destroyed == 1);
+		TEST(r.size() == 1);
+
+		vtb::ring<tracked>::handle h = r.pop_front();
+		TEST(h.get()->m_value == 2);
+		h.release();
+		TEST(!h && g_destroyed == 2);
+		TEST(r.empty());
+
+		// Fill it up. It should fit exactly as many as item_size says.
+		int fits = sizeof(ring_memory) / vtb::ring<tracked>::item_size();
+		int count = 0;
+		while (r.emplace_back(count))
+			count++;
+		TEST(count == fits);
+
+		// Objects left in the ring are destroyed with it.
+	}
+	TEST(g_destroyed == g_constructed);
+
+	g_test = "C++ ring destructor";
+	{
+		g_constructed = g_destroyed = 0;
+
+		char ring_memory[256];
+		{
+			vtb::ring<tracked> r(ring_memory, sizeof(ring_memory));
+			r.emplace_back(1);
+			r.emplace_back(2);
+			r.emplace_back(3);
+			r.pop_front();
+		}
+		TEST(g_constructed == 3 && g_destroyed == 3);
+	}
+
+	g_test = "C++ ring mixed types";
+	{
+		char ring_memory[1024];
+		vtb::ring<tracked, std::string, std::unique_ptr<int>> r(ring_memory, sizeof(ring_memory));
+
+		r.emplace_back<std::string>("a string that's too long for the small string buffer");
+		r.emplace_back<std::unique_ptr<int>>(new int(42));
+		r.emplace_back<tracked>(7);
+
+		vtb::ring<tracked, std::string, std::unique_ptr<int>>::handle h = r.pop_front();
+		TEST(h.type() == 1 && h.is<std::string>() && !h.is<tracked>());
+		TEST(!h.get<tracked>());
+		TEST(*h.get<std::string>() == "a string that's too long for the small string buffer");
+
+		h.release();
+		h = r.pop_front();
+		TEST(h.type() == 2 && **h.get<std::unique_ptr<int>>() == 42);
+
+		// Move the object out, the empty unique_ptr is destroyed on release.
+		std::unique_ptr<int> taken = std::move(*h.get<std::unique_ptr<int>>());
+		h.release();
+		TEST(*taken == 42);
+
+		g_constructed = g_destroyed = 0;
+		h = r.pop_front();
+		TEST(h.get<tracked>()->m_value == 7);
+		h.release();
+		TEST(g_destroyed == 1);
+		TEST(r.empty());
+	}
+
+	g_test = "C++ ring constructor throws";
+	{
+		char ring_memory[256];
+		vtb::ring<tracked, thrower> r(ring_memory, sizeof(ring_memory));
+
+		r.emplace_back<tracked>(1);
+
+		bool threw = false;
+		try
+		{
+			r.emplace_back<thrower>();
+		}
+		catch (int)
+		{
+			threw = true;
+		}
+		TEST(threw);
+
+		r.emplace_back<tracked>(2);
+
+		// The broken block is skipped.
+		TEST(r.pop_front().get<tracked>()->m_value == 1);
+		TEST(r.pop_front().get<tracked>()->m_value == 2);
+		TEST(!r.pop_front());
+	}
+
+	g_test = "C++ static ring";
+	{
+		vtb::static_ring<4, 12> r;
+		static_assert(vtb::static_ring<4, 12>::stride == 16, "Sections are size_t aligned");
+		static_assert(sizeof(r) == 4*16 + 2*sizeof(uint32_t) + (sizeof(size_t) - 2*sizeof(uint32_t)), "Memory is inline");
+
+		TEST(r.empty() && !r.peektail());
+
+		int* p[4];
+		for (int k = 0; k < 4; k++)
+		{
+			p[k] = (int*)r.alloc();
+			TEST(p[k] && ((size_t)p[k] & (sizeof(size_t) - 1)) == 0);
+			*p[k] = k;
+		}
+
+		TEST(r.full() && r.size() == 4);
+		TEST(!r.alloc());
+
+		TEST(r.peektail() == p[0]);
+		r.freetail();
+		TEST(r.peektail() == p[1] && r.size() == 3);
+
+		// Wraps around to where the first one was.
+		int* wrapped = (int*)r.alloc();
+		TEST(wrapped == p[0]);
+		*wrapped = 4;
+
+		int values[8];
+		int count = 0;
+		TEST(r.drain([&](void* start) { values[count++] = *(int*)start; }, 2) == 2);
+		TEST(count == 2 && values[0] == 1 && values[1] == 2);
+		TEST(r.drain([&](void* start) { values[count++] = *(int*)start; }) == 2);
+		TEST(count == 4 && values[2] == 3 && values[3] == 4);
+		TEST(r.empty() && r.size() == 0);
+
+		// Many times around.
+		bool in_order = true;
+		for (int k = 0; k < 100000; k++)
+		{
+			*(int*)r.alloc() = k;
+			in_order = in_order && *(int*)r.peektail() == k;
+			r.freetail();
+		}
+		TEST(in_order && r.empty());
+	}
+
 	return 0;
 }
 
@@ -0,0 +1,197 @@
+#define VTB_HASH_IMPLEMENTATION
+#define VTB_DIRTY_IMPLEMENTATION
+
+#include "../vtb_dirty.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+const char* g_test;
+int g_line;
+
+static void catch_sigbus(int signal)
+{
+    printf("Bus error during test '%s' after line %d\n", g_test, g_line);
+    exit(1);
+}
+
+static void catch_sigfpe(int signal)
+{
+    printf("Floating point exception during test '%s' after line %d\n", g_test, g_line);
+    exit(1);
+}
+
+static void catch_sigill(int signal)
+{
+    printf("Illegal instruction during test '%s' after line %d\n", g_test, g_line);
+    exit(1);
+}
+
+static void catch_sigsegv(int signal)
+{
+    printf("Segfault during test '%s' after line %d\n", g_test, g_line);
+    exit(1);
+}
+
+#define TEST(x) g_line = __LINE__; { if (!(x)) { printf("Test '" #x "' on line %d during '%s' failed.\n", __LINE__, g_test); return 1; } }
+
+int main()
+{
+	if (signal(SIGBUS, catch_sigbus) == SIG_ERR ||
+		signal(SIGFPE, catch_sigfpe) == SIG_ERR ||
+		signal(SIGILL, catch_sigill) == SIG_ERR ||
+		signal(SIGSEGV, catch_sigsegv) == SIG_ERR)
+	{
+		fputs("An error occurred while setting a signal handler.\n", stderr);
+		return 1;
+	}
+
+	vtb_dirty d;
+	size_t changed[16];
+
+	g_test = "Manual";
+
+	{
+		// 10 blocks of 100, the last one short.
+		static uint8_t region[950];
+		memset(region, 0, sizeof(region));
+
+		uint32_t index[(10*5 + 3)/4];
+		TEST(vtbd_getindexsize(sizeof(region), 100) == 10*5);
+		vtbd_initialize(&d, region, sizeof(region), 100, index, sizeof(index));
+
+		TEST(vtbd_getnumblocks(&d) == 10);
+		TEST(vtbd_getblocksize(&d) == 100);
+		TEST(vtbd_getnumdirty(&d) == 0);
+		TEST(vtbd_update(&d, changed, 16) == 0);
+		TEST(vtbd_gethash(&d, 0) == vtbd_gethash(&d, 1));
+		TEST(vtbd_gethash(&d, 0) != vtbd_gethash(&d, 9));
+
+		// Unmarked writes aren't seen.
+		region[5] = 1;
+		TEST(vtbd_update(&d, changed, 16) == 0);
+
+		region[250] = 1;
+		region[940] = 1;
+		vtbd_markdirty(&d, &region[5], 1);
+		vtbd_markdirty(&d, &region[250], 1);
+		vtbd_markdirty(&d, &region[940], 1);
+		TEST(vtbd_getnumdirty(&d) == 3);
+		TEST(vtbd_update(&d, changed, 16) == 3);
+		TEST(changed[0] == 0 && changed[1] == 2 && changed[2] == 9);
+		TEST(vtbd_getnumdirty(&d) == 0);
+
+		// A range marks every block it touches.
+		vtbd_markdirty(&d, &region[199], 102);
+		TEST(vtbd_getnumdirty(&d) == 3);
+
+		// Writing the same bytes back is dirty but not a change.
+		region[250] = 1;
+		TEST(vtbd_update(&d, changed, 16) == 0);
+		TEST(vtbd_getnumdirty(&d) == 0);
+
+		// Writing and undoing it isn't either.
+		region[600] = 7;
+		region[600] = 0;
+		vtbd_markdirty(&d, &region[600], 1);
+		TEST(vtbd_update(&d, changed, 16) == 0);
+
+		// More changes than room, the rest stay dirty for next time.
+		for (int k = 0; k < 10; k++)
+			region[k*100 + 10] += 1;
+		vtbd_markall(&d);
+		TEST(vtbd_update(&d, changed, 4) == 4);
+		TEST(changed[0] == 0 && changed[3] == 3);
+		TEST(vtbd_getnumdirty(&d) == 6);
+		TEST(vtbd_update(&d, changed, 4) == 4);
+		TEST(changed[0] == 4 && changed[3] == 7);
+		TEST(vtbd_update(&d, changed, 4) == 2);
+		TEST(changed[0] == 8 && changed[1] == 9);
+		TEST(vtbd_getnumdirty(&d) == 0);
+
+		// Only dirty blocks are rehashed.
+		uint32_t hash = vtbd_gethash(&d, 4);
+		region[420] = 9;
+		TEST(vtbd_update(&d, changed, 16) == 0);
+		TEST(vtbd_gethash(&d, 4) == hash);
+
+		vtbd_destroy(&d);
+	}
+
+#ifndef VTBD_NO_MALLOC
+	g_test = "Write protect";
+
+	{
+		size_t page_size = (size_t)sysconf(_SC_PAGESIZE);
+		size_t num_pages = 64;
+		uint8_t* region = (uint8_t*)mmap(0, page_size*num_pages, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		TEST(region != (uint8_t*)MAP_FAILED);
+
+		vtbd_initializememory(&d, region, page_size*num_pages, page_size*2);
+		TEST(vtbd_getnumblocks(&d) == num_pages/2);
+
+		// Blocks that aren't whole pages can't be protected.
+		vtb_dirty small;
+		vtbd_initializememory(&small, region, page_size*num_pages, page_size/2);
+		TEST(!vtbd_protect(&small));
+		vtbd_destroy(&small);
+
+		TEST(vtbd_protect(&d));
+
+		// Reads don't mark anything.
+		int sum = 0;
+		for (size_t k = 0; k < page_size*num_pages; k += 64)
+			sum += region[k];
+		TEST(sum == 0);
+		TEST(vtbd_getnumdirty(&d) == 0);
+
+		region[0] = 1;
+		region[1] = 2;
+		region[page_size*5 + 7] = 3;
+		region[page_size*num_pages - 1] = 4;
+		TEST(vtbd_getnumdirty(&d) == 3);
+		TEST(vtbd_update(&d, changed, 16) == 3);
+		TEST(changed[0] == 0 && changed[1] == 2 && changed[2] == num_pages/2 - 1);
+
+		// Blocks are protected again after an update.
+		region[2] = 5;
+		TEST(vtbd_getnumdirty(&d) == 1);
+
+		// Same value, caught but not a change.
+		region[page_size*5 + 7] = 3;
+		TEST(vtbd_getnumdirty(&d) == 2);
+		TEST(vtbd_update(&d, changed, 16) == 1);
+		TEST(changed[0] == 0);
+
+		// Many times around.
+		bool all_seen = true;
+		for (int pass = 1; pass < 50; pass++)
+		{
+			size_t block = (size_t)(pass * 7) % (num_pages/2);
+			region[block*page_size*2 + pass] = (uint8_t)pass;
+			all_seen = all_seen && vtbd_update(&d, changed, 16) == 1 && changed[0] == block;
+		}
+		TEST(all_seen);
+
+		// Unprotected it's writable without being marked.
+		vtbd_unprotect(&d);
+		region[page_size*3] = 9;
+		TEST(vtbd_getnumdirty(&d) == 0);
+
+		TEST(vtbd_protect(&d));
+		region[page_size*3] = 10;
+		TEST(vtbd_update(&d, changed, 16) == 1);
+		TEST(changed[0] == 1);
+
+		// Destroy leaves it writable.
+		vtbd_destroy(&d);
+		region[0] = 0;
+
+		munmap(region, page_size*num_pages);
+	}
+#endif
+
+	return 0;
+}
@@ -0,0 +1,10 @@
+#define VTB_HASH_IMPLEMENTATION
+#define VTB_FILTER_IMPLEMENTATION
+
+#include "../vtb_filter.h"
+
+int main()
+{
+	// As long as it compiles I'm happy.
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,247 @@
+#define VTB_HASH_IMPLEMENTATION
+#define VTB_FILTER_IMPLEMENTATION
+
+#include "../vtb_filter.h"
+
+#include <stdio.h>
+#include <string.h>
+
+const char* g_test;
+int g_line;
+
+static void catch_sigbus(int signal)
+{
+    printf("Bus error during test '%s' after line %d\n", g_test, g_line);
+    exit(1);
+}
+
+static void catch_sigfpe(int signal)
+{
+    printf("Floating point exception during test '%s' after line %d\n", g_test, g_line);
+    exit(1);
+}
+
+static void catch_sigill(int signal)
+{
+    printf("Illegal instruction during test '%s' after line %d\n", g_test, g_line);
+    exit(1);
+}
+
+static void catch_sigsegv(int signal)
+{
+    printf("Segfault during test '%s' after line %d\n", g_test, g_line);
+    exit(1);
+}
+
+#define TEST(x) g_line = __LINE__; { if (!(x)) { printf("Test '" #x "' on line %d during '%s' failed.\n", __LINE__, g_test); return 1; } }
+
+int main()
+{
+	if (signal(SIGBUS, catch_sigbus) == SIG_ERR ||
+		signal(SIGFPE, catch_sigfpe) == SIG_ERR ||
+		signal(SIGILL, catch_sigill) == SIG_ERR ||
+		signal(SIGSEGV, catch_sigsegv) == SIG_ERR)
+	{
+		fputs("An error occurred while setting a signal handler.\n", stderr);
+		return 1;
+	}
+
+	const uint64_t num_keys = 20000;
+	const uint64_t num_probes = 100000;
+
+	g_test = "bloom";
+	{
+		vtb_bloom b;
+		vtbf_bloom_initializememory(&b, num_keys, 10);
+		TEST(vtbf_bloom_getmemorysize(&b) == (num_keys*10 + 511)/512*64);
+
+		for (uint64_t k = 0; k < num_keys; k++)
+			vtbf_bloom_add(&b, &k, sizeof(k));
+
+		bool all_found = true;
+		for (uint64_t k = 0; k < num_keys; k++)
+			all_found &= !!vtbf_bloom_contains(&b, &k, sizeof(k));
+		TEST(all_found);
+
+		// About 1.2% at 10 bits per key.
+		int false_positives = 0;
+		for (uint64_t k = num_keys; k < num_keys + num_probes; k++)
+			false_positives += vtbf_bloom_contains(&b, &k, sizeof(k));
+		TEST(false_positives > 0 && false_positives < num_probes*2/100);
+
+		const char* key = "some key";
+		TEST(vtbf_bloom_contains(&b, key, strlen(key)) == vtbf_bloom_containshash(&b, vtbf_hash(key, strlen(key))));
+
+		vtbf_bloom_clear(&b);
+
+		int found = 0;
+		for (uint64_t k = 0; k < num_keys; k++)
+			found += vtbf_bloom_contains(&b, &k, sizeof(k));
+		TEST(found == 0);
+
+		vtbf_bloom_destroy(&b);
+	}
+
+	g_test = "bloom user memory";
+	{
+		// Unaligned on purpose, it should skip to the next cache line.
+		alignas(64) static uint64_t memory[8*5];
+		vtb_bloom b;
+		vtbf_bloom_initialize(&b, memory + 1, sizeof(memory) - 8);
+		TEST(vtbf_bloom_getmemorysize(&b) == 64*4);
+
+		for (uint64_t k = 0; k < 50; k++)
+			vtbf_bloom_addhash(&b, k * 0x9E3779B97F4A7C15ull);
+
+		bool all_found = true;
+		for (uint64_t k = 0; k < 50; k++)
+			all_found &= !!vtbf_bloom_containshash(&b, k * 0x9E3779B97F4A7C15ull);
+		TEST(all_found);
+
+		// The skipped bytes weren't touched.
+		bool skipped_untouched = true;
+		for (int k = 1; k < 8; k++)
+			skipped_untouched &= memory[k] == 0;
+		TEST(skipped_untouched);
+
+		vtbf_bloom_destroy(&b);
+	}
+
+	g_test = "bloom layout";
+	{
+		// The bits the plain C loop sets, so builds with and without AVX2
+		// can read each other's filters.
+		alignas(64) static uint64_t memory[8*16];
+		alignas(64) static uint64_t expected[8*16];
+		vtb_bloom b;
+		vtbf_bloom_initialize(&b, memory, sizeof(memory));
+
+		for (uint64_t k = 0; k < 100; k++)
+		{
+			uint64_t hash = vtbf_hash(&k, sizeof(k));
+			vtbf_bloom_addhash(&b, hash);
+
+			uint64_t* block = expected + (((hash >> 32) * 16) >> 32) * 8;
+			uint32_t h1 = (uint32_t)hash;
+			uint32_t h2 = ((uint32_t)(hash >> 32) * 0x9E3779B1u) | 1;
+			for (uint32_t j = 0; j < 8; j++)
+				block[j] |= (uint64_t)1 << ((h1 + j*h2) >> 26);
+		}
+		TEST(memcmp(memory, expected, sizeof(memory)) == 0);
+
+		// And a filter filled that way reads back the same.
+		memcpy(memory, expected, sizeof(memory));
+		bool same = true;
+		for (uint64_t k = 0; k < 10000; k++)
+		{
+			uint64_t hash = vtbf_hash(&k, sizeof(k));
+
+			const uint64_t* block = expected + (((hash >> 32) * 16) >> 32) * 8;
+			uint32_t h1 = (uint32_t)hash;
+			uint32_t h2 = ((uint32_t)(hash >> 32) * 0x9E3779B1u) | 1;
+			uint64_t missing = 0;
+			for (uint32_t j = 0; j < 8; j++)
+				missing |= ~block[j] & ((uint64_t)1 << ((h1 + j*h2) >> 26));
+
+			same &= !!vtbf_bloom_containshash(&b, hash) == !missing;
+		}
+		TEST(same);
+
+		vtbf_bloom_destroy(&b);
+	}
+
+	g_test = "cuckoo";
+	{
+		vtb_cuckoo c;
+		vtbf_cuckoo_initializememory(&c, num_keys);
+		TEST(vtbf_cuckoo_getcapacity(&c) >= num_keys);
+		TEST(vtbf_cuckoo_getcount(&c) == 0);
+
+		bool all_added = true;
+		for (uint64_t k = 0; k < num_keys; k++)
+			all_added &= !!vtbf_cuckoo_add(&c, &k, sizeof(k));
+		TEST(all_added);
+
+		TEST(vtbf_cuckoo_getcount(&c) == num_keys);
+
+		bool all_found = true;
+		for (uint64_t k = 0; k < num_keys; k++)
+			all_found &= !!vtbf_cuckoo_contains(&c, &k, sizeof(k));
+		TEST(all_found);
+
+		int false_positives = 0;
+		for (uint64_t k = num_keys; k < num_keys + num_probes; k++)
+			false_positives += vtbf_cuckoo_contains(&c, &k, sizeof(k));
+		TEST(false_positives < num_probes/1000);
+
+		// Remove the even keys, the odd ones stay.
+		bool all_removed = true;
+		for (uint64_t k = 0; k < num_keys; k += 2)
+			all_removed &= !!vtbf_cuckoo_remove(&c, &k, sizeof(k));
+		TEST(all_removed);
+		TEST(vtbf_cuckoo_getcount(&c) == num_keys/2);
+
+		all_found = true;
+		for (uint64_t k = 1; k < num_keys; k += 2)
+			all_found &= !!vtbf_cuckoo_contains(&c, &k, sizeof(k));
+		TEST(all_found);
+
+		int still_found = 0;
+		for (uint64_t k = 0; k < num_keys; k += 2)
+			still_found += vtbf_cuckoo_contains(&c, &k, sizeof(k));
+		TEST(still_found < (int)num_keys/1000);
+
+		vtbf_cuckoo_clear(&c);
+		TEST(vtbf_cuckoo_getcount(&c) == 0);
+		TEST(!vtbf_cuckoo_contains(&c, &num_keys, sizeof(num_keys)));
+
+		vtbf_cuckoo_destroy(&c);
+	}
+
+	g_test = "cuckoo full";
+	{
+		static uint64_t memory[64];
+		vtb_cuckoo c;
+		vtbf_cuckoo_initialize(&c, memory, sizeof(memory));
+		TEST(vtbf_cuckoo_getcapacity(&c) == 64*4);
+
+		// Fill it until it refuses. Every key that was accepted must still
+		// be found, including the one that got kicked out last.
+		uint64_t added = 0;
+		while (vtbf_cuckoo_add(&c, &added, sizeof(added)))
+			added++;
+
+		TEST(added > 64*4*90/100 && added <= 64*4);
+		TEST(vtbf_cuckoo_getcount(&c) == added);
+
+		bool all_found = true;
+		for (uint64_t k = 0; k < added; k++)
+			all_found &= !!vtbf_cuckoo_contains(&c, &k, sizeof(k));
+		TEST(all_found);
+
+		// Refusing doesn't change anything.
+		TEST(!vtbf_cuckoo_add(&c, &added, sizeof(added)));
+		TEST(vtbf_cuckoo_getcount(&c) == added);
+
+		bool all_removed;
+
+		// Making room lets the kicked out key back in, and then new keys.
+		all_removed = true;
+		for (uint64_t k = 0; k < 16; k++)
+			all_removed &= !!vtbf_cuckoo_remove(&c, &k, sizeof(k));
+		TEST(all_removed);
+
+		all_found = true;
+		for (uint64_t k = 16; k < added; k++)
+			all_found &= !!vtbf_cuckoo_contains(&c, &k, sizeof(k));
+		TEST(all_found);
+
+		TEST(vtbf_cuckoo_add(&c, &added, sizeof(added)));
+		TEST(vtbf_cuckoo_contains(&c, &added, sizeof(added)));
+		TEST(vtbf_cuckoo_getcount(&c) == added - 16 + 1);
+
+		vtbf_cuckoo_destroy(&c);
+	}
+
+	return 0;
+}
\ No newline at end of file
@@ -10,6 +10,9 @@
 #include <math.h>
 #include <stdlib.h>
 #include <algorithm>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
 
 const char* g_test;
 int g_line;
@@ -38,6 +41,56 @@ static void catch_sigsegv(int signal)
     exit(1);
 }
 
+// Bytes are its value, so it can be hashed as one block.
+struct point
+{
+	int32_t x;
+	int32_t y;
+
+	bool operator==(const point& other) const
+	{
+		return x == other.x && y == other.y;
+	}
+};
+
+namespace vtb
+{
+	template <>
+	struct is_uniquely_represented<point> : std::true_type
+	{
+	};
+}
+
+VTBH_STD_HASH(point)
+
+namespace people
+{
+	// Has padding and a string, so it's hashed field by field.
+	struct person
+	{
+		std::string name;
+		char initial;
+		double height;
+
+		bool operator==(const person& other) const
+		{
+			return name == other.name && initial == other.initial && height == other.height;
+		}
+	};
+
+	void hash_append(vtb_hash& h, const person& p)
+	{
+		vtb::hash_append(h, p.name, p.initial, p.height);
+	}
+}
+
+static uint32_t hash_memory(const void* memory, size_t size)
+{
+	vtb_hash h = vtbh_new();
+	vtbh_bytes(&h, (const unsigned char*)memory, size);
+	return h.hash;
+}
+
 #define TEST(x) g_line = __LINE__; { if (!(x)) { printf("Test '" #x "' on line %d during '%s' failed.\n", __LINE__, g_test); test = 1; } }
 
 int main()
@@ -246,6 +299,541 @@ int main()
 	vtbh_float(&b, x);
 	TEST(a.hash == b.hash);
 
+	g_test = "portable";
+	{
+		unsigned char bytes[67];
+		for (int k = 0; k < (int)sizeof(bytes); k++)
+			bytes[k] = (unsigned char)(k*37 + 11);
+
+		a = vtbh_new();
+		vtbh_bytes(&a, bytes, sizeof(bytes));
+		TEST(a.hash == 0xE55D9EE4);
+
+		// Same bytes at every alignment, one at a time or all together.
+		bool aligned_ok = true;
+		unsigned char shifted[sizeof(bytes) + 3];
+		for (int offset = 0; offset < 4; offset++)
+		{
+			memcpy(shifted + offset, bytes, sizeof(bytes));
+			b = vtbh_new();
+			vtbh_bytes(&b, shifted + offset, sizeof(bytes));
+			aligned_ok &= a.hash == b.hash;
+
+			b = vtbh_new();
+			for (int k = 0; k < (int)sizeof(bytes); k++)
+				vtbh_byte(&b, shifted[offset + k]);
+			aligned_ok &= a.hash == b.hash;
+		}
+		TEST(aligned_ok);
+
+#if defined(VTBH_PORTABLE) || !defined(__BYTE_ORDER__) || __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+		// Ints hash as their little endian bytes.
+		unsigned int ints[2] = { 0x01020304, 0xA0B0C0D0 };
+		unsigned char ints_le[8] = { 0x04, 0x03, 0x02, 0x01, 0xD0, 0xC0, 0xB0, 0xA0 };
+		a = vtbh_new();
+		vtbh_ints(&a, ints, 2);
+		b = vtbh_new();
+		vtbh_bytes(&b, ints_le, sizeof(ints_le));
+		TEST(a.hash == b.hash);
+
+		a = vtbh_new();
+		vtbh_int(&a, ints[0]);
+		vtbh_int(&a, ints[1]);
+		TEST(a.hash == b.hash);
+#endif
+	}
+
+	g_test = "canonical floats";
+	{
+		// Long enough to go through the SIMD loop and the tail.
+		float floats[37];
+		double doubles[37];
+		for (int k = 0; k < 37; k++)
+		{
+			floats[k] = k*0.25f - 7;
+			doubles[k] = k*0.25 - 7;
+		}
+
+		a = vtbh_new();
+		vtbh_floats_canonical(&a, floats, 37);
+		TEST(a.hash == 0x5D2F9F3A);
+
+		a = vtbh_new();
+		vtbh_doubles_canonical(&a, doubles, 37);
+		TEST(a.hash == 0x527A9BF5);
+
+		// floats[28] and doubles[28] are +0. -0 should hash the same.
+		a = vtbh_new();
+		vtbh_floats_canonical(&a, floats, 37);
+		floats[28] = -0.0f;
+		b = vtbh_new();
+		vtbh_floats_canonical(&b, floats, 37);
+		TEST(a.hash == b.hash);
+
+		a = vtbh_new();
+		vtbh_doubles_canonical(&a, doubles, 37);
+		doubles[28] = -0.0;
+		b = vtbh_new();
+		vtbh_doubles_canonical(&b, doubles, 37);
+		TEST(a.hash == b.hash);
+
+		// Every NaN should hash the same, in the SIMD part and in the tail.
+		uint32_t float_nans[] = { 0x7FC00000, 0xFFC00000, 0x7F800001, 0xFFBADBAD };
+		uint64_t double_nans[] = { 0x7FF8000000000000ull, 0xFFF8000000000000ull, 0x7FF0000000000001ull, 0xFFFBADBADBADBADBull };
+		for (int n = 0; n < 2; n++)
+		{
+			int index = n ? 35 : 3;
+
+			uint32_t hashes[4];
+			for (int k = 0; k < 4; k++)
+			{
+				memcpy(&floats[index], &float_nans[k], sizeof(float));
+				a = vtbh_new();
+				vtbh_floats_canonical(&a, floats, 37);
+				hashes[k] = a.hash;
+			}
+			TEST(hashes[0] == hashes[1] && hashes[0] == hashes[2] && hashes[0] == hashes[3]);
+
+			for (int k = 0; k < 4; k++)
+			{
+				memcpy(&doubles[index], &double_nans[k], sizeof(double));
+				a = vtbh_new();
+				vtbh_doubles_canonical(&a, doubles, 37);
+				hashes[k] = a.hash;
+			}
+			TEST(hashes[0] == hashes[1] && hashes[0] == hashes[2] && hashes[0] == hashes[3]);
+		}
+
+		// But other small changes should still change the hash.
+		a = vtbh_new();
+		vtbh_floats_canonical(&a, floats, 37);
+		floats[20] = nextafterf(floats[20], 100);
+		b = vtbh_new();
+		vtbh_floats_canonical(&b, floats, 37);
+		TEST(a.hash != b.hash);
+
+		a = vtbh_new();
+		vtbh_floats_canonical(&a, floats, 36);
+		TEST(a.hash != b.hash);
+	}
+
+	g_test = "chunker";
+	{
+		const size_t data_size = 1024*1024;
+		unsigned char* data = (unsigned char*)malloc(data_size + 1);
+
+		uint32_t state = 0x12345678;
+		for (size_t k = 0; k < data_size; k++)
+		{
+			state ^= state << 13;
+			state ^= state >> 17;
+			state ^= state << 5;
+			data[k] = (unsigned char)state;
+		}
+
+		const size_t max_chunks = data_size/256 + 1;
+		size_t* ends = (size_t*)malloc(max_chunks * sizeof(size_t));
+		size_t* byte_ends = (size_t*)malloc(max_chunks * sizeof(size_t));
+		size_t* shifted_ends = (size_t*)malloc(max_chunks * sizeof(size_t));
+
+		// Chunk in pieces of awkward sizes, so boundaries fall on every
+		// part of the split loops and chunks carry over between calls.
+		vtb_chunker c = vtbh_chunker_new(256, 1024, 4096);
+		size_t num_chunks = 0;
+		size_t offset = 0;
+		size_t piece = 1;
+		while (offset < data_size)
+		{
+			size_t piece_size = std::min(piece, data_size - offset);
+			size_t used = 0;
+			while (size_t end = vtbh_chunker_next(&c, data + offset + used, piece_size - used))
+			{
+				used += end;
+				ends[num_chunks++] = offset + used;
+			}
+			offset += piece_size;
+			piece = piece*7 % 5003 + 1;
+		}
+
+		c = vtbh_chunker_new(256, 1024, 4096);
+		size_t num_byte_chunks = 0;
+		for (size_t k = 0; k < data_size; k++)
+		{
+			if (vtbh_chunker_byte(&c, data[k]))
+				byte_ends[num_byte_chunks++] = k + 1;
+		}
+
+		TEST(num_chunks == num_byte_chunks);
+		TEST(num_chunks > 0 && memcmp(ends, byte_ends, num_chunks * sizeof(size_t)) == 0);
+
+		bool sizes_ok = true;
+		for (size_t k = 0; k < num_chunks; k++)
+		{
+			size_t size = ends[k] - (k ? ends[k-1] : 0);
+			sizes_ok &= size >= 256 && size <= 4096;
+		}
+		TEST(sizes_ok);
+
+		double average = (double)ends[num_chunks-1] / num_chunks;
+		TEST(average > 512 && average < 2048);
+
+		// Insert a byte near the start. Only the chunks near it should move.
+		memmove(data + 1001, data + 1000, data_size - 1000);
+		data[1000] = 0x5A;
+
+		c = vtbh_chunker_new(256, 1024, 4096);
+		size_t num_shifted_chunks = 0;
+		offset = 0;
+		while (size_t end = vtbh_chunker_next(&c, data + offset, data_size + 1 - offset))
+		{
+			offset += end;
+			shifted_ends[num_shifted_chunks++] = offset;
+		}
+
+		size_t same = 0;
+		for (size_t k = 0, j = 0; k < num_chunks && j < num_shifted_chunks; )
+		{
+			size_t expected = ends[k] > 1000 ? ends[k] + 1 : ends[k];
+			if (expected == shifted_ends[j])
+			{
+				same++;
+				k++;
+				j++;
+			}
+			else if (expected < shifted_ends[j])
+				k++;
+			else
+				j++;
+		}
+		TEST(same + 3 >= num_chunks);
+
+		// A chunk ends at max_size even if the content never hits a boundary.
+		memset(data, 0, data_size);
+		c = vtbh_chunker_new(256, 1024, 4096);
+		TEST(vtbh_chunker_next(&c, data, data_size) == 4096);
+
+		// One short of max_size, no bytes isn't a chunk end, the next byte is.
+		c = vtbh_chunker_new(256, 1024, 4096);
+		TEST(vtbh_chunker_next(&c, data, 4095) == 0);
+		TEST(vtbh_chunker_next(&c, data, 0) == 0);
+		TEST(vtbh_chunker_next(&c, data, 1) == 1);
+
+		free(shifted_ends);
+		free(byte_ends);
+		free(ends);
+		free(data);
+	}
+
+	g_test = "combine";
+	{
+		unsigned char data[300];
+		uint32_t state = 0x9E3779B9;
+		for (size_t k = 0; k < sizeof(data); k++)
+		{
+			state ^= state << 13;
+			state ^= state >> 17;
+			state ^= state << 5;
+			data[k] = (unsigned char)state;
+		}
+
+		vtb_chash whole = vtbh_chash_new();
+		vtbh_chash_bytes(&whole, data, sizeof(data));
+		TEST(whole.length == sizeof(data));
+		TEST(vtbh_chash_digest(whole) == 0xF53F70A31287CC20ull);
+
+		// Every split, including empty pieces on either side.
+		bool combined_ok = true;
+		for (size_t split = 0; split <= sizeof(data); split++)
+		{
+			vtb_chash first = vtbh_chash_new();
+			vtbh_chash_bytes(&first, data, split);
+
+			vtb_chash second = vtbh_chash_new();
+			vtbh_chash_bytes(&second, data + split, sizeof(data) - split);
+
+			vtb_chash combined = vtbh_combine(first, second);
+			combined_ok &= combined.value == whole.value && combined.length == whole.length;
+		}
+		TEST(combined_ok);
+
+		// Three pieces hashed out of order and combined either way.
+		vtb_chash pieces[3];
+		size_t piece_ends[4] = { 0, 13, 160, sizeof(data) };
+		for (int k = 2; k >= 0; k--)
+		{
+			pieces[k] = vtbh_chash_new();
+			vtbh_chash_bytes(&pieces[k], data + piece_ends[k], piece_ends[k+1] - piece_ends[k]);
+		}
+
+		TEST(vtbh_chash_digest(vtbh_combine(vtbh_combine(pieces[0], pieces[1]), pieces[2])) == vtbh_chash_digest(whole));
+		TEST(vtbh_chash_digest(vtbh_combine(pieces[0], vtbh_combine(pieces[1], pieces[2]))) == vtbh_chash_digest(whole));
+
+		// Hashing more bytes into a state is the same as combining.
+		vtb_chash streamed = pieces[0];
+		vtbh_chash_bytes(&streamed, data + piece_ends[1], sizeof(data) - piece_ends[1]);
+		TEST(streamed.value == whole.value);
+
+		// Zero bytes and length both count.
+		unsigned char zeros[2] = { 0, 0 };
+		vtb_chash empty = vtbh_chash_new();
+		vtb_chash one_zero = vtbh_chash_new();
+		vtbh_chash_bytes(&one_zero, zeros, 1);
+		vtb_chash two_zeros = vtbh_chash_new();
+		vtbh_chash_bytes(&two_zeros, zeros, 2);
+		TEST(vtbh_chash_digest(empty) != vtbh_chash_digest(one_zero));
+		TEST(vtbh_chash_digest(one_zero) != vtbh_chash_digest(two_zeros));
+	}
+
+	g_test = "seeded";
+	{
+		const char* key = "a key from outside";
+		size_t key_length = strlen(key);
+
+		a = vtbh_new_seeded(1);
+		b = vtbh_new_seeded(1);
+		vtbh_string(&a, key, key_length);
+		vtbh_string(&b, key, key_length);
+		TEST(a.hash == b.hash);
+
+		// Every seed gives a different hash.
+		std::vector<uint32_t> hashes;
+		for (uint64_t seed = 0; seed < 1000; seed++)
+		{
+			a = vtbh_new_seeded(seed);
+			vtbh_string(&a, key, key_length);
+			hashes.push_back(a.hash);
+		}
+		std::sort(hashes.begin(), hashes.end());
+		TEST(std::unique(hashes.begin(), hashes.end()) == hashes.end());
+
+		// Keys that share a bucket with one seed are spread out with another.
+		int same_bucket = 0;
+		for (unsigned int k = 0; k < 256; k++)
+		{
+			a = vtbh_new_seeded(1);
+			b = vtbh_new_seeded(2);
+			vtbh_int(&a, k);
+			vtbh_int(&b, k);
+			same_bucket += (a.hash & 63) == (b.hash & 63);
+		}
+		TEST(same_bucket < 16);
+
+		// Keys made of blocks that collide with each other under every seed
+		// for a hash that only starts from the seed. 2^10 keys of 20 bytes.
+		static const unsigned char blocks[2][2] = { { 0, 127 }, { 85, 213 } };
+		uint64_t flood_seeds[3] = { 1, 0xdeadbeef, vtbh_process_seed() };
+		for (int s = 0; s < 3; s++)
+		{
+			std::vector<uint32_t> flood;
+			for (unsigned int k = 0; k < 1024; k++)
+			{
+				unsigned char flood_key[20];
+				for (int block = 0; block < 10; block++)
+					memcpy(&flood_key[block*2], blocks[(k >> block) & 1], 2);
+
+				a = vtbh_new_seeded(flood_seeds[s]);
+				vtbh_bytes(&a, flood_key, sizeof(flood_key));
+				flood.push_back(a.hash);
+			}
+
+			int buckets[64] = {};
+			for (size_t k = 0; k < flood.size(); k++)
+				buckets[flood[k] & 63]++;
+			TEST(*std::max_element(buckets, buckets + 64) < 48);
+
+			std::sort(flood.begin(), flood.end());
+			TEST(std::unique(flood.begin(), flood.end()) - flood.begin() >= 1020);
+		}
+
+		int pair_collisions = 0;
+		for (uint64_t seed = 0; seed < 1000; seed++)
+		{
+			a = vtbh_new_seeded(seed);
+			b = vtbh_new_seeded(seed);
+			vtbh_bytes(&a, blocks[0], 2);
+			vtbh_bytes(&b, blocks[1], 2);
+			pair_collisions += a.hash == b.hash;
+		}
+		TEST(pair_collisions < 2);
+
+		// Same hash however the bytes are split up, and trailing zeros count.
+		unsigned char split_bytes[37];
+		for (int k = 0; k < 37; k++)
+			split_bytes[k] = (unsigned char)(k * 7 + 1);
+		a = vtbh_new_seeded(3);
+		vtbh_bytes(&a, split_bytes, sizeof(split_bytes));
+		for (size_t split = 0; split <= sizeof(split_bytes); split++)
+		{
+			b = vtbh_new_seeded(3);
+			vtbh_bytes(&b, split_bytes, split);
+			vtbh_bytes(&b, split_bytes + split, sizeof(split_bytes) - split);
+			TEST(a.hash == b.hash);
+		}
+
+#if defined(VTBH_PORTABLE) || !defined(VTBH__BIG_ENDIAN)
+		// Ints are hashed as their little endian bytes, all in one go.
+		unsigned int ints[37];
+		unsigned char int_bytes[sizeof(ints)];
+		for (int k = 0; k < 37; k++)
+		{
+			ints[k] = 0x01020304u * (unsigned int)(k + 1);
+			for (int j = 0; j < 4; j++)
+				int_bytes[k*4 + j] = (unsigned char)(ints[k] >> (8*j));
+		}
+		a = vtbh_new_seeded(3);
+		b = vtbh_new_seeded(3);
+		vtbh_ints(&a, ints, 37);
+		vtbh_bytes(&b, int_bytes, sizeof(int_bytes));
+		TEST(a.hash == b.hash);
+#endif
+
+		a = vtbh_new_seeded(3);
+		b = vtbh_new_seeded(3);
+		unsigned char zero = 0;
+		vtbh_bytes(&b, &zero, 1);
+		TEST(a.hash != b.hash);
+
+		uint64_t seed = vtbh_process_seed();
+		TEST(seed != 0);
+		TEST(vtbh_process_seed() == seed);
+
+		a = vtbh_new_seeded(seed);
+		vtb::hash_append(a, std::string(key));
+		TEST(vtb::seeded_hash<std::string>()(key) == a.hash);
+		TEST(vtb::seeded_hash<std::string>(1)(key) != a.hash);
+	}
+
+	g_test = "C++ hash";
+	{
+		int i = 1234567;
+		TEST(vtb::hash<int>()(i) == hash_memory(&i, sizeof(i)));
+
+		// One block, same as hashing the memory.
+		point p = { 3, -4 };
+		TEST(vtb::hash<point>()(p) == hash_memory(&p, sizeof(p)));
+		point points[3] = { { 1, 2 }, { 3, 4 }, { 5, 6 } };
+		TEST(vtb::hash_values(points) == hash_memory(points, sizeof(points)));
+
+		std::pair<int32_t, int32_t> xy(3, -4);
+		TEST(vtb::hash_values(xy) == hash_memory(&p, sizeof(p)));
+
+		// Field by field is the same as hashing each field.
+		std::string name = "Ada";
+		people::person ada = { name, 'L', 1.65 };
+		vtb_hash fields = vtbh_new();
+		vtb::hash_append(fields, name);
+		vtb::hash_append(fields, 'L');
+		vtb::hash_append(fields, 1.65);
+		TEST(vtb::hash<people::person>()(ada) == fields.hash);
+
+		// Equal values hash the same.
+		TEST(vtb::hash_values(0.0f) == vtb::hash_values(-0.0f));
+		TEST(vtb::hash_values(0.0) == vtb::hash_values(-0.0));
+
+		// Where one value ends is part of the hash.
+		TEST(vtb::hash_values(std::string("ab"), std::string("c")) != vtb::hash_values(std::string("a"), std::string("bc")));
+		TEST(vtb::hash_values(std::vector<int>(2, 0), std::vector<int>()) != vtb::hash_values(std::vector<int>(1, 0), std::vector<int>(1, 0)));
+
+		std::vector<int32_t> ints = { 1, 2, 3 };
+		vtb_hash bulk = vtbh_new();
+		vtb::hash_append(bulk, (uint64_t)3);
+		vtbh_bytes(&bulk, (const unsigned char*)ints.data(), sizeof(int32_t)*3);
+		TEST(vtb::hash_values(ints) == bulk.hash);
+
+		std::vector<bool> bools = { true, false, true };
+		std::vector<bool> other_bools = { true, true, true };
+		TEST(vtb::hash_values(bools) != vtb::hash_values(other_bools));
+
+		std::tuple<int, std::string, float> tuple(1, "one", 1.0f);
+		TEST(vtb::hash_values(tuple) == vtb::hash_values(1, std::string("one"), 1.0f));
+
+		std::vector<std::pair<std::string, people::person>> nested = { { "first", ada } };
+		TEST(vtb::hash_values(nested) == vtb::hash_values((uint64_t)1, std::string("first"), ada));
+
+		// In the standard containers.
+		std::unordered_map<people::person, int, vtb::hash<people::person>> heights;
+		heights[ada] = 165;
+		TEST(heights.count(ada) == 1 && heights[ada] == 165);
+
+		std::unordered_set<point> seen;
+		seen.insert(p);
+		TEST(seen.count(p) == 1);
+		TEST(std::hash<point>()(p) == vtb::hash<point>()(p));
+	}
+
+	g_test = "crc32c";
+	{
+		vtb_crc32c c = vtbh_crc32c_new();
+		TEST(c.crc == 0);
+		vtbh_crc32c(&c, (const unsigned char*)"123456789", 9);
+		TEST(c.crc == 0xE3069283);
+
+		// 32 zeros, from RFC 3720.
+		unsigned char zeros[32] = { 0 };
+		c = vtbh_crc32c_new();
+		vtbh_crc32c(&c, zeros, sizeof(zeros));
+		TEST(c.crc == 0x8A9136AA);
+
+		// Against a bit at a time CRC, at sizes that go through the hardware
+		// version's big blocks, small blocks, words and bytes, and at every
+		// alignment.
+		const size_t data_size = 60000;
+		unsigned char* data = (unsigned char*)malloc(data_size + 8);
+		uint32_t state = 0x2545F491;
+		for (size_t k = 0; k < data_size + 8; k++)
+		{
+			state ^= state << 13;
+			state ^= state >> 17;
+			state ^= state << 5;
+			data[k] = (unsigned char)state;
+		}
+
+		size_t sizes[] = { 0, 1, 7, 8, 9, 767, 768, 769, 1543, 24575, 24576, 24577, 25343, data_size };
+		bool matches = true;
+		for (size_t offset = 0; offset < 8; offset++)
+		{
+			for (size_t s = 0; s < sizeof(sizes)/sizeof(sizes[0]); s++)
+			{
+				uint32_t expected = ~0u;
+				for (size_t k = 0; k < sizes[s]; k++)
+				{
+					expected ^= data[offset + k];
+					for (int bit = 0; bit < 8; bit++)
+						expected = expected & 1 ? (expected >> 1) ^ 0x82F63B78 : expected >> 1;
+				}
+				expected = ~expected;
+
+				c = vtbh_crc32c_new();
+				vtbh_crc32c(&c, data + offset, sizes[s]);
+				matches &= c.crc == expected;
+			}
+		}
+		TEST(matches);
+
+		vtb_crc32c whole = vtbh_crc32c_new();
+		vtbh_crc32c(&whole, data, data_size);
+
+		bool streamed_ok = true;
+		bool combined_ok = true;
+		for (size_t split = 0; split <= data_size; split += 2999)
+		{
+			vtb_crc32c first = vtbh_crc32c_new();
+			vtbh_crc32c(&first, data, split);
+
+			vtb_crc32c second = vtbh_crc32c_new();
+			vtbh_crc32c(&second, data + split, data_size - split);
+
+			combined_ok &= vtbh_crc32c_combine(first.crc, second.crc, data_size - split) == whole.crc;
+
+			vtbh_crc32c(&first, data + split, data_size - split);
+			streamed_ok &= first.crc == whole.crc;
+		}
+		TEST(streamed_ok);
+		TEST(combined_ok);
+
+		free(data);
+	}
+
 	return test;
 }
 
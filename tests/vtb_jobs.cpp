@@ -0,0 +1,229 @@
+#define VTB_JOBS_IMPLEMENTATION
+
+#include "../vtb_jobs.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <thread>
+
+const char* g_test;
+int g_line;
+
+static void catch_sigbus(int signal)
+{
+    printf("Bus error during test '%s' after line %d\n", g_test, g_line);
+    exit(1);
+}
+
+static void catch_sigfpe(int signal)
+{
+    printf("Floating point exception during test '%s' after line %d\n", g_test, g_line);
+    exit(1);
+}
+
+static void catch_sigill(int signal)
+{
+    printf("Illegal instruction during test '%s' after line %d\n", g_test, g_line);
+    exit(1);
+}
+
+static void catch_sigsegv(int signal)
+{
+    printf("Segfault during test '%s' after line %d\n", g_test, g_line);
+    exit(1);
+}
+
+#define TEST(x) g_line = __LINE__; { if (!(x)) { printf("Test '" #x "' on line %d during '%s' failed.\n", __LINE__, g_test); return 1; } }
+
+static vtb_jobs* g_jobs;
+
+static void increment(void* data)
+{
+	((std::atomic<int>*)data)->fetch_add(1);
+}
+
+struct fibonacci
+{
+	int n;
+	int64_t result;
+};
+
+// Spawns both children as jobs and waits on them, so every level of the
+// recursion is a job waiting on its children.
+static void fibonacci_job(void* data)
+{
+	fibonacci* f = (fibonacci*)data;
+
+	if (f->n < 2)
+	{
+		f->result = f->n;
+		return;
+	}
+
+	fibonacci a = { f->n - 1, 0 };
+	fibonacci b = { f->n - 2, 0 };
+
+	vtbj_counter children;
+	vtbj_run(g_jobs, fibonacci_job, &a, &children);
+	vtbj_run(g_jobs, fibonacci_job, &b, &children);
+	vtbj_wait(g_jobs, &children);
+
+	f->result = a.result + b.result;
+}
+
+static void mark_range(void* data, int64_t begin, int64_t end)
+{
+	std::atomic<int>* visits = (std::atomic<int>*)data;
+	for (int64_t k = begin; k < end; k++)
+		visits[k].fetch_add(1);
+}
+
+static std::atomic<int64_t> g_largest_piece;
+
+static void measure_range(void* data, int64_t begin, int64_t end)
+{
+	(void)data;
+
+	int64_t size = end - begin;
+	int64_t largest = g_largest_piece.load();
+	while (size > largest && !g_largest_piece.compare_exchange_weak(largest, size))
+		;
+}
+
+static int test_scheduler(int num_workers)
+{
+	g_jobs = vtbj_create(num_workers);
+
+	g_test = "Create";
+	if (num_workers >= 0)
+	{
+		TEST(vtbj_getnumworkers(g_jobs) == num_workers);
+	}
+
+	g_test = "Run and wait";
+	{
+		std::atomic<int> count(0);
+		vtbj_counter counter;
+
+		for (int k = 0; k < 100; k++)
+			vtbj_run(g_jobs, increment, &count, &counter);
+
+		vtbj_wait(g_jobs, &counter);
+		TEST(count == 100);
+		TEST(counter.m_value == 0);
+	}
+
+	g_test = "More jobs than fit in flight";
+	{
+		std::atomic<int> count(0);
+		vtbj_counter counter;
+
+		for (int k = 0; k < VTBJ_MAX_JOBS_PER_THREAD*3; k++)
+			vtbj_run(g_jobs, increment, &count, &counter);
+
+		vtbj_wait(g_jobs, &counter);
+		TEST(count == VTBJ_MAX_JOBS_PER_THREAD*3);
+	}
+
+	g_test = "Nested waits";
+	{
+		fibonacci f = { 20, 0 };
+		vtbj_counter counter;
+		vtbj_run(g_jobs, fibonacci_job, &f, &counter);
+		vtbj_wait(g_jobs, &counter);
+		TEST(f.result == 6765);
+	}
+
+	g_test = "Parallel for";
+	{
+		static const int size = 100003;
+		std::atomic<int>* visits = new std::atomic<int>[size];
+		for (int k = 0; k < size; k++)
+			visits[k] = 0;
+
+		vtbj_parallel_for(g_jobs, 0, size, mark_range, visits, 0);
+
+		int wrong = 0;
+		for (int k = 0; k < size; k++)
+			wrong += visits[k] != 1;
+		TEST(wrong == 0);
+
+		vtbj_parallel_for(g_jobs, 10, 20, mark_range, visits, 1);
+		TEST(visits[9] == 1 && visits[10] == 2 && visits[19] == 2 && visits[20] == 1);
+
+		// Empty ranges do nothing.
+		vtbj_parallel_for(g_jobs, 20, 20, mark_range, visits, 0);
+		vtbj_parallel_for(g_jobs, 20, 10, mark_range, visits, 0);
+		TEST(visits[20] == 1);
+
+		delete[] visits;
+	}
+
+	g_test = "Parallel for grain";
+	{
+		g_largest_piece = 0;
+		vtbj_parallel_for(g_jobs, 0, 1000, measure_range, 0, 7);
+		TEST(g_largest_piece <= 7 && g_largest_piece > 0);
+	}
+
+	g_test = "Submitting from several threads";
+	{
+		std::atomic<int> count(0);
+
+		std::thread threads[4];
+		for (int k = 0; k < 4; k++)
+		{
+			threads[k] = std::thread([&count]() {
+				vtbj_counter counter;
+				for (int j = 0; j < 1000; j++)
+					vtbj_run(g_jobs, increment, &count, &counter);
+				vtbj_wait(g_jobs, &counter);
+			});
+		}
+
+		for (int k = 0; k < 4; k++)
+			threads[k].join();
+
+		TEST(count == 4000);
+	}
+
+	g_test = "Submitting thread exits first";
+	{
+		std::atomic<int> count(0);
+		vtbj_counter counter;
+
+		// Its jobs can still be queued after it's gone.
+		std::thread submitter([&count, &counter]() {
+			for (int j = 0; j < 1000; j++)
+				vtbj_run(g_jobs, increment, &count, &counter);
+		});
+		submitter.join();
+
+		vtbj_wait(g_jobs, &counter);
+		TEST(count == 1000);
+	}
+
+	vtbj_destroy(g_jobs);
+
+	return 0;
+}
+
+int main()
+{
+	if (signal(SIGBUS, catch_sigbus) == SIG_ERR ||
+		signal(SIGFPE, catch_sigfpe) == SIG_ERR ||
+		signal(SIGILL, catch_sigill) == SIG_ERR ||
+		signal(SIGSEGV, catch_sigsegv) == SIG_ERR)
+	{
+		fputs("An error occurred while setting a signal handler.\n", stderr);
+		return 1;
+	}
+
+	// No workers means the waiting thread runs everything. -1 is one per
+	// core, minus this thread.
+	if (test_scheduler(1) || test_scheduler(4) || test_scheduler(0) || test_scheduler(-1))
+		return 1;
+
+	return 0;
+}
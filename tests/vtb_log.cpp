@@ -0,0 +1,291 @@
+#define VTB_LOG_IMPLEMENTATION
+#define VTB_ALLOC_RING_IMPLEMENTATION
+
+#include "../vtb_log.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <thread>
+#include <unistd.h>
+
+const char* g_test;
+int g_line;
+
+static void catch_sigbus(int signal)
+{
+    printf("Bus error during test '%s' after line %d\n", g_test, g_line);
+    exit(1);
+}
+
+static void catch_sigfpe(int signal)
+{
+    printf("Floating point exception during test '%s' after line %d\n", g_test, g_line);
+    exit(1);
+}
+
+static void catch_sigill(int signal)
+{
+    printf("Illegal instruction during test '%s' after line %d\n", g_test, g_line);
+    exit(1);
+}
+
+static void catch_sigsegv(int signal)
+{
+    printf("Segfault during test '%s' after line %d\n", g_test, g_line);
+    exit(1);
+}
+
+#define TEST(x) g_line = __LINE__; { if (!(x)) { printf("Test '" #x "' on line %d during '%s' failed.\n", __LINE__, g_test); return 1; } }
+
+enum color { red, green, blue };
+
+// Everything the log has written to file so far.
+static char g_output[4*1024*1024];
+
+static const char* read_output(FILE* file)
+{
+	fflush(file);
+	rewind(file);
+	size_t read = fread(g_output, 1, sizeof(g_output)-1, file);
+	g_output[read] = 0;
+	return g_output;
+}
+
+static int count_lines(const char* text, const char* prefix)
+{
+	int count = 0;
+	size_t length = strlen(prefix);
+	for (const char* line = text; *line; )
+	{
+		if (strncmp(line, prefix, length) == 0)
+			count++;
+
+		const char* end = strchr(line, '\n');
+		if (!end)
+			break;
+		line = end + 1;
+	}
+	return count;
+}
+
+static void log_from_thread(vtb_log* log, int thread, int count)
+{
+	for (int k = 0; k < count; k++)
+		while (!VTBL_LOG(log, "thread %d record %d\n", thread, k))
+			std::this_thread::yield();
+}
+
+int main()
+{
+	if (signal(SIGBUS, catch_sigbus) == SIG_ERR ||
+		signal(SIGFPE, catch_sigfpe) == SIG_ERR ||
+		signal(SIGILL, catch_sigill) == SIG_ERR ||
+		signal(SIGSEGV, catch_sigsegv) == SIG_ERR)
+	{
+		fputs("An error occurred while setting a signal handler.\n", stderr);
+		return 1;
+	}
+
+	g_test = "Formatting";
+
+	{
+		FILE* file = tmpfile();
+		vtb_log* log = vtbl_create(fileno(file));
+
+		char name[16];
+		strcpy(name, "mesh");
+
+		// Kept out of TEST, which would pass the formats on to printf.
+		bool logged = VTBL_LOG(log, "plain\n");
+		logged = VTBL_LOG(log, "%d %u %lld %llx\n", -5, 7u, -123456789012ll, 0xabcdef0123ull) && logged;
+		logged = VTBL_LOG(log, "%.2f %g %c\n", 1.5f, 0.25, 'x') && logged;
+		logged = VTBL_LOG(log, "%s loaded from %s\n", name, "disk") && logged;
+		logged = VTBL_LOG(log, "%d %s\n", (int)blue, (const char*)0) && logged;
+		logged = VTBL_LOG(log, "%d%%\n", 100) && logged;
+		vtbl_print(log, "text as it is %d\n");
+		TEST(logged);
+
+		const char* expected =
+			"plain\n"
+			"-5 7 -123456789012 abcdef0123\n"
+			"1.50 0.25 x\n"
+			"mesh loaded from disk\n"
+			"2 (null)\n"
+			"100%\n"
+			"text as it is %d\n";
+
+		// The string was copied, so changing it now doesn't matter.
+		strcpy(name, "gone");
+
+		vtbl_flush(log);
+
+		TEST(strcmp(read_output(file), expected) == 0);
+
+		TEST(vtbl_getnumdropped(log) == 0);
+
+		vtbl_destroy(log);
+		fclose(file);
+	}
+
+	g_test = "Destroy writes what's left";
+
+	{
+		FILE* file = tmpfile();
+		vtb_log* log = vtbl_create(fileno(file));
+
+		for (int k = 0; k < 100; k++)
+			VTBL_LOG(log, "record %d\n", k);
+
+		vtbl_destroy(log);
+
+		TEST(count_lines(read_output(file), "record ") == 100);
+		TEST(strstr(g_output, "record 0\nrecord 1\n") && strstr(g_output, "record 99\n"));
+		fclose(file);
+	}
+
+	g_test = "Long records";
+
+	{
+		FILE* file = tmpfile();
+		vtb_log* log = vtbl_create(fileno(file));
+
+		// Longer than the text buffer once formatted, so it's cut off.
+		static char wide[VTBL_TEXT_SIZE + 100];
+		memset(wide, 'w', sizeof(wide) - 1);
+		wide[sizeof(wide) - 1] = 0;
+
+		bool logged = VTBL_LOG(log, "%s", "before\n");
+		logged = VTBL_LOG(log, "%*d\n", VTBL_TEXT_SIZE + 100, 1) && logged;
+		logged = VTBL_LOG(log, "%s", "after\n") && logged;
+		TEST(logged);
+
+		// Too big for the ring at all.
+		logged = VTBL_LOG(log, "%s\n", wide);
+		TEST(!logged);
+		TEST(vtbl_getnumdropped(log) == 1);
+
+		vtbl_flush(log);
+
+		read_output(file);
+		TEST(strncmp(g_output, "vtb_log: dropped 1 records", 26) == 0);
+		TEST(strstr(g_output, "before\n"));
+		TEST(strstr(g_output, "after\n"));
+		TEST(strlen(g_output) < VTBL_TEXT_SIZE + 100);
+
+		vtbl_destroy(log);
+		fclose(file);
+	}
+
+	g_test = "Full ring drops";
+
+	{
+		FILE* file = tmpfile();
+		vtb_log* log = vtbl_create(fileno(file));
+
+		// Much more than fits in the ring before the flusher can get to it.
+		int written = 0;
+		for (int k = 0; k < 100000; k++)
+			written += VTBL_LOG(log, "record %d\n", k);
+
+		vtbl_flush(log);
+
+		TEST(written + vtbl_getnumdropped(log) == 100000);
+		TEST(count_lines(read_output(file), "record ") == written);
+
+		vtbl_destroy(log);
+		fclose(file);
+	}
+
+	g_test = "Threads";
+
+	{
+		FILE* file = tmpfile();
+		vtb_log* log = vtbl_create(fileno(file));
+
+		const int num_threads = 4;
+		const int per_thread = 5000;
+
+		std::thread threads[num_threads];
+		for (int k = 0; k < num_threads; k++)
+			threads[k] = std::thread(log_from_thread, log, k, per_thread);
+		for (int k = 0; k < num_threads; k++)
+			threads[k].join();
+
+		vtbl_flush(log);
+
+		// Every record is there, and each thread's are in order.
+		read_output(file);
+		TEST(count_lines(g_output, "thread ") == num_threads*per_thread);
+
+		bool in_order = true;
+		for (int k = 0; k < num_threads; k++)
+		{
+			int next = 0;
+			char prefix[32];
+			snprintf(prefix, sizeof(prefix), "thread %d record ", k);
+
+			for (const char* line = strstr(g_output, prefix); line; line = strstr(line + 1, prefix))
+				in_order = in_order && atoi(line + strlen(prefix)) == next++;
+
+			in_order = in_order && next == per_thread;
+		}
+		TEST(in_order);
+
+		vtbl_destroy(log);
+		fclose(file);
+	}
+
+	g_test = "Threads that exit";
+
+	{
+		FILE* file = tmpfile();
+		vtb_log* log = vtbl_create(fileno(file));
+
+		// Their rings are written out and freed once they're gone.
+		for (int k = 0; k < 64; k++)
+		{
+			std::thread thread(log_from_thread, log, k, 10);
+			thread.join();
+		}
+
+		vtbl_flush(log);
+
+		read_output(file);
+		TEST(count_lines(g_output, "thread ") == 64*10);
+		TEST(log->m_threads.load() == 0);
+
+		// A thread that outlives a log lets go of its ring for it.
+		VTBL_LOG(log, "thread %d record %d\n", 64, 0);
+		vtbl_destroy(log);
+		fclose(file);
+
+		file = tmpfile();
+		log = vtbl_create(fileno(file));
+		VTBL_LOG(log, "thread %d record %d\n", 64, 1);
+		TEST(vtbl__this_thread_exit.m_owned && !vtbl__this_thread_exit.m_owned->m_next_owned);
+		vtbl_destroy(log);
+		fclose(file);
+	}
+
+	g_test = "Debug print";
+
+	{
+		FILE* file = tmpfile();
+		vtb_log* log = vtbl_create(fileno(file));
+
+		vtbl_setdefault(log);
+		vtbl_debug_print("Assert failed: x (file.cpp:1)\n");
+		vtbl_debug_flush();
+
+		TEST(strcmp(read_output(file), "Assert failed: x (file.cpp:1)\n") == 0);
+
+		// Destroying the default log clears it.
+		vtbl_destroy(log);
+		vtbl_debug_flush();
+
+		fclose(file);
+	}
+
+	return 0;
+}
@@ -0,0 +1,223 @@
+#define VTB_IMPLEMENTATION
+#define VTB_HASH_IMPLEMENTATION
+#define VTB_TRACE_IMPLEMENTATION
+
+#include "../vtb_trace.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <thread>
+
+const char* g_test;
+int g_line;
+
+static void catch_sigbus(int signal)
+{
+    printf("Bus error during test '%s' after line %d\n", g_test, g_line);
+    exit(1);
+}
+
+static void catch_sigfpe(int signal)
+{
+    printf("Floating point exception during test '%s' after line %d\n", g_test, g_line);
+    exit(1);
+}
+
+static void catch_sigill(int signal)
+{
+    printf("Illegal instruction during test '%s' after line %d\n", g_test, g_line);
+    exit(1);
+}
+
+static void catch_sigsegv(int signal)
+{
+    printf("Segfault during test '%s' after line %d\n", g_test, g_line);
+    exit(1);
+}
+
+#define TEST(x) g_line = __LINE__; { if (!(x)) { printf("Test '" #x "' on line %d during '%s' failed.\n", __LINE__, g_test); return 1; } }
+
+static void profiled_work(int depth)
+{
+	VProfileZone("profiled_work");
+
+	if (depth > 0)
+		profiled_work(depth - 1);
+}
+
+static void profiled_thread()
+{
+	for (int k = 0; k < 100; k++)
+	{
+		VProfileZone("thread");
+		profiled_work(1);
+	}
+}
+
+// Every zone vtb.h has, in the order vtb_profile_foreach gives them.
+static vtbt_event g_expected[10000];
+static int g_num_expected;
+
+static void collect_event(void* data, uint32_t thread_id, const vtb_profile_event* event)
+{
+	vtbt_event* e = &g_expected[g_num_expected++];
+	e->m_thread_id = thread_id;
+	e->m_name = event->m_name;
+	e->m_begin = event->m_begin;
+	e->m_end = event->m_end;
+}
+
+// Writes the trace into memory.
+static uint8_t* write_trace(size_t* size)
+{
+	FILE* file = tmpfile();
+	if (!vtbt_write_profile(file))
+		return 0;
+
+	*size = (size_t)ftell(file);
+	rewind(file);
+
+	uint8_t* trace = (uint8_t*)malloc(*size);
+	*size = fread(trace, 1, *size, file);
+	fclose(file);
+
+	return trace;
+}
+
+int main()
+{
+	if (signal(SIGBUS, catch_sigbus) == SIG_ERR ||
+		signal(SIGFPE, catch_sigfpe) == SIG_ERR ||
+		signal(SIGILL, catch_sigill) == SIG_ERR ||
+		signal(SIGSEGV, catch_sigsegv) == SIG_ERR)
+	{
+		fputs("An error occurred while setting a signal handler.\n", stderr);
+		return 1;
+	}
+
+	vtbt_reader r;
+	vtbt_event e;
+	size_t size;
+	uint8_t* trace;
+
+	g_test = "Empty";
+
+	trace = write_trace(&size);
+	TEST(trace && size == 13);
+	TEST(vtbt_open(&r, trace, size));
+	TEST(!vtbt_next(&r, &e));
+	TEST(!vtbt_iscorrupt(&r));
+	TEST(vtbt_getnumnames(&r) == 0);
+	vtbt_close(&r);
+	free(trace);
+
+	g_test = "Round trip";
+
+	for (int k = 0; k < 1000; k++)
+	{
+		VProfileZone("outer");
+		profiled_work(2);
+	}
+
+	{
+		// The same name from a different pointer gets the same id.
+		static char name[16];
+		strcpy(name, "outer");
+		vtb_profile_record(name, 10, 20);
+
+		std::thread t(profiled_thread);
+		t.join();
+	}
+
+	g_num_expected = 0;
+	vtb_profile_foreach(collect_event, 0);
+	TEST(g_num_expected == 4000 + 1 + 300);
+
+	trace = write_trace(&size);
+	TEST(trace);
+
+	// Compact: a few bytes per zone.
+	TEST(size < (size_t)g_num_expected*6);
+
+	TEST(vtbt_open(&r, trace, size));
+	TEST(vtbt_getticksperus(&r) == vtb_profile_ticks_per_us());
+
+	{
+		bool same = true;
+		int num_read = 0;
+		while (vtbt_next(&r, &e))
+		{
+			const vtbt_event* expected = &g_expected[num_read++];
+			same = same && e.m_thread_id == expected->m_thread_id;
+			same = same && strcmp(e.m_name, expected->m_name) == 0;
+			same = same && e.m_begin == expected->m_begin;
+			same = same && e.m_end == expected->m_end;
+			same = same && strcmp(vtbt_getname(&r, e.m_name_id), e.m_name) == 0;
+		}
+		TEST(same);
+		TEST(num_read == g_num_expected);
+	}
+
+	TEST(!vtbt_iscorrupt(&r));
+	TEST(vtbt_getnumnames(&r) == 3);
+	vtbt_close(&r);
+
+	g_test = "Cut off";
+
+	// Every prefix reads correctly up to where it stops, and never reads
+	// past the end.
+	{
+		bool stopped_cleanly = true;
+		for (size_t cut = 13; cut < size; cut += 7)
+		{
+			uint8_t* prefix = (uint8_t*)malloc(cut);
+			memcpy(prefix, trace, cut);
+
+			vtbt_open(&r, prefix, cut);
+			int num_read = 0;
+			while (vtbt_next(&r, &e))
+				stopped_cleanly = stopped_cleanly && e.m_begin == g_expected[num_read++].m_begin;
+			stopped_cleanly = stopped_cleanly && num_read < g_num_expected;
+			vtbt_close(&r);
+
+			free(prefix);
+		}
+		TEST(stopped_cleanly);
+
+		// Cut inside a thread record it's corrupt.
+		TEST(vtbt_open(&r, trace, size - 1));
+		while (vtbt_next(&r, &e))
+			{}
+		TEST(vtbt_iscorrupt(&r));
+		vtbt_close(&r);
+	}
+
+	g_test = "Bad header";
+
+	TEST(!vtbt_open(&r, trace, 12));
+	trace[4] = VTBT_VERSION + 1;
+	TEST(!vtbt_open(&r, trace, size));
+	trace[4] = VTBT_VERSION;
+	trace[0] = 'X';
+	TEST(!vtbt_open(&r, trace, size));
+	trace[0] = 'V';
+
+	g_test = "Bad tag";
+
+	trace[13] = 99;
+	TEST(vtbt_open(&r, trace, size));
+	TEST(!vtbt_next(&r, &e));
+	TEST(vtbt_iscorrupt(&r));
+	vtbt_close(&r);
+
+	free(trace);
+
+	// Leave a trace behind for test.sh to run the decoder on.
+	FILE* file = fopen("vtb_trace_test.vtbt", "wb");
+	TEST(file);
+	TEST(vtbt_write_profile(file));
+	fclose(file);
+
+	return 0;
+}
@@ -0,0 +1,219 @@
+// vtb_trace_decode - converts a vtb_trace.h trace to Chrome trace JSON, or
+// summarizes it.
+//
+// Usage:
+//   vtb_trace_decode capture.vtbt > capture.json
+//   vtb_trace_decode -s capture.vtbt
+//
+// The JSON can be loaded into chrome://tracing or https://ui.perfetto.dev.
+// -s prints a table with one row per zone name instead, sorted by total
+// time.
+
+#define VTB_IMPLEMENTATION
+#define VTB_HASH_IMPLEMENTATION
+#define VTB_TRACE_IMPLEMENTATION
+
+#include "../vtb_trace.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+struct zone_stats
+{
+	uint32_t m_name_id;
+	uint64_t m_count;
+	uint64_t m_total;
+	uint64_t m_min;
+	uint64_t m_max;
+};
+
+static void write_json_string(FILE* file, const char* s)
+{
+	for (; *s; s++)
+	{
+		if (*s == '"' || *s == '\\')
+			fputc('\\', file);
+
+		if ((unsigned char)*s < 0x20)
+			fprintf(file, "\\u%04x", (unsigned char)*s);
+		else
+			fputc(*s, file);
+	}
+}
+
+static int write_chrome_trace(const uint8_t* data, size_t size, FILE* file)
+{
+	vtbt_reader r;
+	vtbt_event e;
+
+	// Make timestamps relative to the earliest zone to keep them short.
+	vtbt_open(&r, data, size);
+	uint64_t base = ~(uint64_t)0;
+	while (vtbt_next(&r, &e))
+		base = e.m_begin < base ? e.m_begin : base;
+	vtbt_close(&r);
+
+	vtbt_open(&r, data, size);
+	double ticks_per_us = vtbt_getticksperus(&r);
+
+	fputs("{\"traceEvents\":[", file);
+
+	const char* separator = "\n";
+	while (vtbt_next(&r, &e))
+	{
+		fprintf(file, "%s{\"name\":\"", separator);
+		write_json_string(file, e.m_name);
+		fprintf(file, "\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+			e.m_thread_id,
+			(double)(e.m_begin - base) / ticks_per_us,
+			(double)(e.m_end - e.m_begin) / ticks_per_us);
+
+		separator = ",\n";
+	}
+
+	fputs("\n]}\n", file);
+
+	int corrupt = vtbt_iscorrupt(&r);
+	vtbt_close(&r);
+	return !corrupt;
+}
+
+static int compare_total(const void* a, const void* b)
+{
+	const zone_stats* x = (const zone_stats*)a;
+	const zone_stats* y = (const zone_stats*)b;
+
+	if (x->m_total != y->m_total)
+		return x->m_total > y->m_total ? -1 : 1;
+
+	return x->m_name_id < y->m_name_id ? -1 : (x->m_name_id > y->m_name_id);
+}
+
+static int write_stats(const uint8_t* data, size_t size, FILE* file)
+{
+	vtbt_reader r;
+	vtbt_open(&r, data, size);
+
+	zone_stats* stats = 0;
+	uint32_t num_stats = 0;
+	uint64_t num_zones = 0;
+	uint32_t threads[64];
+	uint32_t num_threads = 0;
+
+	vtbt_event e;
+	while (vtbt_next(&r, &e))
+	{
+		if (e.m_name_id >= num_stats)
+		{
+			uint32_t new_num_stats = vtbt_getnumnames(&r);
+			stats = (zone_stats*)realloc(stats, new_num_stats*sizeof(zone_stats));
+			for (uint32_t k = num_stats; k < new_num_stats; k++)
+			{
+				memset(&stats[k], 0, sizeof(zone_stats));
+				stats[k].m_name_id = k;
+				stats[k].m_min = ~(uint64_t)0;
+			}
+			num_stats = new_num_stats;
+		}
+
+		uint64_t duration = e.m_end - e.m_begin;
+		zone_stats* s = &stats[e.m_name_id];
+		s->m_count++;
+		s->m_total += duration;
+		s->m_min = duration < s->m_min ? duration : s->m_min;
+		s->m_max = duration > s->m_max ? duration : s->m_max;
+
+		num_zones++;
+
+		uint32_t t = 0;
+		while (t < num_threads && threads[t] != e.m_thread_id)
+			t++;
+		if (t == num_threads && num_threads < sizeof(threads)/sizeof(threads[0]))
+			threads[num_threads++] = e.m_thread_id;
+	}
+
+	double ticks_per_us = vtbt_getticksperus(&r);
+
+	fprintf(file, "%llu zones, %u names, %u%s threads, %zu bytes (%.2f bytes per zone)\n\n",
+		(unsigned long long)num_zones, vtbt_getnumnames(&r), num_threads,
+		num_threads == sizeof(threads)/sizeof(threads[0]) ? "+" : "",
+		size, num_zones ? (double)size / (double)num_zones : 0.0);
+
+	qsort(stats, num_stats, sizeof(zone_stats), compare_total);
+
+	fprintf(file, "%12s %14s %12s %12s %12s  %s\n", "count", "total ms", "mean us", "min us", "max us", "zone");
+	for (uint32_t k = 0; k < num_stats; k++)
+	{
+		zone_stats* s = &stats[k];
+		if (!s->m_count)
+			continue;
+
+		fprintf(file, "%12llu %14.3f %12.3f %12.3f %12.3f  %s\n",
+			(unsigned long long)s->m_count,
+			(double)s->m_total / ticks_per_us / 1000,
+			(double)s->m_total / ticks_per_us / (double)s->m_count,
+			(double)s->m_min / ticks_per_us,
+			(double)s->m_max / ticks_per_us,
+			vtbt_getname(&r, s->m_name_id));
+	}
+
+	free(stats);
+
+	int corrupt = vtbt_iscorrupt(&r);
+	vtbt_close(&r);
+	return !corrupt;
+}
+
+int main(int argc, char** argv)
+{
+	int stats = 0;
+	const char* path = 0;
+
+	for (int k = 1; k < argc; k++)
+	{
+		if (strcmp(argv[k], "-s") == 0)
+			stats = 1;
+		else if (!path)
+			path = argv[k];
+		else
+			path = 0, k = argc;
+	}
+
+	if (!path)
+	{
+		fputs("usage: vtb_trace_decode [-s] trace.vtbt\n", stderr);
+		return 2;
+	}
+
+	FILE* file = fopen(path, "rb");
+	if (!file)
+	{
+		fprintf(stderr, "vtb_trace_decode: can't open %s\n", path);
+		return 1;
+	}
+
+	fseek(file, 0, SEEK_END);
+	long size = ftell(file);
+	rewind(file);
+
+	uint8_t* data = (uint8_t*)malloc(size > 0 ? (size_t)size : 1);
+	size_t read = fread(data, 1, size > 0 ? (size_t)size : 0, file);
+	fclose(file);
+
+	vtbt_reader r;
+	if (!vtbt_open(&r, data, read))
+	{
+		fprintf(stderr, "vtb_trace_decode: %s isn't a version %d trace\n", path, VTBT_VERSION);
+		free(data);
+		return 1;
+	}
+	vtbt_close(&r);
+
+	int ok = stats ? write_stats(data, read, stdout) : write_chrome_trace(data, read, stdout);
+	if (!ok)
+		fprintf(stderr, "vtb_trace_decode: %s is cut off or corrupt, the output stops there\n", path);
+
+	free(data);
+	return ok ? 0 : 1;
+}
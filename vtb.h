@@ -42,11 +42,35 @@ COMPILING AND LINKING
 
 #ifdef __clang__
 #define VINLINE __attribute__((always_inline)) inline
+#define VNOINLINE __attribute__((noinline))
+#define VCOLD __attribute__((cold))
 #else
 #error "Unsupported compiler"
 #endif
 
 
+// VLikely/VUnlikely - Tell the optimizer which way a branch usually goes, so it
+// can lay the common path out straight and move the other one out of the way.
+//
+// Example:
+// if (VUnlikely(!buffer))
+//   return grow();
+//
+#define VLikely(x) __builtin_expect(!!(x), 1)
+#define VUnlikely(x) __builtin_expect(!!(x), 0)
+
+
+// VAssume(x) - Promises the optimizer that x is true. If it isn't, behavior
+// is undefined, so only use it for things that have already been checked.
+// x is still evaluated.
+
+#define VAssume(x) \
+do { \
+	if (!(x)) \
+		__builtin_unreachable(); \
+} while (0)
+
+
 // VDebugBreak - Forces a trap to break to the debugger
 
 #ifdef __GNUC__
@@ -86,26 +110,50 @@ COMPILING AND LINKING
 // The Windows equivalent is OutputDebugString.
 VTBDEF void vtb_debug_print(const char* text);
 
+// vtb_debug_flush - Makes sure everything passed to vtb_debug_print so far
+// has come out. Failed asserts call it before they break.
+VTBDEF void vtb_debug_flush();
+
+// vtb_set_debug_print - Sends vtb_debug_print somewhere else, like the
+// asynchronous logger in vtb_log.h, so asserts and stubs don't block on
+// stdio. flush may be 0 if print doesn't buffer. Pass 0 for print to go back
+// to the default. Set it before other threads start printing.
+typedef void (*vtb_debug_print_function)(const char* text);
+typedef void (*vtb_debug_flush_function)();
+VTBDEF void vtb_set_debug_print(vtb_debug_print_function print, vtb_debug_flush_function flush);
+
 
 
 
 
 // VAssert(x) - Triggers a breakpoint if x is false.
+//
+// All of the failure handling except the breakpoint itself lives in
+// vtb_assert_failed, which is marked cold and never inlined. A passing
+// VAssert costs a compare and a branch that's predicted not taken, and the
+// caller stays small enough to inline. The breakpoint stays at the call
+// site so the debugger stops on the line that failed.
+//
+// If VTB_DISABLE_ASSERTS is defined, x is still evaluated but nothing is
+// checked. Also define VTB_ASSUME_ASSERTS and the optimizer is told that x is
+// true, as in VAssume. Only do that if your asserts never fire. VCheck,
+// VUnimplemented and VUntested mark things that can happen, so they are never
+// assumed, only evaluated.
 
-#if !defined(VTB_DISABLE_ASSERTS)
+// Prints the failed expression and where it was. expression and file are
+// the string literals from the call site.
+VTBDEF VCOLD VNOINLINE void vtb_assert_failed(const char* expression, const char* file, int line);
 
-#include <stdio.h>
+#if !defined(VTB_DISABLE_ASSERTS)
 
 #define VAssert(x) \
 do { \
 	VPRAGMA_WARNING_PUSH \
 	VPRAGMA_WARNING_DISABLE(4127) /* conditional expression is constant */ \
-	if (!(x)) \
+	if (VUnlikely(!(x))) \
 	VPRAGMA_WARNING_POP \
 	{ \
-		char vbuf[1024]; \
-		sprintf(vbuf, "Assert failed: %s (%s:%d)\n", #x, __FILE__, __LINE__); \
-		vtb_debug_print(vbuf); \
+		vtb_assert_failed(#x, __FILE__, __LINE__); \
 		VDebugBreak(); \
 	} \
 	VPRAGMA_WARNING_PUSH \
@@ -113,9 +161,11 @@ do { \
 } while (0) \
 VPRAGMA_WARNING_POP \
 
+#define VTB__VERIFY(x) VAssert(x)
+
 #else
 
-#define VAssert(x) do { \
+#define VTB__VERIFY(x) do { \
 	VPRAGMA_WARNING_PUSH \
 	VPRAGMA_WARNING_DISABLE(4127) /* conditional expression is constant */ \
 	if (!(x)) /* Still use the value so that the compiler doesn't complain about unused values. */ \
@@ -126,6 +176,12 @@ VPRAGMA_WARNING_POP \
 } while (0) \
 VPRAGMA_WARNING_POP \
 
+#if defined(VTB_ASSUME_ASSERTS)
+#define VAssert(x) VAssume(x)
+#else
+#define VAssert(x) VTB__VERIFY(x)
+#endif
+
 #endif
 
 
@@ -138,7 +194,7 @@ VPRAGMA_WARNING_POP \
 // unexpected happened. Generally use VCheck for things like checking function
 // parameters, and other things that you can recover from, and VAssert for
 // things that the program should die if they go wrong.
-#define VCheck(x) VAssert(x)
+#define VCheck(x) VTB__VERIFY(x)
 
 
 
@@ -166,7 +222,7 @@ VPRAGMA_WARNING_POP \
 	} while (0)
 #else
 // If you hit this, the code is incomple
-#define VUnimplemented() VAssert(false)
+#define VUnimplemented() VTB__VERIFY(false)
 #endif
 
 
@@ -179,7 +235,7 @@ VPRAGMA_WARNING_POP \
 // in mind, but I don't want to invest the time to debug the code. If you see
 // this, it means you shouldn't take for granted that the code has been debugged.
 
-#define VUntested() VAssert(false)
+#define VUntested() VTB__VERIFY(false)
 
 
 
@@ -261,6 +317,97 @@ VPRAGMA_WARNING_POP \
 
 
 
+// VScratchBuffer - A temporary array that stays on the stack when it's small
+
+// Usage:
+// void blur(const float* pixels, int count)
+// {
+//     VScratchBuffer<float, 256> temp(count);
+//     for (int k = 0; k < count; k++)
+//         temp[k] = ...
+// } <-- Released here, wherever it came from.
+//
+// Up to N elements are stored inside the object itself, so the common case
+// costs nothing. Bigger requests come from a per-thread arena of
+// VTB_SCRATCH_ARENA_SIZE bytes that is handed out and given back in scope
+// order, and if that's full, from malloc. Unlike VStackAllocate, a large or
+// untrusted size can't overflow the stack. Elements are default
+// constructed and destroyed like a plain array. It can't be copied or
+// moved, which is what keeps arena releases in order.
+//
+// VScratchAllocate(type, name, size) can replace VStackAllocate. It keeps up
+// to VTB_SCRATCH_INLINE_BYTES on the stack.
+
+#ifndef VTB_SCRATCH_ARENA_SIZE
+#define VTB_SCRATCH_ARENA_SIZE (1024*1024)
+#endif
+
+#ifndef VTB_SCRATCH_INLINE_BYTES
+#define VTB_SCRATCH_INLINE_BYTES 1024
+#endif
+
+#include <stddef.h>
+#include <cstddef> // For std::max_align_t
+#include <new>
+
+// Returns bytes of memory aligned to alignment from the thread's scratch arena,
+// or from malloc if it doesn't fit. Pass the returned mark to vtb_scratch_free.
+// Frees must come in the reverse order of allocations. Both the arena and
+// malloc only go up to alignof(std::max_align_t).
+VTBDEF void* vtb_scratch_alloc(size_t bytes, size_t alignment, size_t* mark);
+VTBDEF void vtb_scratch_free(void* memory, size_t mark);
+
+// Returns how many bytes of the calling thread's scratch arena are in use.
+VTBDEF size_t vtb_scratch_arena_used();
+
+template <typename T, size_t N>
+struct VScratchBuffer {
+	static_assert(N > 0, "VScratchBuffer needs room for at least one element inline");
+	static_assert(alignof(T) <= alignof(std::max_align_t), "VScratchBuffer can't align T more than malloc does");
+
+	VScratchBuffer(size_t count) : m_count(count), m_mark(0) {
+		if (count <= N)
+			m_data = (T*)m_inline;
+		else
+		{
+			VCheck(count <= ~(size_t)0 / sizeof(T));
+			m_data = (T*)vtb_scratch_alloc(count*sizeof(T), alignof(T), &m_mark);
+		}
+
+		for (size_t k = 0; k < m_count; k++)
+			new (&m_data[k]) T;
+	}
+
+	~VScratchBuffer() {
+		for (size_t k = 0; k < m_count; k++)
+			m_data[k].~T();
+
+		if (m_data != (T*)m_inline)
+			vtb_scratch_free(m_data, m_mark);
+	}
+
+	T* data() { return m_data; }
+	size_t size() const { return m_count; }
+	T& operator[](size_t i) { return m_data[i]; }
+	const T& operator[](size_t i) const { return m_data[i]; }
+
+	VScratchBuffer(const VScratchBuffer&) = delete;
+	VScratchBuffer& operator=(const VScratchBuffer&) = delete;
+
+	T* m_data;
+	size_t m_count;
+	size_t m_mark;
+	alignas(T) unsigned char m_inline[N*sizeof(T)];
+};
+
+#define VScratchAllocate(type, name, size) \
+    VScratchBuffer<type, (VTB_SCRATCH_INLINE_BYTES/sizeof(type) ? VTB_SCRATCH_INLINE_BYTES/sizeof(type) : 1)> VStringConcat2(name, _scratch)(size); \
+    type* name = VStringConcat2(name, _scratch).data()
+
+
+
+
+
 // VDefer - A defer statement for C++
 
 // Usage:
@@ -294,32 +441,346 @@ VDeferrer<F> MakeVDeferrer(F f) {
 
 
 
+// VProfileZone - Times the enclosing scope and records it for later export.
+
+// Usage:
+// void update()
+// {
+//     VProfileZone("update");
+//     ... stuff
+// } <-- The zone ends here.
+//
+// ...
+// vtb_profile_write_chrome_trace(fopen("trace.json", "w"));
+//
+// The name must be a string literal, or otherwise live as long as the
+// program, because only the pointer is recorded. Open chrome://tracing or
+// https://ui.perfetto.dev and load the file to see the zones.
+//
+// Each thread records into its own ring of VTB_PROFILE_MAX_EVENTS events,
+// so recording never takes a lock or touches a shared cache line. When the
+// ring is full the oldest events are overwritten. The ring is allocated the
+// first time a thread records a zone and is kept after the thread exits so
+// that its zones are still exported, until vtb_profile_reset frees it. A
+// program that keeps starting short lived threads should reset now and then,
+// each ring is about VTB_PROFILE_MAX_EVENTS*24 bytes. Export while the
+// recording threads are quiet, otherwise events that are being overwritten
+// may come out torn.
+//
+// Timestamps come from std::chrono::steady_clock, which is clock_gettime()
+// (through the vDSO) on Linux. #define VTB_PROFILE_RDTSC to read the x86
+// timestamp counter instead, which is cheaper. The exporter calibrates it.
+//
+// #define VTB_DISABLE_PROFILE to compile every VProfileZone to nothing.
+
+#ifndef VTB_PROFILE_MAX_EVENTS
+#define VTB_PROFILE_MAX_EVENTS 16384 // Per thread. Must be a power of two.
+#endif
+
+#include <stdio.h>
+#include <stdint.h>
+
+#if defined(VTB_PROFILE_RDTSC) && (defined(__i386__) || defined(__x86_64__))
+#include <x86intrin.h>
+#define VTB__PROFILE_TSC
+#else
+#include <chrono>
+#endif
+
+typedef struct
+{
+	const char* m_name;
+	uint64_t m_begin;
+	uint64_t m_end;
+} vtb_profile_event;
+
+// Returns the current timestamp in profile ticks. Ticks are nanoseconds
+// unless VTB_PROFILE_RDTSC is defined.
+inline uint64_t vtb_profile_ticks()
+{
+#ifdef VTB__PROFILE_TSC
+	return __rdtsc();
+#else
+	return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+// Records one finished zone into the calling thread's ring.
+VTBDEF void vtb_profile_record(const char* name, uint64_t begin, uint64_t end);
+
+// Writes every recorded zone of every thread as Chrome trace event JSON.
+VTBDEF void vtb_profile_write_chrome_trace(FILE* file);
+
+// Calls function(data, thread_id, event) for every recorded zone, one thread
+// at a time, oldest first within a thread. For writing zones out in your own
+// format, like vtb_trace.h does. Same caveat as export about busy threads.
+typedef void (*vtb_profile_event_function)(void* data, uint32_t thread_id, const vtb_profile_event* event);
+VTBDEF void vtb_profile_foreach(vtb_profile_event_function function, void* data);
+
+// Returns the number of profile ticks in a microsecond. This is 1000 unless
+// VTB_PROFILE_RDTSC is defined, in which case it's measured.
+VTBDEF double vtb_profile_ticks_per_us();
+
+// Forgets every recorded zone and frees the rings of threads that have
+// exited. Don't call it while other threads are recording.
+VTBDEF void vtb_profile_reset();
+
+struct VProfileScope {
+	VProfileScope(const char* name) : name(name), begin(vtb_profile_ticks()) {}
+	~VProfileScope() { vtb_profile_record(name, begin, vtb_profile_ticks()); }
+	const char* name;
+	uint64_t begin;
+};
+
+#if !defined(VTB_DISABLE_PROFILE)
+#define VProfileZone(name) \
+    VProfileScope VStringConcat2(profile_zone_, __LINE__)(name)
+#else
+#define VProfileZone(name)
+#endif
+
+
+
+
+
+// VCounter and VHistogram - Cheap metrics for hot code paths.
+
+// Usage:
+// void* alloc(int size)
+// {
+//     VCounter("allocs", 1);
+//     VHistogram("alloc size", size);
+//     ... stuff
+// }
+//
+// ...
+// uint64_t allocs = vtb_counter_read("allocs");
+// uint64_t p99 = vtb_histogram_percentile("alloc size", 99);
+// vtb_metrics_write(stdout);
+//
+// Like VProfileZone the name must live as long as the program. Each call
+// site gets its own storage. Reading by name adds up every call site that
+// uses that name.
+//
+// Storage is split into VTB_METRIC_SHARDS cache line sized shards and each
+// thread is assigned one, so threads on different cores don't bounce the
+// same cache line between them. The shards are only added up when read.
+// An update is one relaxed atomic add to the thread's shard, which doesn't
+// contend unless there are more threads than shards.
+//
+// Histograms use log-linear buckets like HdrHistogram: every power of two is
+// split into 2^VTB_HISTOGRAM_SUB_BUCKET_BITS linear buckets, so any value
+// from 0 to 2^64-1 is recorded with a bounded relative error (12.5% with
+// the default of 3 bits) in a fixed number of buckets.
+//
+// #define VTB_DISABLE_METRICS to compile every VCounter and VHistogram to nothing.
+
+#ifndef VTB_METRIC_SHARDS
+#define VTB_METRIC_SHARDS 16 // Must be a power of two.
+#endif
+
+#ifndef VTB_HISTOGRAM_SUB_BUCKET_BITS
+#define VTB_HISTOGRAM_SUB_BUCKET_BITS 3
+#endif
+
+#define VTB_HISTOGRAM_BUCKETS ((65 - VTB_HISTOGRAM_SUB_BUCKET_BITS) << VTB_HISTOGRAM_SUB_BUCKET_BITS)
+
+#include <atomic>
+
+struct vtb_metric
+{
+	const char* m_name;
+	int m_is_histogram;
+	vtb_metric* m_next;
+};
+
+struct vtb_counter : vtb_metric
+{
+	vtb_counter(const char* name);
+
+	struct alignas(64) shard
+	{
+		std::atomic<uint64_t> m_value;
+	};
+
+	shard m_shards[VTB_METRIC_SHARDS];
+};
+
+struct vtb_histogram : vtb_metric
+{
+	vtb_histogram(const char* name);
+
+	struct alignas(64) shard
+	{
+		std::atomic<uint64_t> m_sum;
+		std::atomic<uint64_t> m_buckets[VTB_HISTOGRAM_BUCKETS];
+	};
+
+	shard m_shards[VTB_METRIC_SHARDS];
+};
+
+// Assigns the calling thread a shard. Threads are dealt out round robin.
+VTBDEF uint32_t vtb__metric_assign_shard();
+
+inline uint32_t vtb__metric_shard()
+{
+	static thread_local uint32_t shard = vtb__metric_assign_shard();
+	return shard;
+}
+
+inline uint32_t vtb_histogram_bucket(uint64_t value)
+{
+	if (value < (1 << VTB_HISTOGRAM_SUB_BUCKET_BITS))
+		return (uint32_t)value;
+
+	uint32_t shift = 63 - __builtin_clzll(value) - VTB_HISTOGRAM_SUB_BUCKET_BITS;
+	return ((shift + 1) << VTB_HISTOGRAM_SUB_BUCKET_BITS) + (uint32_t)((value >> shift) & ((1 << VTB_HISTOGRAM_SUB_BUCKET_BITS) - 1));
+}
+
+// The largest value that lands in the bucket.
+inline uint64_t vtb_histogram_bucket_value(uint32_t bucket)
+{
+	if (bucket < (1 << VTB_HISTOGRAM_SUB_BUCKET_BITS))
+		return bucket;
+
+	uint32_t shift = (bucket >> VTB_HISTOGRAM_SUB_BUCKET_BITS) - 1;
+	uint64_t lowest = (uint64_t)((1 << VTB_HISTOGRAM_SUB_BUCKET_BITS) + (bucket & ((1 << VTB_HISTOGRAM_SUB_BUCKET_BITS) - 1))) << shift;
+	return lowest + (((uint64_t)1 << shift) - 1);
+}
+
+inline void vtb_counter_add(vtb_counter* counter, uint64_t n)
+{
+	counter->m_shards[vtb__metric_shard() & (VTB_METRIC_SHARDS-1)].m_value.fetch_add(n, std::memory_order_relaxed);
+}
+
+inline void vtb_histogram_add(vtb_histogram* histogram, uint64_t value)
+{
+	vtb_histogram::shard* shard = &histogram->m_shards[vtb__metric_shard() & (VTB_METRIC_SHARDS-1)];
+	shard->m_buckets[vtb_histogram_bucket(value)].fetch_add(1, std::memory_order_relaxed);
+	shard->m_sum.fetch_add(value, std::memory_order_relaxed);
+}
+
+// Returns the total of every counter with this name.
+VTBDEF uint64_t vtb_counter_read(const char* name);
+
+// Returns how many values were recorded into histograms with this name.
+VTBDEF uint64_t vtb_histogram_count(const char* name);
+
+// Returns the mean of the values recorded into histograms with this name.
+VTBDEF double vtb_histogram_mean(const char* name);
+
+// Returns the value that percentile (0-100) of recorded values are at or
+// below, rounded up to the top of its bucket.
+VTBDEF uint64_t vtb_histogram_percentile(const char* name, double percentile);
+
+// Writes every counter and histogram, one per line.
+VTBDEF void vtb_metrics_write(FILE* file);
+
+// Zeroes every counter and histogram.
+VTBDEF void vtb_metrics_reset();
+
+#if !defined(VTB_DISABLE_METRICS)
+
+#define VCounter(name, n) \
+do { \
+	static vtb_counter vtb__counter(name); \
+	vtb_counter_add(&vtb__counter, (uint64_t)(n)); \
+} while (0)
+
+#define VHistogram(name, value) \
+do { \
+	static vtb_histogram vtb__histogram(name); \
+	vtb_histogram_add(&vtb__histogram, (uint64_t)(value)); \
+} while (0)
+
+#else
+
+#define VCounter(name, n) do { (void)sizeof(n); } while (0)
+#define VHistogram(name, value) do { (void)sizeof(value); } while (0)
+
+#endif
+
+
+
+
+
 // VArraySize - A macro for anything defined in the format: type name[size];
 // VArraySize(name) will return size.
 // Note: It only works on the original array, not on a pointer to that array.
 #define VArraySize(x) (sizeof(x)/sizeof(x[0]))
 
-// Rounds x up to the nearest multiple of n. Useful for aligning memory.
-template<typename T>
-T VAlign(T x, T n)
+// Bit utilities. These work on any integer type, map to single instructions
+// through the compiler builtins, and are constexpr, so with constant
+// arguments they fold away entirely.
+
+#include <type_traits>
+
+// VClz(x) - The number of zero bits above the highest set bit of x, counting
+// only the bits of x's type. x can't be 0.
+template <typename T>
+constexpr int VClz(T x)
+{
+	return sizeof(T) <= sizeof(unsigned int)
+		? __builtin_clz((unsigned int)(typename std::make_unsigned<T>::type)x) - (int)(8*(sizeof(unsigned int) - sizeof(T)))
+		: __builtin_clzll((unsigned long long)(typename std::make_unsigned<T>::type)x) - (int)(8*(sizeof(unsigned long long) - sizeof(T)));
+}
+
+// VCtz(x) - The number of zero bits below the lowest set bit of x. x can't be 0.
+template <typename T>
+constexpr int VCtz(T x)
 {
-	T over = x%n;
-	return over?(x+n-over):x;
+	return sizeof(T) <= sizeof(unsigned int)
+		? __builtin_ctz((unsigned int)(typename std::make_unsigned<T>::type)x)
+		: __builtin_ctzll((unsigned long long)(typename std::make_unsigned<T>::type)x);
 }
 
-// Rounds v up to the next highest multiple of 2.
-inline int VPo2(int v)
+// VPopCount(x) - The number of set bits in x.
+template <typename T>
+constexpr int VPopCount(T x)
 {
-	// From https://graphics.stanford.edu/~seander/bithacks.html#RoundUpPowerOf2
-	v--;
-	v |= v >> 1;
-	v |= v >> 2;
-	v |= v >> 4;
-	v |= v >> 8;
-	v |= v >> 16;
-	v++;
+	return sizeof(T) <= sizeof(unsigned int)
+		? __builtin_popcount((unsigned int)(typename std::make_unsigned<T>::type)x)
+		: __builtin_popcountll((unsigned long long)(typename std::make_unsigned<T>::type)x);
+}
+
+// VLog2(x) - The index of the highest set bit of x, ie log2 rounded down.
+// x must be more than 0.
+template <typename T>
+constexpr int VLog2(T x)
+{
+	return (int)(8*sizeof(T)) - 1 - VClz(x);
+}
 
-	return v;
+// VIsPo2(x) - True if x is a power of 2.
+template <typename T>
+constexpr bool VIsPo2(T x)
+{
+	return x > 0 && !(x & (x - 1));
+}
+
+// VPo2(v) - Rounds v up to the next power of 2. 0 and 1 stay the same. v
+// can't be negative, and for unsigned types it's 0 if the power of 2
+// doesn't fit.
+template <typename T>
+constexpr T VPo2(T v)
+{
+	return v <= 1 ? v : (T)((typename std::make_unsigned<T>::type)2 << VLog2(v - 1));
+}
+
+// VAlignPo2(x, n) - Rounds x up to the nearest multiple of n, which must be
+// a power of 2. A mask instead of VAlign's division.
+template <typename T>
+constexpr T VAlignPo2(T x, T n)
+{
+	return (x + n - 1) & ~(n - 1);
+}
+
+// Rounds x up to the nearest multiple of n. Useful for aligning memory.
+// Alignments are nearly always powers of 2, so those skip the division.
+template<typename T>
+constexpr T VAlign(T x, T n)
+{
+	return VIsPo2(n) ? VAlignPo2(x, n) : (x%n ? x + n - x%n : x);
 }
 
 
@@ -365,22 +826,490 @@ inline int vtb__snprintf(char *outBuf, size_t size, const char *format, ...)
 #ifdef VTB_IMPLEMENTATION
 
 #ifdef __ANDROID__
-VTBDEF void vtb_debug_print(const char* text)
+static void vtb__debug_print_default(const char* text)
 {
 	__android_log_print(ANDROID_LOG_INFO, "Debug", "%s", text);
 }
 #elif defined(_MSC_VER)
 #include <windows.h>
-VTBDEF void vtb_debug_print(const char* text)
+static void vtb__debug_print_default(const char* text)
 {
 	OutputDebugStringA(text);
 }
 #else
 #include <stdio.h>
-VTBDEF void vtb_debug_print(const char* text)
+static void vtb__debug_print_default(const char* text)
 {
 	puts(text);
 }
 #endif
 
+static vtb_debug_print_function vtb__debug_print = vtb__debug_print_default;
+static vtb_debug_flush_function vtb__debug_flush = 0;
+
+VTBDEF void vtb_debug_print(const char* text)
+{
+	vtb__debug_print(text);
+}
+
+VTBDEF void vtb_debug_flush()
+{
+	if (vtb__debug_flush)
+		vtb__debug_flush();
+}
+
+VTBDEF void vtb_set_debug_print(vtb_debug_print_function print, vtb_debug_flush_function flush)
+{
+	vtb__debug_print = print ? print : vtb__debug_print_default;
+	vtb__debug_flush = print ? flush : 0;
+}
+
+#include <stdlib.h>
+
+struct vtb__scratch_arena
+{
+	~vtb__scratch_arena() { free(m_memory); }
+
+	unsigned char* m_memory;
+	size_t m_used;
+};
+
+static thread_local vtb__scratch_arena vtb__this_scratch_arena;
+
+VTBDEF void* vtb_scratch_alloc(size_t bytes, size_t alignment, size_t* mark)
+{
+	VCheck(alignment && alignment <= alignof(std::max_align_t));
+
+	vtb__scratch_arena* arena = &vtb__this_scratch_arena;
+
+	if (!arena->m_memory)
+		arena->m_memory = (unsigned char*)malloc(VTB_SCRATCH_ARENA_SIZE);
+
+	size_t start = VAlign(arena->m_used, alignment);
+	if (arena->m_memory && start <= VTB_SCRATCH_ARENA_SIZE && bytes <= VTB_SCRATCH_ARENA_SIZE - start)
+	{
+		*mark = arena->m_used;
+		arena->m_used = start + bytes;
+		return arena->m_memory + start;
+	}
+
+	*mark = ~(size_t)0;
+
+	void* memory = malloc(bytes);
+	VCheck(memory);
+	return memory;
+}
+
+VTBDEF void vtb_scratch_free(void* memory, size_t mark)
+{
+	if (mark == ~(size_t)0)
+	{
+		free(memory);
+		return;
+	}
+
+	vtb__scratch_arena* arena = &vtb__this_scratch_arena;
+	VAssert(memory >= arena->m_memory && memory < arena->m_memory + arena->m_used); // Freed on the wrong thread, or out of order.
+	arena->m_used = mark;
+}
+
+VTBDEF size_t vtb_scratch_arena_used()
+{
+	return vtb__this_scratch_arena.m_used;
+}
+
+VTBDEF VCOLD VNOINLINE void vtb_assert_failed(const char* expression, const char* file, int line)
+{
+	char vbuf[1024];
+	snprintf(vbuf, sizeof(vbuf), "Assert failed: %s (%s:%d)\n", expression, file, line);
+	vtb_debug_print(vbuf);
+	vtb_debug_flush();
+}
+
+#include <atomic>
+#include <chrono>
+#include <string.h>
+
+struct vtb__profile_thread
+{
+	vtb_profile_event m_events[VTB_PROFILE_MAX_EVENTS];
+	std::atomic<uint64_t> m_count; // Total events ever recorded. Only the last VTB_PROFILE_MAX_EVENTS are kept.
+	std::atomic<bool> m_exited; // Set when the thread exits, so reset can free it.
+	uint32_t m_thread_id;
+	vtb__profile_thread* m_next;
+};
+
+// Only touched when a thread registers and when it exits, so recording
+// doesn't pay for a thread_local with a destructor.
+struct vtb__profile_thread_exit
+{
+	vtb__profile_thread* m_thread = nullptr;
+
+	~vtb__profile_thread_exit()
+	{
+		if (m_thread)
+			m_thread->m_exited.store(true, std::memory_order_release);
+	}
+};
+
+static_assert((VTB_PROFILE_MAX_EVENTS & (VTB_PROFILE_MAX_EVENTS-1)) == 0, "VTB_PROFILE_MAX_EVENTS must be a power of two");
+
+static std::atomic<vtb__profile_thread*> vtb__profile_threads(nullptr);
+static std::atomic<uint32_t> vtb__profile_next_thread_id(1);
+static thread_local vtb__profile_thread* vtb__profile_this_thread = nullptr;
+static thread_local vtb__profile_thread_exit vtb__profile_this_thread_exit;
+
+static uint64_t vtb__profile_nanoseconds()
+{
+	return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+struct vtb__profile_calibration
+{
+	vtb__profile_calibration() : m_ticks(vtb_profile_ticks()), m_nanoseconds(vtb__profile_nanoseconds()) {}
+	uint64_t m_ticks;
+	uint64_t m_nanoseconds;
+};
+
+// Taken when the first thread registers, so that by export time there's a
+// long interval to measure the timestamp counter's rate over.
+static vtb__profile_calibration& vtb__profile_get_calibration()
+{
+	static vtb__profile_calibration calibration;
+	return calibration;
+}
+
+VTBDEF double vtb_profile_ticks_per_us()
+{
+#ifdef VTB__PROFILE_TSC
+	vtb__profile_calibration& start = vtb__profile_get_calibration();
+	vtb__profile_calibration now;
+
+	if (now.m_nanoseconds <= start.m_nanoseconds || now.m_ticks <= start.m_ticks)
+		return 1000;
+
+	return (double)(now.m_ticks - start.m_ticks) * 1000 / (double)(now.m_nanoseconds - start.m_nanoseconds);
+#else
+	return 1000;
+#endif
+}
+
+static vtb__profile_thread* vtb__profile_register_thread()
+{
+	vtb__profile_get_calibration();
+
+	vtb__profile_thread* thread = new vtb__profile_thread();
+	thread->m_count.store(0, std::memory_order_relaxed);
+	thread->m_exited.store(false, std::memory_order_relaxed);
+	thread->m_thread_id = vtb__profile_next_thread_id.fetch_add(1, std::memory_order_relaxed);
+
+	vtb__profile_thread* head = vtb__profile_threads.load(std::memory_order_relaxed);
+	do
+		thread->m_next = head;
+	while (!vtb__profile_threads.compare_exchange_weak(head, thread, std::memory_order_release, std::memory_order_relaxed));
+
+	vtb__profile_this_thread_exit.m_thread = thread;
+
+	return thread;
+}
+
+VTBDEF void vtb_profile_record(const char* name, uint64_t begin, uint64_t end)
+{
+	vtb__profile_thread* thread = vtb__profile_this_thread;
+	if (!thread)
+		thread = vtb__profile_this_thread = vtb__profile_register_thread();
+
+	// Only this thread writes m_count, so there's no need for an atomic increment.
+	uint64_t count = thread->m_count.load(std::memory_order_relaxed);
+
+	vtb_profile_event* event = &thread->m_events[count & (VTB_PROFILE_MAX_EVENTS-1)];
+	event->m_name = name;
+	event->m_begin = begin;
+	event->m_end = end;
+
+	thread->m_count.store(count + 1, std::memory_order_release);
+}
+
+static void vtb__profile_write_json_string(FILE* file, const char* s)
+{
+	for (; *s; s++)
+	{
+		if (*s == '"' || *s == '\\')
+			fputc('\\', file);
+
+		if ((unsigned char)*s < 0x20)
+			fprintf(file, "\\u%04x", (unsigned char)*s);
+		else
+			fputc(*s, file);
+	}
+}
+
+VTBDEF void vtb_profile_write_chrome_trace(FILE* file)
+{
+	double ticks_per_us = vtb_profile_ticks_per_us();
+
+	// Make timestamps relative to the earliest event to keep them short.
+	uint64_t base = ~(uint64_t)0;
+	for (vtb__profile_thread* thread = vtb__profile_threads.load(std::memory_order_acquire); thread; thread = thread->m_next)
+	{
+		uint64_t count = thread->m_count.load(std::memory_order_acquire);
+		uint64_t first = count > VTB_PROFILE_MAX_EVENTS ? count - VTB_PROFILE_MAX_EVENTS : 0;
+
+		for (uint64_t k = first; k < count; k++)
+			base = vmin(base, thread->m_events[k & (VTB_PROFILE_MAX_EVENTS-1)].m_begin);
+	}
+
+	fputs("{\"traceEvents\":[", file);
+
+	const char* separator = "\n";
+	for (vtb__profile_thread* thread = vtb__profile_threads.load(std::memory_order_acquire); thread; thread = thread->m_next)
+	{
+		uint64_t count = thread->m_count.load(std::memory_order_acquire);
+		uint64_t first = count > VTB_PROFILE_MAX_EVENTS ? count - VTB_PROFILE_MAX_EVENTS : 0;
+
+		for (uint64_t k = first; k < count; k++)
+		{
+			const vtb_profile_event* event = &thread->m_events[k & (VTB_PROFILE_MAX_EVENTS-1)];
+
+			fprintf(file, "%s{\"name\":\"", separator);
+			vtb__profile_write_json_string(file, event->m_name);
+			fprintf(file, "\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+				thread->m_thread_id,
+				(double)(event->m_begin - base) / ticks_per_us,
+				(double)(event->m_end - event->m_begin) / ticks_per_us);
+
+			separator = ",\n";
+		}
+	}
+
+	fputs("\n]}\n", file);
+}
+
+VTBDEF void vtb_profile_foreach(vtb_profile_event_function function, void* data)
+{
+	for (vtb__profile_thread* thread = vtb__profile_threads.load(std::memory_order_acquire); thread; thread = thread->m_next)
+	{
+		uint64_t count = thread->m_count.load(std::memory_order_acquire);
+		uint64_t first = count > VTB_PROFILE_MAX_EVENTS ? count - VTB_PROFILE_MAX_EVENTS : 0;
+
+		for (uint64_t k = first; k < count; k++)
+			function(data, thread->m_thread_id, &thread->m_events[k & (VTB_PROFILE_MAX_EVENTS-1)]);
+	}
+}
+
+VTBDEF void vtb_profile_reset()
+{
+	// Nobody is registering, so the list can be relinked without atomics.
+	vtb__profile_thread* head = vtb__profile_threads.load(std::memory_order_acquire);
+	vtb__profile_thread** link = &head;
+
+	while (*link)
+	{
+		vtb__profile_thread* thread = *link;
+		if (thread->m_exited.load(std::memory_order_acquire))
+		{
+			*link = thread->m_next;
+			delete thread;
+		}
+		else
+		{
+			thread->m_count.store(0, std::memory_order_release);
+			link = &thread->m_next;
+		}
+	}
+
+	vtb__profile_threads.store(head, std::memory_order_release);
+}
+
+static std::atomic<vtb_metric*> vtb__metrics(nullptr);
+static std::atomic<uint32_t> vtb__metric_next_shard(0);
+
+static void vtb__metric_register(vtb_metric* metric)
+{
+	vtb_metric* head = vtb__metrics.load(std::memory_order_relaxed);
+	do
+		metric->m_next = head;
+	while (!vtb__metrics.compare_exchange_weak(head, metric, std::memory_order_release, std::memory_order_relaxed));
+}
+
+vtb_counter::vtb_counter(const char* name)
+{
+	m_name = name;
+	m_is_histogram = 0;
+
+	for (int k = 0; k < VTB_METRIC_SHARDS; k++)
+		m_shards[k].m_value.store(0, std::memory_order_relaxed);
+
+	vtb__metric_register(this);
+}
+
+vtb_histogram::vtb_histogram(const char* name)
+{
+	m_name = name;
+	m_is_histogram = 1;
+
+	for (int k = 0; k < VTB_METRIC_SHARDS; k++)
+	{
+		m_shards[k].m_sum.store(0, std::memory_order_relaxed);
+		for (int j = 0; j < VTB_HISTOGRAM_BUCKETS; j++)
+			m_shards[k].m_buckets[j].store(0, std::memory_order_relaxed);
+	}
+
+	vtb__metric_register(this);
+}
+
+VTBDEF uint32_t vtb__metric_assign_shard()
+{
+	return vtb__metric_next_shard.fetch_add(1, std::memory_order_relaxed);
+}
+
+// Adds up every histogram with this name into buckets, which must have
+// VTB_HISTOGRAM_BUCKETS entries. Returns the number of values recorded.
+static uint64_t vtb__histogram_gather(const char* name, uint64_t* buckets, uint64_t* sum)
+{
+	uint64_t count = 0;
+
+	for (int j = 0; j < VTB_HISTOGRAM_BUCKETS; j++)
+		buckets[j] = 0;
+	*sum = 0;
+
+	for (vtb_metric* metric = vtb__metrics.load(std::memory_order_acquire); metric; metric = metric->m_next)
+	{
+		if (!metric->m_is_histogram || strcmp(metric->m_name, name) != 0)
+			continue;
+
+		vtb_histogram* histogram = (vtb_histogram*)metric;
+		for (int k = 0; k < VTB_METRIC_SHARDS; k++)
+		{
+			*sum += histogram->m_shards[k].m_sum.load(std::memory_order_relaxed);
+
+			for (int j = 0; j < VTB_HISTOGRAM_BUCKETS; j++)
+			{
+				uint64_t value = histogram->m_shards[k].m_buckets[j].load(std::memory_order_relaxed);
+				buckets[j] += value;
+				count += value;
+			}
+		}
+	}
+
+	return count;
+}
+
+static uint64_t vtb__histogram_percentile(const uint64_t* buckets, uint64_t count, double percentile)
+{
+	if (!count)
+		return 0;
+
+	uint64_t rank = (uint64_t)(percentile/100 * count + 0.5);
+	rank = vmax(rank, (uint64_t)1);
+	rank = vmin(rank, count);
+
+	uint64_t seen = 0;
+	for (int j = 0; j < VTB_HISTOGRAM_BUCKETS; j++)
+	{
+		seen += buckets[j];
+		if (seen >= rank)
+			return vtb_histogram_bucket_value(j);
+	}
+
+	return vtb_histogram_bucket_value(VTB_HISTOGRAM_BUCKETS-1);
+}
+
+VTBDEF uint64_t vtb_counter_read(const char* name)
+{
+	uint64_t total = 0;
+
+	for (vtb_metric* metric = vtb__metrics.load(std::memory_order_acquire); metric; metric = metric->m_next)
+	{
+		if (metric->m_is_histogram || strcmp(metric->m_name, name) != 0)
+			continue;
+
+		vtb_counter* counter = (vtb_counter*)metric;
+		for (int k = 0; k < VTB_METRIC_SHARDS; k++)
+			total += counter->m_shards[k].m_value.load(std::memory_order_relaxed);
+	}
+
+	return total;
+}
+
+VTBDEF uint64_t vtb_histogram_count(const char* name)
+{
+	uint64_t buckets[VTB_HISTOGRAM_BUCKETS];
+	uint64_t sum;
+	return vtb__histogram_gather(name, buckets, &sum);
+}
+
+VTBDEF double vtb_histogram_mean(const char* name)
+{
+	uint64_t buckets[VTB_HISTOGRAM_BUCKETS];
+	uint64_t sum;
+	uint64_t count = vtb__histogram_gather(name, buckets, &sum);
+	return count ? (double)sum/count : 0;
+}
+
+VTBDEF uint64_t vtb_histogram_percentile(const char* name, double percentile)
+{
+	uint64_t buckets[VTB_HISTOGRAM_BUCKETS];
+	uint64_t sum;
+	uint64_t count = vtb__histogram_gather(name, buckets, &sum);
+	return vtb__histogram_percentile(buckets, count, percentile);
+}
+
+VTBDEF void vtb_metrics_write(FILE* file)
+{
+	vtb_metric* first = vtb__metrics.load(std::memory_order_acquire);
+
+	for (vtb_metric* metric = first; metric; metric = metric->m_next)
+	{
+		// Call sites that share a name are written once, added up.
+		bool seen = false;
+		for (vtb_metric* earlier = first; earlier != metric && !seen; earlier = earlier->m_next)
+			seen = earlier->m_is_histogram == metric->m_is_histogram && strcmp(earlier->m_name, metric->m_name) == 0;
+
+		if (seen)
+			continue;
+
+		if (!metric->m_is_histogram)
+		{
+			fprintf(file, "%s: %llu\n", metric->m_name, (unsigned long long)vtb_counter_read(metric->m_name));
+			continue;
+		}
+
+		uint64_t buckets[VTB_HISTOGRAM_BUCKETS];
+		uint64_t sum;
+		uint64_t count = vtb__histogram_gather(metric->m_name, buckets, &sum);
+
+		fprintf(file, "%s: count %llu mean %.1f p50 %llu p90 %llu p99 %llu max %llu\n",
+			metric->m_name,
+			(unsigned long long)count,
+			count ? (double)sum/count : 0.0,
+			(unsigned long long)vtb__histogram_percentile(buckets, count, 50),
+			(unsigned long long)vtb__histogram_percentile(buckets, count, 90),
+			(unsigned long long)vtb__histogram_percentile(buckets, count, 99),
+			(unsigned long long)vtb__histogram_percentile(buckets, count, 100));
+	}
+}
+
+VTBDEF void vtb_metrics_reset()
+{
+	for (vtb_metric* metric = vtb__metrics.load(std::memory_order_acquire); metric; metric = metric->m_next)
+	{
+		if (!metric->m_is_histogram)
+		{
+			vtb_counter* counter = (vtb_counter*)metric;
+			for (int k = 0; k < VTB_METRIC_SHARDS; k++)
+				counter->m_shards[k].m_value.store(0, std::memory_order_relaxed);
+			continue;
+		}
+
+		vtb_histogram* histogram = (vtb_histogram*)metric;
+		for (int k = 0; k < VTB_METRIC_SHARDS; k++)
+		{
+			histogram->m_shards[k].m_sum.store(0, std::memory_order_relaxed);
+			for (int j = 0; j < VTB_HISTOGRAM_BUCKETS; j++)
+				histogram->m_shards[k].m_buckets[j].store(0, std::memory_order_relaxed);
+		}
+	}
+}
+
 #endif
@@ -9,7 +9,8 @@ This is a memory allocator implementing a ring buffer from a block of memory
 that you optionally provide. It has constant time alloc and free, making it a
 compelling replacement for a linked list in places where memory locality is
 important. It does not require memory copies and always returns contiguous
-memory blocks. This implementation is not thread safe.
+memory blocks. The allocator is not thread safe, but vtb_claim_ring lets
+several threads consume from one.
 
 
 COMPILING AND LINKING
@@ -72,6 +73,89 @@ MEMORY MANAGEMENT
 	then you can avoid #include stdlib.h
 
 
+OUT OF ORDER FREES
+	vtbar_free() releases any section, not just the tail. A section freed
+	ahead of the tail is marked dead and stays put until everything in front
+	of it is gone, then the tail jumps past the whole dead run at once. One
+	slow section still holds the memory behind it, but no longer blocks you
+	from finishing with the rest. vtbar_getnumdead() and vtbar_getsizedead()
+	tell you how much is stuck that way.
+
+
+BACKPRESSURE
+	A failed vtbar_alloc tells you the ring is full once it's too late. To
+	find out sooner, vtbar_setwatermarks takes a high and a low watermark
+	in bytes, compared against vtbar_getsizeallocations:
+
+		vtbar_setwatermarks(&a, size*3/4, size/4, on_pressure, &producer);
+
+		void on_pressure(void* data, int event, int32_t size_allocations)
+		{
+			if (event == VTBAR_EVENT_HIGH)
+				start_shedding((producer_t*)data); // Or wake the consumer
+			else if (event == VTBAR_EVENT_LOW)
+				stop_shedding((producer_t*)data);
+		}
+
+	VTBAR_EVENT_HIGH comes once when the ring fills up to the high mark, and
+	VTBAR_EVENT_LOW once when it drains back down to the low mark, so a ring
+	hovering around either one doesn't flood you with events. VTBAR_EVENT_FULL
+	comes every time vtbar_alloc returns 0. The function is called from
+	inside the alloc or free that caused it, after the ring is consistent,
+	so it can alloc and free too. The exception is an alloc from a
+	vtbar_drain function: drain is still working through the sections
+	behind it, so like the drain function the pressure function can only
+	alloc then, and freeing asserts. To wake another thread, write to an
+	eventfd or signal a condition variable from it. If you'd rather poll,
+	pass 0 for the function and check vtbar_isabovewatermark.
+
+
+VARIABLE LENGTH MESSAGES
+	If you don't know how long something is until you've written it, alloc
+	the most it could be, write it straight into the ring, and then call
+	vtbar_realloc_head() with the length you actually used. The rest goes
+	back to the ring for the next alloc. Only the most recent allocation can
+	be resized, and it never moves.
+
+
+MULTIPLE CONSUMERS
+	vtb_claim_ring spreads work from one producer over several consumer
+	threads. The producer allocs and publishes sections just like with the
+	allocator. Consumers call vtbar_claim_next to take the oldest section
+	nobody has taken yet, work on it, and vtbar_claim_release it. Releases
+	can come in any order, but the memory only goes back to the ring once
+	every older section is released too, so the ring still never fragments.
+
+		// Producer
+		while (!(job = (job_t*)vtbar_claim_alloc(&r, sizeof(job_t))))
+			wait();
+		*job = next_job();
+		vtbar_claim_publish(&r);
+
+		// Consumers
+		vtb_claim c;
+		if (vtbar_claim_next(&r, &c))
+		{
+			run((job_t*)c.start);
+			vtbar_claim_release(&r, &c);
+		}
+
+	Claiming is one compare and swap, releasing is one store. It needs the
+	GCC/Clang __atomic builtins or MSVC's _Interlocked intrinsics. With any
+	other compiler the vtbar_claim_* functions aren't defined, and the rest
+	of the allocator is plain C as always. If you have several producers,
+	put a lock around the producer calls.
+
+
+C++
+	vtb::ring<Types...> wraps the allocator in a queue of C++ objects that
+	are constructed in place and destroyed for you. See its declaration.
+
+	vtb::static_ring<Capacity, ItemSize> is the allocator for sections that
+	are all one size, with the sizes fixed at compile time and the memory
+	inside the object.
+
+
 ASSERT
 	Define VTBAR_ASSERT(boolval) to override assert() and not use assert.h
 */
@@ -90,9 +174,17 @@ ASSERT
 #endif
 
 #include <stdint.h> // For uint8_t/int32_t
+#include <stddef.h> // For size_t
 
 #define VTB__PRIVATE_MEMBER(type, name) type vtb__##name
 
+// Events passed to a vtbar_pressure_function, see vtbar_setwatermarks.
+#define VTBAR_EVENT_HIGH 1 // Filled up to the high watermark.
+#define VTBAR_EVENT_LOW 2  // Drained back down to the low watermark.
+#define VTBAR_EVENT_FULL 3 // vtbar_alloc failed.
+
+typedef void (*vtbar_pressure_function)(void* data, int event, int32_t size_allocations);
+
 // WARNING: Don't directly reference members of this struct. I reserve
 // the right to change them from version to version.
 // VTB__PRIVATE_MEMBER is here to discourage you from trying to reference
@@ -109,6 +201,19 @@ typedef struct
 	VTB__PRIVATE_MEMBER(int32_t, m_num_allocations);
 	VTB__PRIVATE_MEMBER(int32_t, m_size_allocations);
 
+	// Sections freed with vtbar_free that are still stuck behind the tail.
+	VTB__PRIVATE_MEMBER(int32_t, m_num_dead);
+	VTB__PRIVATE_MEMBER(int32_t, m_size_dead);
+
+	// See vtbar_setwatermarks. m_high_watermark is INT32_MAX when they're off.
+	VTB__PRIVATE_MEMBER(vtbar_pressure_function, m_pressure_function);
+	VTB__PRIVATE_MEMBER(void*, m_pressure_data);
+	VTB__PRIVATE_MEMBER(int32_t, m_high_watermark);
+	VTB__PRIVATE_MEMBER(int32_t, m_low_watermark);
+	VTB__PRIVATE_MEMBER(uint8_t, m_above_watermark); // From reaching the high watermark until back down to the low one.
+
+	VTB__PRIVATE_MEMBER(uint8_t, m_draining); // Inside vtbar_drain, so nothing can free.
+
 	VTB__PRIVATE_MEMBER(uint8_t, m_flags); // Currently only contains the free flag.
 } vtb_ring_allocator;
 
@@ -133,12 +238,45 @@ VTBARDEF void vtbar_destroy(vtb_ring_allocator* vtbra);
 // receive a contiguous block of memory in return.
 VTBARDEF void* vtbar_alloc(vtb_ring_allocator* vtbra, int32_t size);
 
+// Resize the most recently allocated section, which must be the one at ptr,
+// without moving it. Shrinking always works. Growing works if there's room
+// after it, otherwise it returns 0 and the section is unchanged. On success
+// it returns ptr. This lets you alloc the most you might need, write into
+// it, and then give back what you didn't use.
+VTBARDEF void* vtbar_realloc_head(vtb_ring_allocator* vtbra, void* ptr, int32_t size);
+
 // Return the item least recently allocated, but does not free it.
 VTBARDEF void vtbar_peektail(vtb_ring_allocator* vtbra, void** start, int32_t* length);
 
 // Return and free the item least recently allocated.
 VTBARDEF void vtbar_freetail(vtb_ring_allocator* vtbra, void** start, int32_t* length);
 
+// Calls function(data, start, length) on the least recently allocated
+// section and frees it, like vtbar_peektail and vtbar_freetail, until the
+// ring is empty or max sections are done. Pass 0 for max to drain it all.
+// Returns the number of sections done. function can alloc but not free,
+// and neither can a pressure function its allocs set off, which asserts.
+// Sections are mostly laid out one after another, so this prefetches the
+// memory VTBAR_PREFETCH_DISTANCE bytes ahead instead of waiting on each
+// header to find the next one.
+typedef void (*vtbar_drain_function)(void* data, void* start, int32_t length);
+VTBARDEF int32_t vtbar_drain(vtb_ring_allocator* vtbra, vtbar_drain_function function, void* data, int32_t max);
+
+// Free any section, not just the tail. If it isn't the tail it's only marked
+// dead and its memory comes back once everything in front of it is freed,
+// at which point the tail skips over it. Freeing the tail this way is the
+// same as vtbar_freetail.
+VTBARDEF void vtbar_free(vtb_ring_allocator* vtbra, void* ptr);
+
+// Calls function(data, event, size) when vtbar_getsizeallocations reaches
+// high, when it then drops back to low, and when vtbar_alloc fails. See
+// BACKPRESSURE above. function can be 0 if you only want to poll
+// vtbar_isabovewatermark. Pass 0 for high to turn them off.
+VTBARDEF void vtbar_setwatermarks(vtb_ring_allocator* vtbra, int32_t high, int32_t low, vtbar_pressure_function function, void* data);
+
+// Returns 1 from reaching the high watermark until back down to the low one.
+VTBARDEF int vtbar_isabovewatermark(vtb_ring_allocator* vtbra);
+
 // Return true if the list is empty, false otherwise.
 VTBARDEF int vtbar_isempty(vtb_ring_allocator* vtbra);
 
@@ -148,6 +286,14 @@ VTBARDEF int vtbar_getnumallocations(vtb_ring_allocator* vtbra);
 // Returns the total size of all allocations. Incremented by alloc, decremented by free.
 VTBARDEF int vtbar_getsizeallocations(vtb_ring_allocator* vtbra);
 
+// Returns the number of sections freed with vtbar_free that can't be reused
+// yet because a live section is in front of them. They aren't counted by
+// vtbar_getnumallocations.
+VTBARDEF int vtbar_getnumdead(vtb_ring_allocator* vtbra);
+
+// Returns the memory, headers included, held by those sections.
+VTBARDEF int vtbar_getsizedead(vtb_ring_allocator* vtbra);
+
 // Returns the total amount of memory available.
 VTBARDEF int vtbar_getmemorysize(vtb_ring_allocator* vtbra);
 
@@ -160,6 +306,471 @@ VTBARDEF int vtbar_isusermemory(vtb_ring_allocator* vtbra);
 // tightly.
 VTBARDEF int vtbar_getheadersize();
 
+// One per section handed to consumers, see vtb_claim_ring.
+typedef struct
+{
+	int32_t m_index; // Of the section's header in the ring memory.
+	int32_t m_done;  // Set by vtbar_claim_release.
+} vtb__claim_slot;
+
+// A ring that one producer fills and any number of consumer threads take
+// from, in order. See MULTIPLE CONSUMERS. The same warning as for
+// vtb_ring_allocator applies to its members.
+typedef struct
+{
+	// Only the producer touches these.
+	VTB__PRIVATE_MEMBER(vtb_ring_allocator, m_allocator);
+	VTB__PRIVATE_MEMBER(vtb__claim_slot*, m_slots);
+	VTB__PRIVATE_MEMBER(int32_t, m_num_slots);
+	VTB__PRIVATE_MEMBER(int64_t, m_reclaimed); // Sequence of the section at the allocator's tail.
+	VTB__PRIVATE_MEMBER(void*, m_pending);     // Alloc'd but not published yet.
+	VTB__PRIVATE_MEMBER(uint8_t, m_flags);     // Currently only contains the free flag.
+
+	// Each of these gets a cache line to itself, so consumers claiming don't
+	// slow the producer down and the other way around.
+	VTB__PRIVATE_MEMBER(uint8_t, m_published_padding)[64];
+	VTB__PRIVATE_MEMBER(int64_t, m_published); // Sections consumers can claim. Written by the producer.
+	VTB__PRIVATE_MEMBER(uint8_t, m_claimed_padding)[64];
+	VTB__PRIVATE_MEMBER(int64_t, m_claimed);   // Sections consumers have claimed.
+	VTB__PRIVATE_MEMBER(uint8_t, m_end_padding)[64];
+} vtb_claim_ring;
+
+// A section a consumer has claimed.
+typedef struct
+{
+	void*   start;
+	int32_t length;
+	int64_t sequence; // Sections are numbered from 0 in the order they're published.
+} vtb_claim;
+
+// Uses the memory you provide, for both the ring and a table of max_sections
+// entries, which must be a power of 2. That's how many sections can be
+// published and not yet released at once.
+VTBARDEF void vtbar_claim_initialize(vtb_claim_ring* vtbcr, void* memory, int32_t memory_size, int32_t max_sections);
+
+// Allocates memory_size bytes for you, plus room for the table.
+VTBARDEF void vtbar_claim_initializememory(vtb_claim_ring* vtbcr, int32_t memory_size, int32_t max_sections);
+
+// Deallocates memory. Nobody can be using the ring anymore.
+VTBARDEF void vtbar_claim_destroy(vtb_claim_ring* vtbcr);
+
+// Producer only. Like vtbar_alloc, but consumers can't see the section until
+// you vtbar_claim_publish it, and only one can be waiting to be published.
+// Reclaims the memory of released sections first. Returns 0 if there's no
+// space or the table is full, in which case wait for consumers to release
+// some sections and try again.
+VTBARDEF void* vtbar_claim_alloc(vtb_claim_ring* vtbcr, int32_t size);
+
+// Producer only. Hands the section from the last vtbar_claim_alloc to the
+// consumers.
+VTBARDEF void vtbar_claim_publish(vtb_claim_ring* vtbcr);
+
+// Producer only. Reclaims the memory of released sections, which
+// vtbar_claim_alloc also does. Returns how many published sections are still
+// holding memory, so 0 means every one was released.
+VTBARDEF int32_t vtbar_claim_reclaim(vtb_claim_ring* vtbcr);
+
+// Any thread. Claims the oldest published section no one has claimed yet.
+// Returns 0 if there's none.
+VTBARDEF int vtbar_claim_next(vtb_claim_ring* vtbcr, vtb_claim* claim);
+
+// The thread with the claim. Done with the section, the producer can reuse
+// its memory once every section before it is released too.
+VTBARDEF void vtbar_claim_release(vtb_claim_ring* vtbcr, vtb_claim* claim);
+
+#ifdef __cplusplus
+
+#include <new>     // For placement new
+#include <utility> // For std::forward
+
+#ifndef VTBAR_ASSERT
+#include <assert.h>
+#define VTBAR_ASSERT(x) assert(x)
+#endif
+
+namespace vtb
+{
+
+// A queue of C++ objects constructed right in ring memory. emplace_back
+// constructs at the head, pop_front hands out the object at the tail in a
+// handle that destroys it and frees its memory when the handle goes away.
+// Any of Types can go in, each block is tagged with the index of its type.
+//
+//     vtb::ring<Message, Shutdown> r(memory, sizeof(memory));
+//     r.emplace_back<Message>("hello");
+//     r.emplace_back<Shutdown>();
+//
+//     while (auto item = r.pop_front())
+//     {
+//         if (Message* m = item.get<Message>())
+//             print(m->text);
+//     }
+//
+// With one type the template argument can be left off. Only one handle can
+// be held at a time, since it's holding the tail, so release it before the
+// next pop_front. Types can't need more alignment than the allocator gives,
+// which is sizeof(size_t).
+template <typename... Types>
+class ring
+{
+	template <typename T, typename... Rest>
+	struct type_index;
+
+	template <typename T, typename... Rest>
+	struct type_index<T, T, Rest...>
+	{
+		static const uint32_t value = 0;
+	};
+
+	template <typename T, typename First, typename... Rest>
+	struct type_index<T, First, Rest...>
+	{
+		static const uint32_t value = 1 + type_index<T, Rest...>::value;
+	};
+
+	template <typename First, typename... Rest>
+	struct first_type
+	{
+		typedef First type;
+	};
+
+	// Stored in front of each object. Blocks are sizeof(size_t) aligned,
+	// so this keeps the object aligned.
+	struct item_header
+	{
+		uint32_t m_type;
+		uint32_t m_padding;
+	};
+
+	static_assert(sizeof(item_header) % sizeof(size_t) == 0, "item_header must keep objects aligned");
+
+	// The type of a block whose constructor threw. Nothing to destroy.
+	static const uint32_t invalid_type = ~(uint32_t)0;
+
+	template <typename T>
+	static void destroy(void* object)
+	{
+		static_cast<T*>(object)->~T();
+	}
+
+	static void destroy(uint32_t type, void* object)
+	{
+		static void (*const destructors[])(void*) = { &ring::destroy<Types>... };
+
+		if (type != invalid_type)
+			destructors[type](object);
+	}
+
+public:
+	typedef typename first_type<Types...>::type default_type;
+
+	// Owns the object at the front of the ring until it's destroyed or
+	// release() is called.
+	class handle
+	{
+	public:
+		handle()
+			: m_ring(0), m_type(invalid_type), m_object(0)
+		{
+		}
+
+		handle(handle&& other)
+			: m_ring(other.m_ring), m_type(other.m_type), m_object(other.m_object)
+		{
+			other.m_ring = 0;
+		}
+
+		handle& operator=(handle&& other)
+		{
+			if (this != &other)
+			{
+				release();
+				m_ring = other.m_ring;
+				m_type = other.m_type;
+				m_object = other.m_object;
+				other.m_ring = 0;
+			}
+
+			return *this;
+		}
+
+		handle(const handle&) = delete;
+		handle& operator=(const handle&) = delete;
+
+		~handle()
+		{
+			release();
+		}
+
+		explicit operator bool() const
+		{
+			return !!m_ring;
+		}
+
+		// The index into Types of the object's type.
+		uint32_t type() const
+		{
+			return m_type;
+		}
+
+		template <typename T>
+		bool is() const
+		{
+			return m_ring && m_type == type_index<T, Types...>::value;
+		}
+
+		// Returns 0 if the object isn't a T.
+		template <typename T = default_type>
+		T* get() const
+		{
+			return is<T>() ? static_cast<T*>(m_object) : 0;
+		}
+
+		// Destroys the object and frees its memory.
+		void release()
+		{
+			if (!m_ring)
+				return;
+
+			ring* r = m_ring;
+			m_ring = 0;
+
+			destroy(m_type, m_object);
+			vtbar_freetail(&r->m_allocator, 0, 0);
+
+			r->m_handle_out = false;
+		}
+
+	private:
+		friend class ring;
+
+		handle(ring* r, uint32_t type, void* object)
+			: m_ring(r), m_type(type), m_object(object)
+		{
+		}
+
+		ring*    m_ring;
+		uint32_t m_type;
+		void*    m_object;
+	};
+
+	// Uses memory that you provide.
+	ring(void* memory, int32_t memory_size)
+		: m_handle_out(false)
+	{
+		vtbar_initialize(&m_allocator, memory, memory_size);
+	}
+
+	// Allocates memory_size bytes with malloc.
+	explicit ring(int32_t memory_size)
+		: m_handle_out(false)
+	{
+		vtbar_initializememory(&m_allocator, memory_size);
+	}
+
+	ring(const ring&) = delete;
+	ring& operator=(const ring&) = delete;
+
+	// Destroys any objects still in the ring.
+	~ring()
+	{
+		VTBAR_ASSERT(!m_handle_out); // Release the handle before the ring
+
+		clear();
+		vtbar_destroy(&m_allocator);
+	}
+
+	// Constructs a T at the back of the ring. Returns 0 if there's no room.
+	template <typename T = default_type, typename... Args>
+	T* emplace_back(Args&&... args)
+	{
+		static_assert(alignof(T) <= sizeof(size_t), "vtb::ring can't align types to more than sizeof(size_t)");
+
+		item_header* header = (item_header*)vtbar_alloc(&m_allocator, (int32_t)(sizeof(item_header) + sizeof(T)));
+		if (!header)
+			return 0;
+
+		// If the constructor throws, the block stays behind with no type
+		// and pop_front skips it.
+		header->m_type = invalid_type;
+		T* object = new (header + 1) T(std::forward<Args>(args)...);
+		header->m_type = type_index<T, Types...>::value;
+
+		return object;
+	}
+
+	// Takes the object at the front of the ring. The handle is empty if the
+	// ring is.
+	handle pop_front()
+	{
+		VTBAR_ASSERT(!m_handle_out); // Only one handle at a time
+
+		while (!vtbar_isempty(&m_allocator))
+		{
+			void* memory;
+			int32_t length;
+			vtbar_peektail(&m_allocator, &memory, &length);
+
+			item_header* header = (item_header*)memory;
+			if (header->m_type == invalid_type)
+			{
+				vtbar_freetail(&m_allocator, 0, 0);
+				continue;
+			}
+
+			m_handle_out = true;
+			return handle(this, header->m_type, header + 1);
+		}
+
+		return handle();
+	}
+
+	// Destroys every object in the ring.
+	void clear()
+	{
+		while (handle h = pop_front())
+			h.release();
+	}
+
+	bool empty()
+	{
+		return !!vtbar_isempty(&m_allocator);
+	}
+
+	// Includes the one in a handle, if there is one.
+	int32_t size()
+	{
+		return vtbar_getnumallocations(&m_allocator);
+	}
+
+	// Bytes of ring memory one T takes, for sizing the memory you pass in.
+	template <typename T = default_type>
+	static int32_t item_size()
+	{
+		int32_t size = (int32_t)(sizeof(item_header) + sizeof(T));
+		size += (int32_t)((sizeof(size_t) - size % sizeof(size_t)) % sizeof(size_t));
+		return size + vtbar_getheadersize();
+	}
+
+private:
+	vtb_ring_allocator m_allocator;
+	bool               m_handle_out;
+};
+
+// The allocator for when every section is the same size and you know how
+// many you need at compile time. Capacity sections of ItemSize bytes live
+// right in the object, no headers, and since Capacity is a power of 2 the
+// position of a section is a mask and a shift, so alloc and freetail come
+// down to a few instructions.
+//
+//     vtb::static_ring<256, sizeof(Message)> r;
+//     *(Message*)r.alloc() = message;
+//
+//     while (Message* m = (Message*)r.peektail())
+//     {
+//         handle(m);
+//         r.freetail();
+//     }
+//
+// Sections are aligned to sizeof(size_t), like the allocator's.
+template <uint32_t Capacity, uint32_t ItemSize>
+class static_ring
+{
+	static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "vtb::static_ring Capacity must be a power of 2");
+	static_assert(Capacity <= 0x80000000u, "vtb::static_ring Capacity is too big to count");
+	static_assert(ItemSize > 0, "vtb::static_ring ItemSize can't be 0");
+
+public:
+	static const uint32_t capacity = Capacity;
+	static const uint32_t item_size = ItemSize;
+
+	// Bytes between the start of one section and the next.
+	static const uint32_t stride = (ItemSize + sizeof(size_t) - 1) / sizeof(size_t) * sizeof(size_t);
+
+	static_assert(stride >= ItemSize, "vtb::static_ring ItemSize is too big");
+	static_assert((uint64_t)Capacity * stride <= 0xFFFFFFFFu, "vtb::static_ring Capacity * ItemSize is too big");
+
+	static_ring()
+		: m_head(0), m_tail(0)
+	{
+	}
+
+	static_ring(const static_ring&) = delete;
+	static_ring& operator=(const static_ring&) = delete;
+
+	// Returns 0 if the ring is full.
+	void* alloc()
+	{
+		if (m_head - m_tail == Capacity)
+			return 0;
+
+		return &m_memory[(m_head++ & (Capacity - 1)) * stride];
+	}
+
+	// The least recently alloc'd section, or 0 if the ring is empty.
+	void* peektail()
+	{
+		if (m_head == m_tail)
+			return 0;
+
+		return &m_memory[(m_tail & (Capacity - 1)) * stride];
+	}
+
+	// Frees the least recently alloc'd section.
+	void freetail()
+	{
+		VTBAR_ASSERT(m_head != m_tail);
+
+		m_tail++;
+	}
+
+	// Same as vtbar_drain: calls function(start) on the least recently
+	// alloc'd section and frees it until the ring is empty or max sections
+	// are done, 0 meaning no max. Returns the number done. function can alloc.
+	template <typename Function>
+	uint32_t drain(Function&& function, uint32_t max = 0)
+	{
+		uint32_t drained = 0;
+		while (m_head != m_tail)
+		{
+			function((void*)&m_memory[(m_tail & (Capacity - 1)) * stride]);
+			m_tail++;
+
+			if (++drained == max)
+				break;
+		}
+
+		return drained;
+	}
+
+	bool empty() const
+	{
+		return m_head == m_tail;
+	}
+
+	bool full() const
+	{
+		return m_head - m_tail == Capacity;
+	}
+
+	// The number of sections alloc'd and not freed.
+	uint32_t size() const
+	{
+		return m_head - m_tail;
+	}
+
+private:
+	// Count up forever and wrap, only the difference and the low bits matter.
+	uint32_t m_head;
+	uint32_t m_tail;
+
+	alignas(size_t) uint8_t m_memory[Capacity * stride];
+};
+
+}
+
+#endif // __cplusplus
+
 #endif // VTB__ALLOC_RING_H
 
 
@@ -183,12 +794,108 @@ VTBARDEF int vtbar_getheadersize();
 #include <stdlib.h>
 #endif
 
+#ifndef VTBAR_PREFETCH_DISTANCE
+#define VTBAR_PREFETCH_DISTANCE 1024
+#endif
+
+#if defined(__GNUC__)
+#define VTBAR__PREFETCH(address) __builtin_prefetch(address)
+#else
+#define VTBAR__PREFETCH(address)
+#endif
+
+// Atomics for vtb_claim_ring. Stores are release and loads are acquire.
+#if defined(__GNUC__) || defined(__clang__)
+#define VTBAR__CLAIM_RING
+#define VTBAR__LOAD32(p) __atomic_load_n(p, __ATOMIC_ACQUIRE)
+#define VTBAR__STORE32(p, value) __atomic_store_n(p, value, __ATOMIC_RELEASE)
+#define VTBAR__LOAD64(p) __atomic_load_n(p, __ATOMIC_ACQUIRE)
+#define VTBAR__STORE64(p, value) __atomic_store_n(p, value, __ATOMIC_RELEASE)
+// Sets *p to desired if it's *expected. Otherwise puts what's there in *expected.
+#define VTBAR__CAS64(p, expected, desired) __atomic_compare_exchange_n(p, expected, desired, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED)
+#elif defined(_MSC_VER)
+#include <intrin.h>
+#define VTBAR__CLAIM_RING
+#define VTBAR__LOAD32(p) (int32_t)_InterlockedCompareExchange((volatile long*)(p), 0, 0)
+#define VTBAR__STORE32(p, value) _InterlockedExchange((volatile long*)(p), (long)(value))
+#define VTBAR__LOAD64(p) (int64_t)_InterlockedCompareExchange64((volatile long long*)(p), 0, 0)
+#define VTBAR__STORE64(p, value) _InterlockedExchange64((volatile long long*)(p), (long long)(value))
+static int vtbar__cas64(int64_t* p, int64_t* expected, int64_t desired)
+{
+	int64_t previous = _InterlockedCompareExchange64((volatile long long*)p, desired, *expected);
+	if (previous == *expected)
+		return 1;
+
+	*expected = previous;
+	return 0;
+}
+#define VTBAR__CAS64(p, expected, desired) vtbar__cas64(p, expected, desired)
+#endif
+
 typedef struct
 {
-	int32_t m_length; // Allocation size.
+	int32_t m_length; // Allocation size. The low bit is VTBAR__DEAD, so always read it with VTBAR__LENGTH.
 	int32_t m_next;   // Index into m_memory. Points to the header of the next block.
 } vtb__memory_section_header;
 
+// Lengths are rounded up to sizeof(size_t) so the low bit is free to mark
+// sections released with vtbar_free.
+#define VTBAR__DEAD 1
+#define VTBAR__LENGTH(header) ((header)->m_length & ~VTBAR__DEAD)
+
+// Keeps the tail on a live section, so nothing else has to skip dead ones.
+static void vtbar__skipdead(vtb_ring_allocator* vtbra)
+{
+	while (vtbra->vtb__m_tail_index >= 0)
+	{
+		vtb__memory_section_header* header = (vtb__memory_section_header*)&vtbra->vtb__m_memory[vtbra->vtb__m_tail_index];
+		if (!(header->m_length & VTBAR__DEAD))
+			return;
+
+		vtbra->vtb__m_num_dead--;
+		vtbra->vtb__m_size_dead -= VTBAR__LENGTH(header) + (int)sizeof(vtb__memory_section_header);
+
+		if (header->m_next >= 0)
+			vtbra->vtb__m_tail_index = header->m_next;
+		else
+			vtbra->vtb__m_head_index = vtbra->vtb__m_tail_index = -1;
+	}
+}
+
+#define VTBAR__NO_WATERMARK 0x7FFFFFFF
+
+// After anything that grows m_size_allocations. One compare when watermarks are off.
+static void vtbar__grew(vtb_ring_allocator* vtbra)
+{
+	if (vtbra->vtb__m_size_allocations < vtbra->vtb__m_high_watermark || vtbra->vtb__m_above_watermark)
+		return;
+
+	vtbra->vtb__m_above_watermark = 1;
+
+	if (vtbra->vtb__m_pressure_function)
+		vtbra->vtb__m_pressure_function(vtbra->vtb__m_pressure_data, VTBAR_EVENT_HIGH, vtbra->vtb__m_size_allocations);
+}
+
+// After anything that shrinks it.
+static void vtbar__shrank(vtb_ring_allocator* vtbra)
+{
+	if (!vtbra->vtb__m_above_watermark || vtbra->vtb__m_size_allocations > vtbra->vtb__m_low_watermark)
+		return;
+
+	vtbra->vtb__m_above_watermark = 0;
+
+	if (vtbra->vtb__m_pressure_function)
+		vtbra->vtb__m_pressure_function(vtbra->vtb__m_pressure_data, VTBAR_EVENT_LOW, vtbra->vtb__m_size_allocations);
+}
+
+static void* vtbar__full(vtb_ring_allocator* vtbra)
+{
+	if (vtbra->vtb__m_pressure_function)
+		vtbra->vtb__m_pressure_function(vtbra->vtb__m_pressure_data, VTBAR_EVENT_FULL, vtbra->vtb__m_size_allocations);
+
+	return 0;
+}
+
 VTBARDEF void vtbar_initialize(vtb_ring_allocator* vtbra, void* memory, int32_t memory_size)
 {
 	VTBAR__CHECK(memory);
@@ -201,6 +908,14 @@ VTBARDEF void vtbar_initialize(vtb_ring_allocator* vtbra, void* memory, int32_t
 	vtbra->vtb__m_flags = 0;
 	vtbra->vtb__m_num_allocations = 0;
 	vtbra->vtb__m_size_allocations = 0;
+	vtbra->vtb__m_num_dead = 0;
+	vtbra->vtb__m_size_dead = 0;
+	vtbra->vtb__m_pressure_function = 0;
+	vtbra->vtb__m_pressure_data = 0;
+	vtbra->vtb__m_high_watermark = VTBAR__NO_WATERMARK;
+	vtbra->vtb__m_low_watermark = 0;
+	vtbra->vtb__m_above_watermark = 0;
+	vtbra->vtb__m_draining = 0;
 }
 
 VTBARDEF void vtbar_initializememory(vtb_ring_allocator* vtbra, int32_t memory_size)
@@ -263,7 +978,7 @@ VTBARDEF void* vtbar_alloc(vtb_ring_allocator* vtbra, int32_t size)
 		if ((int32_t)sizeof(vtb__memory_section_header) + size > vtbra->vtb__m_memory_size)
 		{
 			VTBAR__ASSERT(false);
-			return 0;
+			return vtbar__full(vtbra);
 		}
 
 		vtbra->vtb__m_num_allocations++;
@@ -275,6 +990,8 @@ VTBARDEF void* vtbar_alloc(vtb_ring_allocator* vtbra, int32_t size)
 		header->m_length = size;
 		header->m_next = -1;
 
+		vtbar__grew(vtbra);
+
 		return (void*)(header+1);
 	}
 
@@ -283,12 +1000,12 @@ VTBARDEF void* vtbar_alloc(vtb_ring_allocator* vtbra, int32_t size)
 		limit = vtbra->vtb__m_tail_index;
 
 	vtb__memory_section_header* header = (vtb__memory_section_header*)&vtbra->vtb__m_memory[vtbra->vtb__m_head_index];
-	if (vtbra->vtb__m_head_index + header->m_length + 2*(int)sizeof(vtb__memory_section_header) + size <= limit)
+	if (vtbra->vtb__m_head_index + VTBAR__LENGTH(header) + 2*(int)sizeof(vtb__memory_section_header) + size <= limit)
 	{
 		vtbra->vtb__m_num_allocations++;
 		vtbra->vtb__m_size_allocations += size + (int)sizeof(vtb__memory_section_header);
 
-		vtbra->vtb__m_head_index += (int)sizeof(vtb__memory_section_header) + header->m_length;
+		vtbra->vtb__m_head_index += (int)sizeof(vtb__memory_section_header) + VTBAR__LENGTH(header);
 		vtb__memory_section_header* new_header = (vtb__memory_section_header*)&vtbra->vtb__m_memory[vtbra->vtb__m_head_index];
 
 		new_header->m_length = size;
@@ -296,6 +1013,8 @@ VTBARDEF void* vtbar_alloc(vtb_ring_allocator* vtbra, int32_t size)
 
 		header->m_next = vtbra->vtb__m_head_index;
 
+		vtbar__grew(vtbra);
+
 		return (void*)(new_header+1);
 	}
 	// Not enough room at the end. Is there enough room at the beginning?
@@ -313,10 +1032,46 @@ VTBARDEF void* vtbar_alloc(vtb_ring_allocator* vtbra, int32_t size)
 
 		header->m_next = vtbra->vtb__m_head_index;
 
+		vtbar__grew(vtbra);
+
 		return (void*)(new_header+1);
 	}
 
-	return 0;
+	return vtbar__full(vtbra);
+}
+
+VTBARDEF void* vtbar_realloc_head(vtb_ring_allocator* vtbra, void* ptr, int32_t size)
+{
+	VTBAR__CHECK(size > 0);
+	VTBAR__CHECK(vtbra->vtb__m_memory); // Call initialize first
+	VTBAR__CHECK(vtbra->vtb__m_head_index >= 0); // Nothing has been allocated
+
+	vtb__memory_section_header* header = (vtb__memory_section_header*)&vtbra->vtb__m_memory[vtbra->vtb__m_head_index];
+	VTBAR__CHECK(ptr == (void*)(header+1)); // Only the head can be resized
+	VTBAR__CHECK(!(header->m_length & VTBAR__DEAD)); // Already freed
+
+	if (size%(int32_t)sizeof(size_t) != 0)
+		size += (int32_t)sizeof(size_t) - size%(int32_t)sizeof(size_t);
+
+	// Same limit as vtbar_alloc: the tail if we've wrapped around behind it,
+	// otherwise the end of memory.
+	int32_t limit = vtbra->vtb__m_memory_size;
+	if (vtbra->vtb__m_head_index < vtbra->vtb__m_tail_index)
+		limit = vtbra->vtb__m_tail_index;
+
+	if (size > VTBAR__LENGTH(header) && vtbra->vtb__m_head_index + (int32_t)sizeof(vtb__memory_section_header) + size > limit)
+		return 0;
+
+	int32_t old_size = VTBAR__LENGTH(header);
+	vtbra->vtb__m_size_allocations += size - old_size;
+	header->m_length = size;
+
+	if (size > old_size)
+		vtbar__grew(vtbra);
+	else
+		vtbar__shrank(vtbra);
+
+	return ptr;
 }
 
 VTBARDEF void vtbar_peektail(vtb_ring_allocator* vtbra, void** start, int32_t* length)
@@ -334,13 +1089,15 @@ VTBARDEF void vtbar_peektail(vtb_ring_allocator* vtbra, void** start, int32_t* l
 
 	uint8_t* memory = &vtbra->vtb__m_memory[vtbra->vtb__m_tail_index];
 	vtb__memory_section_header* header = (vtb__memory_section_header*)memory;
-	*length = header->m_length;
+	VTBAR__ASSERT(!(header->m_length & VTBAR__DEAD));
+	*length = VTBAR__LENGTH(header);
 	*start = (void*)(header+1);
 }
 
 VTBARDEF void vtbar_freetail(vtb_ring_allocator* vtbra, void** start, int32_t* length)
 {
 	VTBAR__CHECK(vtbra->vtb__m_memory); // Call initialize first
+	VTBAR__CHECK(!vtbra->vtb__m_draining); // Can't free from inside vtbar_drain
 
 	if (vtbar_isempty(vtbra))
 	{
@@ -354,8 +1111,10 @@ VTBARDEF void vtbar_freetail(vtb_ring_allocator* vtbra, void** start, int32_t* l
 
 	vtb__memory_section_header* header = (vtb__memory_section_header*)&vtbra->vtb__m_memory[vtbra->vtb__m_tail_index];
 
+	VTBAR__ASSERT(!(header->m_length & VTBAR__DEAD));
+
 	if (length)
-		*length = header->m_length;
+		*length = VTBAR__LENGTH(header);
 
 	if (start)
 		*start = (void*)(header+1);
@@ -366,7 +1125,146 @@ VTBARDEF void vtbar_freetail(vtb_ring_allocator* vtbra, void** start, int32_t* l
 		vtbra->vtb__m_head_index = vtbra->vtb__m_tail_index = -1;
 
 	vtbra->vtb__m_num_allocations--;
-	vtbra->vtb__m_size_allocations -= header->m_length + (int)sizeof(vtb__memory_section_header);
+	vtbra->vtb__m_size_allocations -= VTBAR__LENGTH(header) + (int)sizeof(vtb__memory_section_header);
+
+	vtbar__skipdead(vtbra);
+	vtbar__shrank(vtbra);
+}
+
+VTBARDEF int32_t vtbar_drain(vtb_ring_allocator* vtbra, vtbar_drain_function function, void* data, int32_t max)
+{
+	VTBAR__CHECK(vtbra->vtb__m_memory); // Call initialize first
+	VTBAR__CHECK(function);
+	VTBAR__CHECK(max >= 0);
+	VTBAR__CHECK(!vtbra->vtb__m_draining); // Can't free from inside vtbar_drain
+
+	if (vtbra->vtb__m_tail_index < 0)
+		return 0;
+
+	uint8_t* memory = vtbra->vtb__m_memory;
+	int32_t memory_size = vtbra->vtb__m_memory_size;
+
+	int32_t drained = 0;
+	int32_t freed_size = 0;
+	int32_t index = vtbra->vtb__m_tail_index;
+	int32_t prefetched = index; // Everything from index up to here has been prefetched.
+
+	// drained and freed_size only go into the counters at the end, and
+	// index is ahead of the tail, so a free from function or a pressure
+	// function would work on stale state.
+	vtbra->vtb__m_draining = 1;
+
+	// The tail is always live, see vtbar__skipdead.
+	for (;;)
+	{
+		int32_t limit = index + VTBAR_PREFETCH_DISTANCE;
+		if (limit > memory_size)
+			limit = memory_size;
+
+		for (; prefetched < limit; prefetched += 64)
+			VTBAR__PREFETCH(&memory[prefetched]);
+
+		vtb__memory_section_header* header = (vtb__memory_section_header*)&memory[index];
+
+		// The tail only moves once we're done, but that just makes alloc
+		// more conservative.
+		function(data, (void*)(header+1), VTBAR__LENGTH(header));
+
+		drained++;
+
+		// Read after the call in case it alloc'd, or resized this section
+		// with vtbar_realloc_head.
+		freed_size += VTBAR__LENGTH(header) + (int32_t)sizeof(vtb__memory_section_header);
+		int32_t next = header->m_next;
+
+		// Skip anything freed with vtbar_free.
+		while (next >= 0)
+		{
+			vtb__memory_section_header* next_header = (vtb__memory_section_header*)&memory[next];
+			if (!(next_header->m_length & VTBAR__DEAD))
+				break;
+
+			vtbra->vtb__m_num_dead--;
+			vtbra->vtb__m_size_dead -= VTBAR__LENGTH(next_header) + (int32_t)sizeof(vtb__memory_section_header);
+			next = next_header->m_next;
+		}
+
+		if (next < 0)
+		{
+			vtbra->vtb__m_head_index = vtbra->vtb__m_tail_index = -1;
+			break;
+		}
+
+		// Wrapped around to the start of memory.
+		if (next < index)
+			prefetched = next;
+
+		index = next;
+
+		if (drained == max)
+		{
+			vtbra->vtb__m_tail_index = index;
+			break;
+		}
+	}
+
+	vtbra->vtb__m_draining = 0;
+
+	vtbra->vtb__m_num_allocations -= drained;
+	vtbra->vtb__m_size_allocations -= freed_size;
+
+	vtbar__shrank(vtbra);
+
+	return drained;
+}
+
+VTBARDEF void vtbar_free(vtb_ring_allocator* vtbra, void* ptr)
+{
+	VTBAR__CHECK(vtbra->vtb__m_memory); // Call initialize first
+	VTBAR__CHECK(!vtbra->vtb__m_draining); // Can't free from inside vtbar_drain
+	VTBAR__CHECK(!vtbar_isempty(vtbra));
+	VTBAR__CHECK((uint8_t*)ptr > vtbra->vtb__m_memory && (uint8_t*)ptr < vtbra->vtb__m_memory + vtbra->vtb__m_memory_size);
+
+	vtb__memory_section_header* header = (vtb__memory_section_header*)ptr - 1;
+	VTBAR__CHECK(!(header->m_length & VTBAR__DEAD)); // Double free
+
+	if ((uint8_t*)header == &vtbra->vtb__m_memory[vtbra->vtb__m_tail_index])
+	{
+		vtbar_freetail(vtbra, 0, 0);
+		return;
+	}
+
+	vtbra->vtb__m_num_allocations--;
+	vtbra->vtb__m_size_allocations -= VTBAR__LENGTH(header) + (int)sizeof(vtb__memory_section_header);
+	vtbra->vtb__m_num_dead++;
+	vtbra->vtb__m_size_dead += VTBAR__LENGTH(header) + (int)sizeof(vtb__memory_section_header);
+
+	header->m_length |= VTBAR__DEAD;
+
+	vtbar__shrank(vtbra);
+}
+
+VTBARDEF void vtbar_setwatermarks(vtb_ring_allocator* vtbra, int32_t high, int32_t low, vtbar_pressure_function function, void* data)
+{
+	VTBAR__CHECK(vtbra->vtb__m_memory); // Call initialize first
+	VTBAR__CHECK(high >= 0 && low >= 0);
+	VTBAR__CHECK(!high || low < high);
+
+	vtbra->vtb__m_pressure_function = high ? function : 0;
+	vtbra->vtb__m_pressure_data = data;
+	vtbra->vtb__m_high_watermark = high ? high : VTBAR__NO_WATERMARK;
+	vtbra->vtb__m_low_watermark = low;
+	vtbra->vtb__m_above_watermark = 0;
+
+	// Already over it counts as reaching it.
+	vtbar__grew(vtbra);
+}
+
+VTBARDEF int vtbar_isabovewatermark(vtb_ring_allocator* vtbra)
+{
+	VTBAR__CHECK(vtbra->vtb__m_memory); // Call initialize first
+
+	return vtbra->vtb__m_above_watermark;
 }
 
 VTBARDEF int vtbar_isempty(vtb_ring_allocator* vtbra)
@@ -390,6 +1288,20 @@ VTBARDEF int vtbar_getsizeallocations(vtb_ring_allocator* vtbra)
 	return vtbra->vtb__m_size_allocations;
 }
 
+VTBARDEF int vtbar_getnumdead(vtb_ring_allocator* vtbra)
+{
+	VTBAR__CHECK(vtbra->vtb__m_memory); // Call initialize first
+
+	return vtbra->vtb__m_num_dead;
+}
+
+VTBARDEF int vtbar_getsizedead(vtb_ring_allocator* vtbra)
+{
+	VTBAR__CHECK(vtbra->vtb__m_memory); // Call initialize first
+
+	return vtbra->vtb__m_size_dead;
+}
+
 VTBARDEF int vtbar_getmemorysize(vtb_ring_allocator* vtbra)
 {
 	VTBAR__CHECK(vtbra->vtb__m_memory); // Call initialize first
@@ -409,4 +1321,146 @@ VTBARDEF int vtbar_getheadersize()
 	return sizeof(vtb__memory_section_header);
 }
 
+#ifdef VTBAR__CLAIM_RING
+
+VTBARDEF void vtbar_claim_initialize(vtb_claim_ring* vtbcr, void* memory, int32_t memory_size, int32_t max_sections)
+{
+	VTBAR__CHECK(max_sections > 0 && (max_sections & (max_sections - 1)) == 0); // Must be a power of 2
+	VTBAR__CHECK(memory_size > max_sections*(int32_t)sizeof(vtb__claim_slot));
+
+	// The table goes first, it keeps the ring memory aligned.
+	vtbcr->vtb__m_slots = (vtb__claim_slot*)memory;
+	vtbcr->vtb__m_num_slots = max_sections;
+	vtbar_initialize(&vtbcr->vtb__m_allocator, vtbcr->vtb__m_slots + max_sections, memory_size - max_sections*(int32_t)sizeof(vtb__claim_slot));
+
+	vtbcr->vtb__m_reclaimed = 0;
+	vtbcr->vtb__m_pending = 0;
+	vtbcr->vtb__m_flags = 0;
+	vtbcr->vtb__m_published = 0;
+	vtbcr->vtb__m_claimed = 0;
+}
+
+VTBARDEF void vtbar_claim_initializememory(vtb_claim_ring* vtbcr, int32_t memory_size, int32_t max_sections)
+{
+#ifndef VTBAR_NO_MALLOC
+	VTBAR__CHECK(max_sections > 0 && max_sections < 99999999);
+	VTBAR__CHECK(memory_size > 0 && memory_size < 99999999);
+
+	int32_t total_size = memory_size + max_sections*(int32_t)sizeof(vtb__claim_slot);
+	vtbar_claim_initialize(vtbcr, malloc(total_size), total_size, max_sections);
+
+	vtbcr->vtb__m_flags = 1;
+#else
+	vtbcr = vtbcr;
+	memory_size = memory_size;
+	max_sections = max_sections;
+	VTBAR__CHECK(false);
+#endif
+}
+
+VTBARDEF void vtbar_claim_destroy(vtb_claim_ring* vtbcr)
+{
+#ifndef VTBAR_NO_MALLOC
+	if (vtbcr->vtb__m_flags)
+	{
+		VTBAR__CHECK(vtbcr->vtb__m_slots); // Double free
+		free(vtbcr->vtb__m_slots);
+	}
+#endif
+
+	vtbcr->vtb__m_slots = 0;
+	vtbar_destroy(&vtbcr->vtb__m_allocator);
+}
+
+VTBARDEF int32_t vtbar_claim_reclaim(vtb_claim_ring* vtbcr)
+{
+	VTBAR__CHECK(vtbcr->vtb__m_slots); // Call initialize first
+
+	// Only the producer writes m_published, so it can read it plainly.
+	int64_t published = vtbcr->vtb__m_published;
+
+	// Sections are published in the order they're alloc'd, so the one at
+	// the allocator's tail is always number m_reclaimed.
+	while (vtbcr->vtb__m_reclaimed < published)
+	{
+		vtb__claim_slot* slot = &vtbcr->vtb__m_slots[vtbcr->vtb__m_reclaimed & (vtbcr->vtb__m_num_slots - 1)];
+		if (!VTBAR__LOAD32(&slot->m_done))
+			break;
+
+		vtbar_freetail(&vtbcr->vtb__m_allocator, 0, 0);
+		vtbcr->vtb__m_reclaimed++;
+	}
+
+	return (int32_t)(published - vtbcr->vtb__m_reclaimed);
+}
+
+VTBARDEF void* vtbar_claim_alloc(vtb_claim_ring* vtbcr, int32_t size)
+{
+	VTBAR__CHECK(vtbcr->vtb__m_slots); // Call initialize first
+	VTBAR__CHECK(!vtbcr->vtb__m_pending); // Publish the last one first
+
+	if (vtbar_claim_reclaim(vtbcr) == vtbcr->vtb__m_num_slots)
+		return 0;
+
+	vtbcr->vtb__m_pending = vtbar_alloc(&vtbcr->vtb__m_allocator, size);
+	return vtbcr->vtb__m_pending;
+}
+
+VTBARDEF void vtbar_claim_publish(vtb_claim_ring* vtbcr)
+{
+	VTBAR__CHECK(vtbcr->vtb__m_pending); // Nothing was alloc'd
+
+	int64_t sequence = vtbcr->vtb__m_published;
+	vtb__claim_slot* slot = &vtbcr->vtb__m_slots[sequence & (vtbcr->vtb__m_num_slots - 1)];
+
+	// Nobody else looks at the slot until the release below.
+	slot->m_index = (int32_t)((uint8_t*)vtbcr->vtb__m_pending - vtbcr->vtb__m_allocator.vtb__m_memory) - (int32_t)sizeof(vtb__memory_section_header);
+	slot->m_done = 0;
+
+	vtbcr->vtb__m_pending = 0;
+
+	VTBAR__STORE64(&vtbcr->vtb__m_published, sequence + 1);
+}
+
+VTBARDEF int vtbar_claim_next(vtb_claim_ring* vtbcr, vtb_claim* claim)
+{
+	VTBAR__CHECK(vtbcr->vtb__m_slots); // Call initialize first
+
+	int64_t sequence = VTBAR__LOAD64(&vtbcr->vtb__m_claimed);
+
+	do
+	{
+		if (sequence >= VTBAR__LOAD64(&vtbcr->vtb__m_published))
+			return 0;
+	} while (!VTBAR__CAS64(&vtbcr->vtb__m_claimed, &sequence, sequence + 1));
+
+	// The acquire above makes the slot and the section visible. The producer
+	// can't reuse either until this is released.
+	vtb__claim_slot* slot = &vtbcr->vtb__m_slots[sequence & (vtbcr->vtb__m_num_slots - 1)];
+	vtb__memory_section_header* header = (vtb__memory_section_header*)&vtbcr->vtb__m_allocator.vtb__m_memory[slot->m_index];
+
+	claim->start = (void*)(header+1);
+	claim->length = VTBAR__LENGTH(header);
+	claim->sequence = sequence;
+
+	return 1;
+}
+
+VTBARDEF void vtbar_claim_release(vtb_claim_ring* vtbcr, vtb_claim* claim)
+{
+	VTBAR__CHECK(vtbcr->vtb__m_slots); // Call initialize first
+	VTBAR__CHECK(claim->start); // Already released
+
+	vtb__claim_slot* slot = &vtbcr->vtb__m_slots[claim->sequence & (vtbcr->vtb__m_num_slots - 1)];
+	VTBAR__ASSERT(!VTBAR__LOAD32(&slot->m_done));
+
+	claim->start = 0;
+
+	// Release, so whatever the consumer did with the section happens before
+	// the producer writes over it.
+	VTBAR__STORE32(&slot->m_done, 1);
+}
+
+#endif // VTBAR__CLAIM_RING
+
 #endif
\ No newline at end of file
@@ -0,0 +1,518 @@
+/*
+vtb_dirty.h - public domain change tracking for big blocks of memory
+
+This software is dual-licensed to the public domain and under the
+following license: you are granted a perpetual, irrevocable license
+to copy, modify, publish, and distribute this file as you see fit.
+
+This keeps a hash of every fixed size block of a region of memory and
+tells you which blocks changed since you last asked. It only rehashes the
+blocks that were written to, so snapshotting or replicating a big table
+costs time in proportion to what changed, not to how big it is.
+
+Blocks get marked dirty in one of two ways. You can mark them yourself
+when you write to them, or vtbd_protect() can write protect the region and
+catch the first write to each block with a SIGSEGV handler, after which
+the block is writable again at full speed until the next vtbd_update().
+Either way a dirty block is only reported if its hash changed, so writing
+the same bytes back isn't a change.
+
+Blocks are hashed with vtbh_crc32c from vtb_hash.h, which uses the CPU's
+crc32 instruction when there is one, so you also need to
+#define VTB_HASH_IMPLEMENTATION in one file.
+
+
+COMPILING AND LINKING
+	You must
+
+	#define VTB_DIRTY_IMPLEMENTATION
+
+	in exactly one C++ file that includes this header, before the include
+	like this:
+
+	#define VTB_DIRTY_IMPLEMENTATION
+	#include "vtb_dirty.h"
+
+	All other files can be just #include "vtb_dirty.h" without the #define
+
+	vtbd_protect() needs POSIX signals and mprotect, and GCC or clang for
+	the atomics the signal handler uses. In strict C mode, define
+	_POSIX_C_SOURCE 200809L before including anything. Without them, or on
+	Windows, vtbd_protect() returns 0 and you mark blocks yourself.
+
+
+QUICK START
+	vtb_dirty d;
+	vtbd_initializememory(&d, table, table_size, 4096); // Hashes every block once
+
+	vtbd_protect(&d); // Optional, or call vtbd_markdirty() as you write
+
+	... write to the table ...
+
+	size_t changed[64];
+	size_t num_changed;
+	do
+	{
+		num_changed = vtbd_update(&d, changed, 64);
+		for (size_t k = 0; k < num_changed; k++)
+			send_block(table + changed[k]*4096);
+	} while (num_changed == 64);
+
+	vtbd_destroy(&d);
+
+
+WRITE PROTECTION
+	The region and the block size have to be multiples of the page size.
+	The handler is installed the first time anything is protected and
+	passes faults outside protected regions on to whatever handler was
+	there before, so install your own crash handlers first. Up to
+	VTBD_MAX_PROTECTED regions (default 16) can be protected at once.
+
+	The first write to each block after an update costs a fault, a few
+	microseconds. That's a good trade for big tables where a small part
+	changes between snapshots. If most of a table changes every time, skip
+	vtbd_protect() and call vtbd_markall() before vtbd_update().
+
+	Blocks written from other threads while vtbd_update() is running are
+	caught, either by the hash or by the next fault, and show up in this
+	update or the next one.
+
+
+ASSERT
+	Define VTBD_ASSERT(boolval) to override assert() and not use assert.h
+*/
+
+#ifndef VTB__DIRTY_H
+#define VTB__DIRTY_H
+
+#ifdef VTBD_STATIC
+#define VTBDDEF static
+#else
+#ifdef __cplusplus
+#define VTBDDEF extern "C"
+#else
+#define VTBDDEF extern
+#endif
+#endif
+
+#include <stdint.h> // For uint8_t/uint32_t
+#include <stddef.h> // For size_t
+
+#include "vtb_hash.h"
+
+#ifndef VTB__PRIVATE_MEMBER
+#define VTB__PRIVATE_MEMBER(type, name) type vtb__##name
+#endif
+
+// WARNING: Don't directly reference members of this struct. I reserve
+// the right to change them from version to version.
+typedef struct
+{
+	VTB__PRIVATE_MEMBER(uint8_t*, m_region);
+	VTB__PRIVATE_MEMBER(size_t, m_region_size);
+	VTB__PRIVATE_MEMBER(size_t, m_block_size);
+	VTB__PRIVATE_MEMBER(size_t, m_num_blocks);
+	VTB__PRIVATE_MEMBER(uint32_t*, m_hashes); // One per block.
+	VTB__PRIVATE_MEMBER(uint8_t*, m_dirty);   // One per block, 1 if it may have changed.
+	VTB__PRIVATE_MEMBER(void*, m_index);      // What to free, if we allocated it.
+	VTB__PRIVATE_MEMBER(uint8_t, m_flags);    // VTBD__FREE and VTBD__PROTECTED.
+} vtb_dirty;
+
+// The memory vtbd_initialize needs for its index of a region this big.
+VTBDDEF size_t vtbd_getindexsize(size_t region_size, size_t block_size);
+
+// Starts tracking region, hashing every block. The index goes in the
+// memory you provide, which must be at least vtbd_getindexsize() bytes.
+// The last block is shorter if region_size isn't a multiple of block_size.
+VTBDDEF void vtbd_initialize(vtb_dirty* d, void* region, size_t region_size, size_t block_size, void* index, size_t index_size);
+
+// This initializer will allocate the index for you, for convenience.
+// It will be freed when you call vtbd_destroy().
+VTBDDEF void vtbd_initializememory(vtb_dirty* d, void* region, size_t region_size, size_t block_size);
+
+// Stops tracking. If the region is protected it's made writable again.
+VTBDDEF void vtbd_destroy(vtb_dirty* d);
+
+// Marks the blocks under size bytes at start as possibly changed.
+VTBDDEF void vtbd_markdirty(vtb_dirty* d, const void* start, size_t size);
+
+// Marks every block, for when you don't know what changed.
+VTBDDEF void vtbd_markall(vtb_dirty* d);
+
+// Write protects the region so the first write to each block marks it.
+// Returns 1 if it worked, 0 if the platform can't, the region or block
+// size isn't a multiple of the page size, or VTBD_MAX_PROTECTED regions
+// are already protected.
+VTBDDEF int vtbd_protect(vtb_dirty* d);
+
+// Makes the region writable again and stops catching writes.
+VTBDDEF void vtbd_unprotect(vtb_dirty* d);
+
+// Rehashes the dirty blocks, in order, and writes the index of each one
+// whose hash changed to changed. Returns how many it wrote. If that's
+// max_changed, call it again, the dirty blocks it didn't get to are still
+// dirty. Blocks it looked at are clean afterwards, and protected again.
+VTBDDEF size_t vtbd_update(vtb_dirty* d, size_t* changed, size_t max_changed);
+
+// Returns the number of blocks that are marked dirty.
+VTBDDEF size_t vtbd_getnumdirty(const vtb_dirty* d);
+
+VTBDDEF size_t vtbd_getnumblocks(const vtb_dirty* d);
+VTBDDEF size_t vtbd_getblocksize(const vtb_dirty* d);
+
+// The hash of the block as of the last update.
+VTBDDEF uint32_t vtbd_gethash(const vtb_dirty* d, size_t block);
+
+#endif // VTB__DIRTY_H
+
+
+
+#ifdef VTB_DIRTY_IMPLEMENTATION
+
+#ifndef VTBD_ASSERT
+#include <assert.h>
+#define VTBD_ASSERT(x) assert(x)
+#endif
+
+#ifdef VTBD_DEBUG
+#define VTBD__ASSERT VTBD_ASSERT
+#define VTBD__CHECK VTBD_ASSERT
+#else
+#define VTBD__ASSERT(x)
+#define VTBD__CHECK VTBD_ASSERT
+#endif
+
+#ifndef VTBD_NO_MALLOC
+#include <stdlib.h>
+#endif
+
+#include <string.h> // For memset/memcpy
+
+#ifndef VTBD_MAX_PROTECTED
+#define VTBD_MAX_PROTECTED 16
+#endif
+
+#define VTBD__FREE 1
+#define VTBD__PROTECTED 2
+
+// The signal handler sets dirty flags while vtbd_update clears them, and
+// reads the table of protected regions while vtbd_protect changes it.
+#if defined(__GNUC__) || defined(__clang__)
+#define VTBD__LOADFLAG(p) __atomic_load_n(p, __ATOMIC_RELAXED)
+#define VTBD__STOREFLAG(p, value) __atomic_store_n(p, value, __ATOMIC_RELAXED)
+#define VTBD__LOADREGION(p) __atomic_load_n(p, __ATOMIC_ACQUIRE)
+#define VTBD__STOREREGION(p, value) __atomic_store_n(p, value, __ATOMIC_RELEASE)
+#else
+// No signal handler without these, so only mark calls write the flags.
+#define VTBD__LOADFLAG(p) (*(volatile uint8_t*)(p))
+#define VTBD__STOREFLAG(p, value) (*(volatile uint8_t*)(p) = (uint8_t)(value))
+#endif
+
+#if (defined(__unix__) || defined(__APPLE__)) && defined(VTBD__LOADREGION)
+#include <signal.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#if defined(SA_SIGINFO) && defined(PROT_READ) // Missing in strict C without _POSIX_C_SOURCE
+#define VTBD__PROTECT
+#endif
+#endif
+
+// The last block is short if the region isn't a multiple of the block size.
+static size_t vtbd__getblocksize(const vtb_dirty* d, size_t block)
+{
+	size_t size = d->vtb__m_region_size - block * d->vtb__m_block_size;
+	return size < d->vtb__m_block_size ? size : d->vtb__m_block_size;
+}
+
+static uint32_t vtbd__hashblock(const vtb_dirty* d, size_t block)
+{
+	vtb_crc32c c = vtbh_crc32c_new();
+	vtbh_crc32c(&c, d->vtb__m_region + block * d->vtb__m_block_size, vtbd__getblocksize(d, block));
+	return c.crc;
+}
+
+#ifdef VTBD__PROTECT
+
+static vtb_dirty* vtbd__protected[VTBD_MAX_PROTECTED];
+static struct sigaction vtbd__previous_segv;
+#ifdef __APPLE__
+static struct sigaction vtbd__previous_bus; // Some versions of macOS raise SIGBUS for these.
+#endif
+static int vtbd__installed;
+
+static void vtbd__onfault(int signal_number, siginfo_t* info, void* context)
+{
+	uint8_t* address = (uint8_t*)info->si_addr;
+
+	for (int k = 0; k < VTBD_MAX_PROTECTED; k++)
+	{
+		vtb_dirty* d = VTBD__LOADREGION(&vtbd__protected[k]);
+		if (!d || address < d->vtb__m_region || address >= d->vtb__m_region + d->vtb__m_region_size)
+			continue;
+
+		// Mark the block and let the write through. Returning runs it again.
+		size_t block = (size_t)(address - d->vtb__m_region) / d->vtb__m_block_size;
+		VTBD__STOREFLAG(&d->vtb__m_dirty[block], 1);
+		mprotect(d->vtb__m_region + block * d->vtb__m_block_size, vtbd__getblocksize(d, block), PROT_READ | PROT_WRITE);
+		return;
+	}
+
+	// Not ours, pass it on.
+	struct sigaction* previous = &vtbd__previous_segv;
+#ifdef __APPLE__
+	if (signal_number == SIGBUS)
+		previous = &vtbd__previous_bus;
+#endif
+
+	if (previous->sa_flags & SA_SIGINFO)
+		previous->sa_sigaction(signal_number, info, context);
+	else if (previous->sa_handler != SIG_DFL && previous->sa_handler != SIG_IGN)
+		previous->sa_handler(signal_number);
+	else
+		signal(signal_number, SIG_DFL); // Returning faults again, and this time it's fatal.
+}
+
+static size_t vtbd__pagesize(void)
+{
+	return (size_t)sysconf(_SC_PAGESIZE);
+}
+
+#endif
+
+VTBDDEF size_t vtbd_getindexsize(size_t region_size, size_t block_size)
+{
+	VTBD__CHECK(block_size > 0);
+
+	size_t num_blocks = (region_size + block_size - 1) / block_size;
+	return num_blocks * (sizeof(uint32_t) + 1);
+}
+
+VTBDDEF void vtbd_initialize(vtb_dirty* d, void* region, size_t region_size, size_t block_size, void* index, size_t index_size)
+{
+	VTBD__CHECK(region && region_size > 0);
+	VTBD__CHECK(block_size > 0);
+	VTBD__CHECK(index && index_size >= vtbd_getindexsize(region_size, block_size));
+	VTBD__CHECK(((size_t)index) % sizeof(uint32_t) == 0); // Can't handle unaligned memory.
+
+	d->vtb__m_region = (uint8_t*)region;
+	d->vtb__m_region_size = region_size;
+	d->vtb__m_block_size = block_size;
+	d->vtb__m_num_blocks = (region_size + block_size - 1) / block_size;
+	d->vtb__m_hashes = (uint32_t*)index;
+	d->vtb__m_dirty = (uint8_t*)(d->vtb__m_hashes + d->vtb__m_num_blocks);
+	d->vtb__m_index = index;
+	d->vtb__m_flags = 0;
+
+	memset(d->vtb__m_dirty, 0, d->vtb__m_num_blocks);
+
+	for (size_t k = 0; k < d->vtb__m_num_blocks; k++)
+		d->vtb__m_hashes[k] = vtbd__hashblock(d, k);
+}
+
+VTBDDEF void vtbd_initializememory(vtb_dirty* d, void* region, size_t region_size, size_t block_size)
+{
+#ifndef VTBD_NO_MALLOC
+	size_t index_size = vtbd_getindexsize(region_size, block_size);
+	vtbd_initialize(d, region, region_size, block_size, malloc(index_size), index_size);
+
+	d->vtb__m_flags |= VTBD__FREE;
+#else
+	d = d;
+	region = region;
+	region_size = region_size;
+	block_size = block_size;
+	VTBD__CHECK(0);
+#endif
+}
+
+VTBDDEF void vtbd_destroy(vtb_dirty* d)
+{
+	if (d->vtb__m_flags & VTBD__PROTECTED)
+		vtbd_unprotect(d);
+
+#ifndef VTBD_NO_MALLOC
+	if (d->vtb__m_flags & VTBD__FREE)
+	{
+		VTBD__CHECK(d->vtb__m_index); // Double free
+		free(d->vtb__m_index);
+	}
+#endif
+
+	d->vtb__m_index = 0;
+	d->vtb__m_hashes = 0;
+	d->vtb__m_dirty = 0;
+}
+
+VTBDDEF void vtbd_markdirty(vtb_dirty* d, const void* start, size_t size)
+{
+	VTBD__CHECK(d->vtb__m_hashes); // Call initialize first
+	VTBD__CHECK((const uint8_t*)start >= d->vtb__m_region && (const uint8_t*)start + size <= d->vtb__m_region + d->vtb__m_region_size);
+
+	if (!size)
+		return;
+
+	size_t first = (size_t)((const uint8_t*)start - d->vtb__m_region) / d->vtb__m_block_size;
+	size_t last = (size_t)((const uint8_t*)start + size - 1 - d->vtb__m_region) / d->vtb__m_block_size;
+
+	for (size_t k = first; k <= last; k++)
+		VTBD__STOREFLAG(&d->vtb__m_dirty[k], 1);
+}
+
+VTBDDEF void vtbd_markall(vtb_dirty* d)
+{
+	VTBD__CHECK(d->vtb__m_hashes); // Call initialize first
+
+	for (size_t k = 0; k < d->vtb__m_num_blocks; k++)
+		VTBD__STOREFLAG(&d->vtb__m_dirty[k], 1);
+}
+
+VTBDDEF int vtbd_protect(vtb_dirty* d)
+{
+	VTBD__CHECK(d->vtb__m_hashes); // Call initialize first
+	VTBD__CHECK(!(d->vtb__m_flags & VTBD__PROTECTED)); // Already protected
+
+#ifdef VTBD__PROTECT
+	size_t page_size = vtbd__pagesize();
+	if ((size_t)d->vtb__m_region % page_size || d->vtb__m_region_size % page_size || d->vtb__m_block_size % page_size)
+		return 0;
+
+	if (!vtbd__installed)
+	{
+		struct sigaction action;
+		memset(&action, 0, sizeof(action));
+		action.sa_sigaction = vtbd__onfault;
+		action.sa_flags = SA_SIGINFO;
+		sigemptyset(&action.sa_mask);
+
+		if (sigaction(SIGSEGV, &action, &vtbd__previous_segv) != 0)
+			return 0;
+#ifdef __APPLE__
+		sigaction(SIGBUS, &action, &vtbd__previous_bus);
+#endif
+
+		vtbd__installed = 1;
+	}
+
+	int slot = 0;
+	while (slot < VTBD_MAX_PROTECTED && vtbd__protected[slot])
+		slot++;
+
+	if (slot == VTBD_MAX_PROTECTED)
+		return 0;
+
+	// Registered before the first fault can happen.
+	VTBD__STOREREGION(&vtbd__protected[slot], d);
+
+	if (mprotect(d->vtb__m_region, d->vtb__m_region_size, PROT_READ) != 0)
+	{
+		VTBD__STOREREGION(&vtbd__protected[slot], (vtb_dirty*)0);
+		return 0;
+	}
+
+	d->vtb__m_flags |= VTBD__PROTECTED;
+	return 1;
+#else
+	return 0;
+#endif
+}
+
+VTBDDEF void vtbd_unprotect(vtb_dirty* d)
+{
+	VTBD__CHECK(d->vtb__m_hashes); // Call initialize first
+
+#ifdef VTBD__PROTECT
+	if (!(d->vtb__m_flags & VTBD__PROTECTED))
+		return;
+
+	mprotect(d->vtb__m_region, d->vtb__m_region_size, PROT_READ | PROT_WRITE);
+
+	for (int k = 0; k < VTBD_MAX_PROTECTED; k++)
+	{
+		if (vtbd__protected[k] == d)
+			VTBD__STOREREGION(&vtbd__protected[k], (vtb_dirty*)0);
+	}
+
+	d->vtb__m_flags &= ~VTBD__PROTECTED;
+#endif
+}
+
+VTBDDEF size_t vtbd_update(vtb_dirty* d, size_t* changed, size_t max_changed)
+{
+	VTBD__CHECK(d->vtb__m_hashes); // Call initialize first
+	VTBD__CHECK(changed || !max_changed);
+
+	size_t num_changed = 0;
+	size_t num_blocks = d->vtb__m_num_blocks;
+	uint8_t* dirty = d->vtb__m_dirty;
+
+	for (size_t k = 0; k < num_blocks && num_changed < max_changed; k++)
+	{
+		// Most blocks are clean, skip them 8 at a time.
+		if ((k & 7) == 0 && k + 8 <= num_blocks)
+		{
+			uint64_t eight;
+			memcpy(&eight, &dirty[k], sizeof(eight));
+			if (!eight)
+			{
+				k += 7;
+				continue;
+			}
+		}
+
+		if (!VTBD__LOADFLAG(&dirty[k]))
+			continue;
+
+		// Clean and protected before it's hashed, so a write from here on
+		// either makes it into the hash or marks it again.
+		VTBD__STOREFLAG(&dirty[k], 0);
+
+#ifdef VTBD__PROTECT
+		if (d->vtb__m_flags & VTBD__PROTECTED)
+			mprotect(d->vtb__m_region + k * d->vtb__m_block_size, vtbd__getblocksize(d, k), PROT_READ);
+#endif
+
+		uint32_t hash = vtbd__hashblock(d, k);
+		if (hash != d->vtb__m_hashes[k])
+		{
+			d->vtb__m_hashes[k] = hash;
+			changed[num_changed++] = k;
+		}
+	}
+
+	return num_changed;
+}
+
+VTBDDEF size_t vtbd_getnumdirty(const vtb_dirty* d)
+{
+	VTBD__CHECK(d->vtb__m_hashes); // Call initialize first
+
+	size_t num_dirty = 0;
+	for (size_t k = 0; k < d->vtb__m_num_blocks; k++)
+		num_dirty += VTBD__LOADFLAG(&d->vtb__m_dirty[k]);
+
+	return num_dirty;
+}
+
+VTBDDEF size_t vtbd_getnumblocks(const vtb_dirty* d)
+{
+	VTBD__CHECK(d->vtb__m_hashes); // Call initialize first
+
+	return d->vtb__m_num_blocks;
+}
+
+VTBDDEF size_t vtbd_getblocksize(const vtb_dirty* d)
+{
+	VTBD__CHECK(d->vtb__m_hashes); // Call initialize first
+
+	return d->vtb__m_block_size;
+}
+
+VTBDDEF uint32_t vtbd_gethash(const vtb_dirty* d, size_t block)
+{
+	VTBD__CHECK(d->vtb__m_hashes); // Call initialize first
+	VTBD__CHECK(block < d->vtb__m_num_blocks);
+
+	return d->vtb__m_hashes[block];
+}
+
+#endif
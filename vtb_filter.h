@@ -0,0 +1,616 @@
+/*
+vtb_filter.h - public domain approximate membership filters
+
+This software is dual-licensed to the public domain and under the
+following license: you are granted a perpetual, irrevocable license
+to copy, modify, publish, and distribute this file as you see fit.
+
+These are filters for asking "have I seen this key?" before doing
+something expensive like going to disk or the network. They never say no
+when the answer is yes, and only rarely say yes when the answer is no.
+There are two:
+
+vtb_bloom is a blocked Bloom filter. Each key sets 8 bits, all in one 64
+byte block, so a lookup touches one cache line. With AVX2 the 8 bits are
+computed and tested with a handful of vector instructions. Keys can't be
+removed.
+
+vtb_cuckoo is a cuckoo filter. It stores a 16-bit fingerprint of each key
+in one of two 4 slot buckets, and keys can be removed. It holds up to about
+95% of its slots. It has a lower false positive rate than a Bloom filter
+of the same size, but inserts get slower as it fills.
+
+Keys are hashed to 64 bits with vtb_chash from vtb_hash.h, so you also need
+to #define VTB_HASH_IMPLEMENTATION in one file. If you have a good 64-bit
+hash already, the *hash versions of the functions take it directly.
+
+
+COMPILING AND LINKING
+	You must
+
+	#define VTB_FILTER_IMPLEMENTATION
+
+	in exactly one C++ file that includes this header, before the include
+	like this:
+
+	#define VTB_FILTER_IMPLEMENTATION
+	#include "vtb_filter.h"
+
+	All other files can be just #include "vtb_filter.h" without the #define
+
+
+QUICK START
+	vtb_bloom b;
+	vtbf_bloom_initializememory(&b, 1000000, 10); // A million keys, 10 bits each
+
+	vtbf_bloom_add(&b, "key", 3);
+
+	if (vtbf_bloom_contains(&b, key, key_length))
+		look_in_storage(key, key_length); // Probably there
+	// else it's definitely not there
+
+	vtbf_bloom_destroy(&b);
+
+	vtb_cuckoo c;
+	vtbf_cuckoo_initializememory(&c, 1000000);
+
+	vtbf_cuckoo_add(&c, "key", 3);
+	vtbf_cuckoo_remove(&c, "key", 3);
+
+	vtbf_cuckoo_destroy(&c);
+
+
+FALSE POSITIVES
+	Bloom filter, by bits per key:  8: 3.1%  10: 1.2%  12: 0.5%  16: 0.16%
+	Cuckoo filter: about 0.01% when full, less when emptier.
+
+	Only add a key to a cuckoo filter once. Adding it twice stores it twice
+	and it has to be removed twice.
+
+
+MEMORY MANAGEMENT
+	vtbf_bloom_initialize() and vtbf_cuckoo_initialize() use memory that you
+	provide and don't allocate. The Bloom filter uses as many whole 64 byte
+	blocks as fit after aligning the memory to 64 bytes. The cuckoo filter
+	uses the largest power of two number of 8 byte buckets that fits.
+
+	#define VTBF_NO_MALLOC
+
+	to avoid #include stdlib.h, in which case only the initializers that
+	take memory work.
+
+
+ASSERT
+	Define VTBF_ASSERT(boolval) to override assert() and not use assert.h
+*/
+
+#ifndef VTB__FILTER_H
+#define VTB__FILTER_H
+
+#ifdef VTBF_STATIC
+#define VTBFDEF static
+#else
+#ifdef __cplusplus
+#define VTBFDEF extern "C"
+#else
+#define VTBFDEF extern
+#endif
+#endif
+
+#include <stdint.h> // For uint64_t
+#include <stddef.h> // For size_t
+
+#include "vtb_hash.h"
+
+#ifndef VTB__PRIVATE_MEMBER
+#define VTB__PRIVATE_MEMBER(type, name) type vtb__##name
+#endif
+
+// WARNING: Don't directly reference members of these structs. I reserve
+// the right to change them from version to version.
+typedef struct
+{
+	VTB__PRIVATE_MEMBER(void*, m_memory);      // What to free, if we allocated it.
+	VTB__PRIVATE_MEMBER(uint64_t*, m_blocks);  // 8 words per block, 64 byte aligned.
+	VTB__PRIVATE_MEMBER(size_t, m_num_blocks);
+	VTB__PRIVATE_MEMBER(uint8_t, m_flags);     // Currently only contains the free flag.
+} vtb_bloom;
+
+typedef struct
+{
+	VTB__PRIVATE_MEMBER(void*, m_memory);
+	VTB__PRIVATE_MEMBER(uint64_t*, m_buckets); // 4 16-bit fingerprints per bucket, 0 is empty.
+	VTB__PRIVATE_MEMBER(size_t, m_bucket_mask);
+	VTB__PRIVATE_MEMBER(size_t, m_count);
+	VTB__PRIVATE_MEMBER(size_t, m_victim_index); // A fingerprint that didn't fit after too many kicks.
+	VTB__PRIVATE_MEMBER(uint16_t, m_victim);
+	VTB__PRIVATE_MEMBER(uint32_t, m_random);
+	VTB__PRIVATE_MEMBER(uint8_t, m_flags);
+} vtb_cuckoo;
+
+// The 64-bit hash that the key versions of the functions below use.
+VTBFDEF uint64_t vtbf_hash(const void* key, size_t key_size);
+
+// Use this initializer if you want the filter to use the memory that you
+// provide. memory_size must fit at least one 64 byte block after aligning.
+VTBFDEF void vtbf_bloom_initialize(vtb_bloom* b, void* memory, size_t memory_size);
+
+// This initializer will allocate memory for you, for convenience.
+// It will be freed when you call vtbf_bloom_destroy().
+VTBFDEF void vtbf_bloom_initializememory(vtb_bloom* b, size_t num_keys, int bits_per_key);
+
+VTBFDEF void vtbf_bloom_destroy(vtb_bloom* b);
+
+// Forget every key.
+VTBFDEF void vtbf_bloom_clear(vtb_bloom* b);
+
+VTBFDEF void vtbf_bloom_add(vtb_bloom* b, const void* key, size_t key_size);
+VTBFDEF void vtbf_bloom_addhash(vtb_bloom* b, uint64_t hash);
+
+// Returns 0 if the key was never added, 1 if it probably was.
+VTBFDEF int vtbf_bloom_contains(const vtb_bloom* b, const void* key, size_t key_size);
+VTBFDEF int vtbf_bloom_containshash(const vtb_bloom* b, uint64_t hash);
+
+// Returns the number of bytes used, not counting alignment.
+VTBFDEF size_t vtbf_bloom_getmemorysize(const vtb_bloom* b);
+
+// Use this initializer if you want the filter to use the memory that you
+// provide. memory_size must fit at least two 8 byte buckets.
+VTBFDEF void vtbf_cuckoo_initialize(vtb_cuckoo* c, void* memory, size_t memory_size);
+
+// This initializer will allocate memory for you, enough for num_keys at
+// 95% full. It will be freed when you call vtbf_cuckoo_destroy().
+VTBFDEF void vtbf_cuckoo_initializememory(vtb_cuckoo* c, size_t num_keys);
+
+VTBFDEF void vtbf_cuckoo_destroy(vtb_cuckoo* c);
+
+VTBFDEF void vtbf_cuckoo_clear(vtb_cuckoo* c);
+
+// Returns 1 if the key was added, 0 if the filter is too full. When it
+// fails nothing is changed.
+VTBFDEF int vtbf_cuckoo_add(vtb_cuckoo* c, const void* key, size_t key_size);
+VTBFDEF int vtbf_cuckoo_addhash(vtb_cuckoo* c, uint64_t hash);
+
+// Returns 0 if the key isn't in the filter, 1 if it probably is.
+VTBFDEF int vtbf_cuckoo_contains(const vtb_cuckoo* c, const void* key, size_t key_size);
+VTBFDEF int vtbf_cuckoo_containshash(const vtb_cuckoo* c, uint64_t hash);
+
+// Returns 1 if the key was found and removed, 0 otherwise. Only remove keys
+// that were added, or you may remove a different key with the same
+// fingerprint.
+VTBFDEF int vtbf_cuckoo_remove(vtb_cuckoo* c, const void* key, size_t key_size);
+VTBFDEF int vtbf_cuckoo_removehash(vtb_cuckoo* c, uint64_t hash);
+
+// Returns the number of keys in the filter.
+VTBFDEF size_t vtbf_cuckoo_getcount(const vtb_cuckoo* c);
+
+// Returns the number of keys the filter has slots for.
+VTBFDEF size_t vtbf_cuckoo_getcapacity(const vtb_cuckoo* c);
+
+#endif // VTB__FILTER_H
+
+
+
+#ifdef VTB_FILTER_IMPLEMENTATION
+
+#ifndef VTBF_ASSERT
+#include <assert.h>
+#define VTBF_ASSERT(x) assert(x)
+#endif
+
+#ifdef VTBF_DEBUG
+#define VTBF__ASSERT VTBF_ASSERT
+#define VTBF__CHECK VTBF_ASSERT
+#else
+#define VTBF__ASSERT(x)
+#define VTBF__CHECK VTBF_ASSERT
+#endif
+
+#ifndef VTBF_NO_MALLOC
+#include <stdlib.h>
+#endif
+
+#include <string.h> // For memset
+
+#if defined(__AVX2__) && !defined(VTBF_NO_SIMD)
+#include <immintrin.h>
+#define VTBF__AVX2
+#endif
+
+// Cuckoo inserts give up after this many evictions.
+#ifndef VTBF_CUCKOO_MAX_KICKS
+#define VTBF_CUCKOO_MAX_KICKS 500
+#endif
+
+VTBFDEF uint64_t vtbf_hash(const void* key, size_t key_size)
+{
+	vtb_chash h = vtbh_chash_new();
+	vtbh_chash_bytes(&h, (const unsigned char*)key, key_size);
+	return vtbh_chash_digest(h);
+}
+
+// Maps a 32-bit hash onto [0, range) without a divide.
+static size_t vtbf__range(uint32_t hash, size_t range)
+{
+	return (size_t)(((uint64_t)hash * range) >> 32);
+}
+
+// Double hashing: bit j of the 8 comes from h1 + j*h2, one bit in each of
+// the block's 8 words. The top 32 bits of the hash pick the block, so h2 is
+// remixed from them to not depend only on which block it is.
+#define VTBF__BLOOM_PROBES(hash, h1, h2) \
+	uint32_t h1 = (uint32_t)(hash); \
+	uint32_t h2 = ((uint32_t)((hash) >> 32) * 0x9E3779B1u) | 1;
+
+VTBFDEF void vtbf_bloom_initialize(vtb_bloom* b, void* memory, size_t memory_size)
+{
+	VTBF__CHECK(memory);
+
+	size_t misalignment = (size_t)((uintptr_t)memory & 63);
+	size_t skip = misalignment ? 64 - misalignment : 0;
+
+	VTBF__CHECK(memory_size >= skip + 64);
+
+	b->vtb__m_memory = memory;
+	b->vtb__m_blocks = (uint64_t*)((uint8_t*)memory + skip);
+	b->vtb__m_num_blocks = (memory_size - skip) / 64;
+	b->vtb__m_flags = 0;
+
+	vtbf_bloom_clear(b);
+}
+
+VTBFDEF void vtbf_bloom_initializememory(vtb_bloom* b, size_t num_keys, int bits_per_key)
+{
+#ifndef VTBF_NO_MALLOC
+	VTBF__CHECK(bits_per_key > 0);
+
+	size_t num_blocks = (num_keys * bits_per_key + 511) / 512;
+	if (!num_blocks)
+		num_blocks = 1;
+
+	// Extra room to align to a cache line.
+	size_t memory_size = num_blocks * 64 + 63;
+	vtbf_bloom_initialize(b, malloc(memory_size), memory_size);
+
+	b->vtb__m_flags = 1;
+#else
+	b = b;
+	num_keys = num_keys;
+	bits_per_key = bits_per_key;
+	VTBF__CHECK(0);
+#endif
+}
+
+VTBFDEF void vtbf_bloom_destroy(vtb_bloom* b)
+{
+#ifndef VTBF_NO_MALLOC
+	if (b->vtb__m_flags)
+	{
+		VTBF__CHECK(b->vtb__m_memory); // Double free
+		free(b->vtb__m_memory);
+	}
+#endif
+
+	b->vtb__m_memory = 0;
+	b->vtb__m_blocks = 0;
+}
+
+VTBFDEF void vtbf_bloom_clear(vtb_bloom* b)
+{
+	VTBF__CHECK(b->vtb__m_blocks); // Call initialize first
+
+	memset(b->vtb__m_blocks, 0, b->vtb__m_num_blocks * 64);
+}
+
+VTBFDEF void vtbf_bloom_add(vtb_bloom* b, const void* key, size_t key_size)
+{
+	vtbf_bloom_addhash(b, vtbf_hash(key, key_size));
+}
+
+VTBFDEF void vtbf_bloom_addhash(vtb_bloom* b, uint64_t hash)
+{
+	VTBF__ASSERT(b->vtb__m_blocks);
+
+	uint64_t* block = b->vtb__m_blocks + vtbf__range((uint32_t)(hash >> 32), b->vtb__m_num_blocks) * 8;
+
+	VTBF__BLOOM_PROBES(hash, h1, h2);
+
+#ifdef VTBF__AVX2
+	__m256i bits = _mm256_srli_epi32(_mm256_add_epi32(_mm256_set1_epi32((int)h1), _mm256_mullo_epi32(_mm256_set1_epi32((int)h2), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7))), 26);
+	__m256i mask0 = _mm256_sllv_epi64(_mm256_set1_epi64x(1), _mm256_cvtepu32_epi64(_mm256_castsi256_si128(bits)));
+	__m256i mask1 = _mm256_sllv_epi64(_mm256_set1_epi64x(1), _mm256_cvtepu32_epi64(_mm256_extracti128_si256(bits, 1)));
+
+	_mm256_store_si256((__m256i*)block, _mm256_or_si256(_mm256_load_si256((const __m256i*)block), mask0));
+	_mm256_store_si256((__m256i*)(block + 4), _mm256_or_si256(_mm256_load_si256((const __m256i*)(block + 4)), mask1));
+#else
+	for (uint32_t j = 0; j < 8; j++)
+		block[j] |= (uint64_t)1 << ((h1 + j*h2) >> 26);
+#endif
+}
+
+VTBFDEF int vtbf_bloom_contains(const vtb_bloom* b, const void* key, size_t key_size)
+{
+	return vtbf_bloom_containshash(b, vtbf_hash(key, key_size));
+}
+
+VTBFDEF int vtbf_bloom_containshash(const vtb_bloom* b, uint64_t hash)
+{
+	VTBF__ASSERT(b->vtb__m_blocks);
+
+	const uint64_t* block = b->vtb__m_blocks + vtbf__range((uint32_t)(hash >> 32), b->vtb__m_num_blocks) * 8;
+
+	VTBF__BLOOM_PROBES(hash, h1, h2);
+
+#ifdef VTBF__AVX2
+	__m256i bits = _mm256_srli_epi32(_mm256_add_epi32(_mm256_set1_epi32((int)h1), _mm256_mullo_epi32(_mm256_set1_epi32((int)h2), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7))), 26);
+	__m256i mask0 = _mm256_sllv_epi64(_mm256_set1_epi64x(1), _mm256_cvtepu32_epi64(_mm256_castsi256_si128(bits)));
+	__m256i mask1 = _mm256_sllv_epi64(_mm256_set1_epi64x(1), _mm256_cvtepu32_epi64(_mm256_extracti128_si256(bits, 1)));
+
+	// testc is 1 when every bit in the mask is set in the block.
+	return _mm256_testc_si256(_mm256_load_si256((const __m256i*)block), mask0) &
+		_mm256_testc_si256(_mm256_load_si256((const __m256i*)(block + 4)), mask1);
+#else
+	uint64_t missing = 0;
+
+	// No early out, the block is in cache after the first load anyway.
+	for (uint32_t j = 0; j < 8; j++)
+		missing |= ~block[j] & ((uint64_t)1 << ((h1 + j*h2) >> 26));
+
+	return !missing;
+#endif
+}
+
+VTBFDEF size_t vtbf_bloom_getmemorysize(const vtb_bloom* b)
+{
+	return b->vtb__m_num_blocks * 64;
+}
+
+#define VTBF__CUCKOO_LANES 0x0001000100010001ull
+
+static uint16_t vtbf__cuckoo_fingerprint(uint64_t hash)
+{
+	uint16_t fingerprint = (uint16_t)hash;
+	return fingerprint ? fingerprint : 1; // 0 marks an empty slot.
+}
+
+// Partial-key cuckoo hashing: the other bucket only depends on this bucket
+// and the fingerprint, so it can be found without the original key, and
+// alternate(alternate(i)) == i.
+static size_t vtbf__cuckoo_alternate(const vtb_cuckoo* c, size_t index, uint16_t fingerprint)
+{
+	return (index ^ ((size_t)fingerprint * 0x5BD1E995u)) & c->vtb__m_bucket_mask;
+}
+
+// Checks all 4 slots at once: xor makes matching slots 0, and the classic
+// has-a-zero-byte trick, with 16-bit lanes, finds them.
+static int vtbf__cuckoo_bucket_has(uint64_t bucket, uint16_t fingerprint)
+{
+	uint64_t x = bucket ^ (fingerprint * VTBF__CUCKOO_LANES);
+	return ((x - VTBF__CUCKOO_LANES) & ~x & (VTBF__CUCKOO_LANES << 15)) != 0;
+}
+
+static int vtbf__cuckoo_bucket_put(vtb_cuckoo* c, size_t index, uint16_t fingerprint)
+{
+	uint64_t bucket = c->vtb__m_buckets[index];
+
+	for (int slot = 0; slot < 4; slot++)
+	{
+		if (!((bucket >> (slot*16)) & 0xFFFF))
+		{
+			c->vtb__m_buckets[index] = bucket | ((uint64_t)fingerprint << (slot*16));
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+static int vtbf__cuckoo_bucket_remove(vtb_cuckoo* c, size_t index, uint16_t fingerprint)
+{
+	uint64_t bucket = c->vtb__m_buckets[index];
+
+	for (int slot = 0; slot < 4; slot++)
+	{
+		if (((bucket >> (slot*16)) & 0xFFFF) == fingerprint)
+		{
+			c->vtb__m_buckets[index] = bucket & ~((uint64_t)0xFFFF << (slot*16));
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+VTBFDEF void vtbf_cuckoo_initialize(vtb_cuckoo* c, void* memory, size_t memory_size)
+{
+	VTBF__CHECK(memory);
+	VTBF__CHECK(((size_t)memory) % sizeof(uint64_t) == 0); // Can't handle unaligned memory.
+	VTBF__CHECK(memory_size >= 2*sizeof(uint64_t));
+
+	size_t num_buckets = 2;
+	while (num_buckets*2 <= memory_size / sizeof(uint64_t))
+		num_buckets *= 2;
+
+	c->vtb__m_memory = memory;
+	c->vtb__m_buckets = (uint64_t*)memory;
+	c->vtb__m_bucket_mask = num_buckets - 1;
+	c->vtb__m_flags = 0;
+
+	vtbf_cuckoo_clear(c);
+}
+
+VTBFDEF void vtbf_cuckoo_initializememory(vtb_cuckoo* c, size_t num_keys)
+{
+#ifndef VTBF_NO_MALLOC
+	size_t num_buckets = 2;
+	while (num_buckets*4*95/100 < num_keys)
+		num_buckets *= 2;
+
+	vtbf_cuckoo_initialize(c, malloc(num_buckets * sizeof(uint64_t)), num_buckets * sizeof(uint64_t));
+
+	c->vtb__m_flags = 1;
+#else
+	c = c;
+	num_keys = num_keys;
+	VTBF__CHECK(0);
+#endif
+}
+
+VTBFDEF void vtbf_cuckoo_destroy(vtb_cuckoo* c)
+{
+#ifndef VTBF_NO_MALLOC
+	if (c->vtb__m_flags)
+	{
+		VTBF__CHECK(c->vtb__m_memory); // Double free
+		free(c->vtb__m_memory);
+	}
+#endif
+
+	c->vtb__m_memory = 0;
+	c->vtb__m_buckets = 0;
+}
+
+VTBFDEF void vtbf_cuckoo_clear(vtb_cuckoo* c)
+{
+	VTBF__CHECK(c->vtb__m_buckets); // Call initialize first
+
+	memset(c->vtb__m_buckets, 0, (c->vtb__m_bucket_mask + 1) * sizeof(uint64_t));
+
+	c->vtb__m_count = 0;
+	c->vtb__m_victim = 0;
+	c->vtb__m_victim_index = 0;
+	c->vtb__m_random = 0x2545F491;
+}
+
+// Puts the fingerprint in its bucket at index or the alternate. If they're
+// both full, evicts a random fingerprint into its other bucket, and so on
+// until something lands in an empty slot. If that takes too long the last
+// evicted fingerprint becomes the victim.
+static void vtbf__cuckoo_insert(vtb_cuckoo* c, size_t index, uint16_t fingerprint)
+{
+	if (vtbf__cuckoo_bucket_put(c, index, fingerprint))
+		return;
+
+	index = vtbf__cuckoo_alternate(c, index, fingerprint);
+
+	if (vtbf__cuckoo_bucket_put(c, index, fingerprint))
+		return;
+
+	uint32_t random = c->vtb__m_random;
+
+	for (int kick = 0; kick < VTBF_CUCKOO_MAX_KICKS; kick++)
+	{
+		random ^= random << 13;
+		random ^= random >> 17;
+		random ^= random << 5;
+
+		int slot = random & 3;
+		uint64_t bucket = c->vtb__m_buckets[index];
+		uint16_t evicted = (uint16_t)(bucket >> (slot*16));
+
+		c->vtb__m_buckets[index] = (bucket & ~((uint64_t)0xFFFF << (slot*16))) | ((uint64_t)fingerprint << (slot*16));
+
+		fingerprint = evicted;
+		index = vtbf__cuckoo_alternate(c, index, fingerprint);
+
+		if (vtbf__cuckoo_bucket_put(c, index, fingerprint))
+		{
+			c->vtb__m_random = random;
+			return;
+		}
+	}
+
+	c->vtb__m_random = random;
+
+	// Keep it on the side so it's still found, and refuse new keys until a
+	// remove makes room.
+	c->vtb__m_victim = fingerprint;
+	c->vtb__m_victim_index = index;
+}
+
+VTBFDEF int vtbf_cuckoo_add(vtb_cuckoo* c, const void* key, size_t key_size)
+{
+	return vtbf_cuckoo_addhash(c, vtbf_hash(key, key_size));
+}
+
+VTBFDEF int vtbf_cuckoo_addhash(vtb_cuckoo* c, uint64_t hash)
+{
+	VTBF__ASSERT(c->vtb__m_buckets);
+
+	// A victim means an earlier insert already couldn't find room. Rather
+	// than kick things around and lose a key, say we're full.
+	if (c->vtb__m_victim)
+		return 0;
+
+	vtbf__cuckoo_insert(c, (size_t)(hash >> 32) & c->vtb__m_bucket_mask, vtbf__cuckoo_fingerprint(hash));
+	c->vtb__m_count++;
+
+	return 1;
+}
+
+VTBFDEF int vtbf_cuckoo_contains(const vtb_cuckoo* c, const void* key, size_t key_size)
+{
+	return vtbf_cuckoo_containshash(c, vtbf_hash(key, key_size));
+}
+
+VTBFDEF int vtbf_cuckoo_containshash(const vtb_cuckoo* c, uint64_t hash)
+{
+	VTBF__ASSERT(c->vtb__m_buckets);
+
+	uint16_t fingerprint = vtbf__cuckoo_fingerprint(hash);
+	size_t index1 = (size_t)(hash >> 32) & c->vtb__m_bucket_mask;
+	size_t index2 = vtbf__cuckoo_alternate(c, index1, fingerprint);
+
+	if (vtbf__cuckoo_bucket_has(c->vtb__m_buckets[index1], fingerprint) | vtbf__cuckoo_bucket_has(c->vtb__m_buckets[index2], fingerprint))
+		return 1;
+
+	return c->vtb__m_victim == fingerprint && (c->vtb__m_victim_index == index1 || c->vtb__m_victim_index == index2);
+}
+
+VTBFDEF int vtbf_cuckoo_remove(vtb_cuckoo* c, const void* key, size_t key_size)
+{
+	return vtbf_cuckoo_removehash(c, vtbf_hash(key, key_size));
+}
+
+VTBFDEF int vtbf_cuckoo_removehash(vtb_cuckoo* c, uint64_t hash)
+{
+	VTBF__ASSERT(c->vtb__m_buckets);
+
+	uint16_t fingerprint = vtbf__cuckoo_fingerprint(hash);
+	size_t index1 = (size_t)(hash >> 32) & c->vtb__m_bucket_mask;
+	size_t index2 = vtbf__cuckoo_alternate(c, index1, fingerprint);
+
+	if (c->vtb__m_victim == fingerprint && (c->vtb__m_victim_index == index1 || c->vtb__m_victim_index == index2))
+	{
+		c->vtb__m_victim = 0;
+		c->vtb__m_count--;
+		return 1;
+	}
+
+	if (!vtbf__cuckoo_bucket_remove(c, index1, fingerprint) && !vtbf__cuckoo_bucket_remove(c, index2, fingerprint))
+		return 0;
+
+	c->vtb__m_count--;
+
+	// There's room now, try to find the victim a home.
+	if (c->vtb__m_victim)
+	{
+		uint16_t victim = c->vtb__m_victim;
+		c->vtb__m_victim = 0;
+		vtbf__cuckoo_insert(c, c->vtb__m_victim_index, victim);
+	}
+
+	return 1;
+}
+
+VTBFDEF size_t vtbf_cuckoo_getcount(const vtb_cuckoo* c)
+{
+	return c->vtb__m_count;
+}
+
+VTBFDEF size_t vtbf_cuckoo_getcapacity(const vtb_cuckoo* c)
+{
+	return (c->vtb__m_bucket_mask + 1) * 4;
+}
+
+#endif
@@ -10,7 +10,9 @@ used for anything that requires error correcting or security. It
 works great for hash tables and error detecting. It is reasonably
 uniform over [0, 2^32-1], deterministic on its inputs, and small
 changes of the input will produce drastic changes of the output.
-Results are dependent on endianness. On my 2.2 Ghz processor I
+Hashes of bytes are the same on every platform, but vtbh_ints and
+vtbh_floats hash the bytes in memory, so they depend on endianness
+unless VTBH_PORTABLE is defined (see below). On my 2.2 Ghz processor I
 can hash 4,525,199,690 bytes in 14.1 seconds, or about one hash
 per every 7 cycles.
 
@@ -50,9 +52,52 @@ QUICK START
 
 	printf("%x\n", h.hash);
 
+	// For hash tables keyed by untrusted input, use a keyed hash with a
+	// random seed instead, so which keys collide can't be worked out ahead
+	// of time:
+	vtb_hash h = vtbh_new_seeded(vtbh_process_seed());
+
 
 ASSERT
 	Define VTBH_ASSERT(boolval) to override assert() and not use assert.h
+
+
+PORTABLE
+	Define VTBH_PORTABLE to hash ints and floats as little endian bytes on
+	every platform, so big endian and little endian machines get the same
+	hashes. This changes nothing on little endian machines.
+
+
+C++
+	vtb::hash<T> hashes whole values, so it can go straight into the
+	standard containers:
+
+		std::unordered_map<Key, Value, vtb::hash<Key>> map;
+
+	Types whose bytes are their value (ints, enums, pointers, and structs
+	of those with no padding) are hashed with one vtbh_bytes call. For
+	your own structs like that, say so and they get the same treatment:
+
+		namespace vtb
+		{
+			template <> struct is_uniquely_represented<Point> : std::true_type {};
+		}
+
+	With C++17 std::has_unique_object_representations figures it out for
+	you. Anything else gets a hash_append overload next to it that hashes
+	its fields, found by argument dependent lookup:
+
+		void hash_append(vtb_hash& h, const Person& p)
+		{
+			vtb::hash_append(h, p.name, p.age);
+		}
+
+	Strings, vectors, pairs, tuples, arrays, floats and doubles are
+	handled already. Pointers hash their address, like std::hash does.
+	vtb::seeded_hash<T> is the same but seeded, see vtbh_new_seeded.
+	VTBH_STD_HASH(Type) makes std::hash<Type> use vtb::hash<Type>. These
+	hash the bytes in memory, so they depend on endianness even with
+	VTBH_PORTABLE.
 */
 
 #ifndef VTB__HASH_H
@@ -69,16 +114,38 @@ ASSERT
 #endif
 
 #include <stdint.h> // For uint8_t/int32_t
+#include <stddef.h> // For size_t
 
 typedef struct
 {
 	uint32_t hash;
 	uint32_t salt;
+
+	// Only for hashes from vtbh_new_seeded, which use a keyed function
+	// instead of the one above, and count bytes in salt. key[0] is 0
+	// otherwise.
+	uint64_t key[2];
+	uint64_t state;
+	uint64_t pending; // Bytes that don't make a whole block yet.
 } vtb_hash;
 
 // This just returns an initialized vtb_hash, and always the same one.
 VTBHDEF vtb_hash vtbh_new();
 
+// Returns a vtb_hash keyed with seed. Everything hashed into it goes through
+// a keyed function in the style of wyhash instead of the usual steps, with
+// the key in every 8 byte block, so which keys collide depends on the seed.
+// For hash tables that take keys from outside, seed them with
+// vtbh_process_seed() so nobody can work out ahead of time which keys land
+// in the same bucket. It isn't a cryptographic MAC, so don't use it where
+// the hash itself is secret or signed. Making the key takes a few
+// multiplies, so for lots of small keys make it once and copy it.
+VTBHDEF vtb_hash vtbh_new_seeded(uint64_t seed);
+
+// A random seed, made once per process from the operating system's random
+// number generator and the same on every call after that. Never 0.
+VTBHDEF uint64_t vtbh_process_seed();
+
 VTBHDEF void vtbh_bytes(vtb_hash* h, const unsigned char* bytes, size_t num_bytes);
 VTBHDEF void vtbh_byte(vtb_hash* h, unsigned char byte);
 
@@ -90,13 +157,319 @@ VTBHDEF void vtbh_float(vtb_hash* h, float f);
 
 VTBHDEF void vtbh_string(vtb_hash* h, const char* s, size_t length);
 
+// Hash arrays of floats or doubles by value rather than by bytes: -0.0 and
+// +0.0 hash the same, and so do NaNs with different payloads. These use a
+// different, vectorized algorithm than vtbh_bytes (16 independent lanes of
+// multiply-rotate, folded into h at the end), so they're many times faster
+// on big arrays but don't give the same result as vtbh_floats. Results are
+// the same on every platform, with or without SIMD, and don't depend on
+// endianness. Define VTBH_NO_SIMD to use the plain C version.
+VTBHDEF void vtbh_floats_canonical(vtb_hash* h, const float* floats, size_t num_floats);
+VTBHDEF void vtbh_doubles_canonical(vtb_hash* h, const double* doubles, size_t num_doubles);
+
+// Content-defined chunking. A vtb_chunker runs a Gear rolling hash over a
+// stream one byte at a time, in O(1) per byte, and ends a chunk wherever the
+// last 64 bytes hash to a boundary. Since boundaries only depend on nearby
+// content, an edit to a big file only changes the chunks around the edit,
+// and hashing each chunk with vtbh_bytes gives delta detection and dedup.
+//
+// Chunks are never shorter than min_size (except the last one in a stream)
+// and never longer than max_size. Sizes cluster around avg_size, which is
+// rounded down to a power of two.
+typedef struct
+{
+	uint64_t hash;
+	uint64_t mask_small; // Used before the chunk reaches avg_size, harder to hit
+	uint64_t mask_large; // Used after, easier to hit
+	size_t   length;     // Bytes in the current chunk so far
+	size_t   skip_size;  // Bytes that can't be part of a boundary window
+	size_t   min_size;
+	size_t   avg_size;
+	size_t   max_size;
+} vtb_chunker;
+
+VTBHDEF vtb_chunker vtbh_chunker_new(size_t min_size, size_t avg_size, size_t max_size);
+
+// Feed one byte. Returns 1 if the current chunk ends with this byte.
+VTBHDEF int vtbh_chunker_byte(vtb_chunker* c, unsigned char byte);
+
+// Feed bytes until a chunk ends. Returns the offset just past the end of the
+// chunk, or 0 if no chunk ended in these bytes, in which case all of them
+// were consumed and the chunk carries over into the next call. Gives the
+// same boundaries as feeding the same bytes to vtbh_chunker_byte.
+//
+//     size_t offset = 0;
+//     while (size_t end = vtbh_chunker_next(&c, data + offset, size - offset))
+//     {
+//         ... data + offset to data + offset + end is a chunk ...
+//         offset += end;
+//     }
+//     ... data + offset to data + size starts the next chunk ...
+VTBHDEF size_t vtbh_chunker_next(vtb_chunker* c, const unsigned char* bytes, size_t num_bytes);
+
+// A combinable hash. vtb_hash mixes each byte with the state left by all the
+// bytes before it, so the hashes of two pieces can't be put together. A
+// vtb_chash is a polynomial over the bytes modulo 2^61-1 and carries its
+// length, so hash(A||B) = vtbh_combine(hash(A), hash(B)). Pieces can be
+// hashed on different threads, or as they arrive out of order, and combined
+// at the end. vtbh_combine is O(log length of b). This is a different
+// algorithm than vtb_hash and gives different results.
+//
+//     vtb_chash a = vtbh_chash_new();
+//     vtbh_chash_bytes(&a, first_half, first_half_size);
+//     vtb_chash b = vtbh_chash_new();
+//     vtbh_chash_bytes(&b, second_half, second_half_size);
+//     uint64_t digest = vtbh_chash_digest(vtbh_combine(a, b));
+typedef struct
+{
+	uint64_t value;  // Always less than 2^61-1
+	uint64_t length; // In bytes
+} vtb_chash;
+
+VTBHDEF vtb_chash vtbh_chash_new();
+VTBHDEF void vtbh_chash_bytes(vtb_chash* c, const unsigned char* bytes, size_t num_bytes);
+VTBHDEF vtb_chash vtbh_combine(vtb_chash a, vtb_chash b);
+
+// The value is a plain polynomial, this mixes it with the length into a
+// well distributed 64-bit hash.
+VTBHDEF uint64_t vtbh_chash_digest(vtb_chash c);
+
+// CRC-32C (Castagnoli), for checking big buffers for changes or corruption.
+// Uses the SSE4.2 crc32 instruction when the CPU has it, checked at run
+// time, or the ARMv8 CRC instructions when compiled for them, with three
+// interleaved streams to keep the instruction busy. Otherwise, or with
+// VTBH_NO_SIMD, a slice-by-8 table. The results are the standard CRC-32C
+// (as in iSCSI, ext4, etc), which vtb_hash isn't, so they can be checked
+// against other implementations. Define VTBH_CRC32C_NO_CLMUL to combine
+// the streams without the carry-less multiply even when the CPU has it,
+// which is only useful for testing.
+//
+//     vtb_crc32c c = vtbh_crc32c_new();
+//     vtbh_crc32c(&c, bytes, num_bytes);
+//     vtbh_crc32c(&c, more_bytes, num_more_bytes);
+//     printf("%08x\n", c.crc);
+typedef struct
+{
+	uint32_t crc; // The CRC of all the bytes so far, ready to use
+} vtb_crc32c;
+
+VTBHDEF vtb_crc32c vtbh_crc32c_new();
+VTBHDEF void vtbh_crc32c(vtb_crc32c* c, const unsigned char* bytes, size_t num_bytes);
+
+// Returns the CRC of A||B given the CRCs of A and B and the length of B.
+VTBHDEF uint32_t vtbh_crc32c_combine(uint32_t crc_a, uint32_t crc_b, size_t length_b);
+
+
+#ifdef __cplusplus
+
+#include <functional>  // For std::hash
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>     // For std::pair
+#include <vector>
+
+namespace vtb
+{
+
+// True when equal Ts always have equal bytes, so a T can be hashed as a
+// block of memory. Specialize it to true_type for your own types where
+// that holds.
+template <typename T>
+struct is_uniquely_represented : std::integral_constant<bool,
+	std::is_integral<T>::value || std::is_enum<T>::value || std::is_pointer<T>::value
+#if defined(__cpp_lib_has_unique_object_representations)
+	|| std::has_unique_object_representations<T>::value
+#endif
+	>
+{
+};
+
+template <typename T, size_t N>
+struct is_uniquely_represented<T[N]> : is_uniquely_represented<T>
+{
+};
+
+template <typename A, typename B>
+struct is_uniquely_represented<std::pair<A, B>> : std::integral_constant<bool,
+	is_uniquely_represented<A>::value && is_uniquely_represented<B>::value && sizeof(std::pair<A, B>) == sizeof(A) + sizeof(B)>
+{
+};
+
+// Adds value to h. These are all declared before any are defined so they
+// can find each other, say for a vector of pairs.
+template <typename T>
+typename std::enable_if<is_uniquely_represented<T>::value>::type hash_append(vtb_hash& h, const T& value);
+
+inline void hash_append(vtb_hash& h, float f);
+inline void hash_append(vtb_hash& h, double d);
+
+template <typename T, size_t N>
+typename std::enable_if<!is_uniquely_represented<T>::value>::type hash_append(vtb_hash& h, const T (&values)[N]);
+
+template <typename A, typename B>
+typename std::enable_if<!is_uniquely_represented<std::pair<A, B>>::value>::type hash_append(vtb_hash& h, const std::pair<A, B>& pair);
+
+template <typename... Types>
+void hash_append(vtb_hash& h, const std::tuple<Types...>& tuple);
+
+template <typename Char, typename Traits, typename Allocator>
+void hash_append(vtb_hash& h, const std::basic_string<Char, Traits, Allocator>& s);
+
+template <typename T, typename Allocator>
+void hash_append(vtb_hash& h, const std::vector<T, Allocator>& v);
+
+// Several values in a row, for hashing the fields of a struct.
+template <typename First, typename Second, typename... Rest>
+void hash_append(vtb_hash& h, const First& first, const Second& second, const Rest&... rest);
+
+// Hashes values with a fresh vtb_hash.
+template <typename... Types>
+uint32_t hash_values(const Types&... values)
+{
+	vtb_hash h = vtbh_new();
+	hash_append(h, values...);
+	return h.hash;
+}
+
+// For std::unordered_map and friends.
+template <typename T>
+struct hash
+{
+	size_t operator()(const T& value) const
+	{
+		return hash_values(value);
+	}
+};
+
+// vtb::hash started from vtbh_new_seeded, for tables that take keys from
+// outside. By default the seed is vtbh_process_seed().
+template <typename T>
+struct seeded_hash
+{
+	vtb_hash start;
+
+	seeded_hash()
+		: start(vtbh_new_seeded(vtbh_process_seed()))
+	{
+	}
+
+	explicit seeded_hash(uint64_t seed)
+		: start(vtbh_new_seeded(seed))
+	{
+	}
+
+	size_t operator()(const T& value) const
+	{
+		vtb_hash h = start;
+		hash_append(h, value);
+		return h.hash;
+	}
+};
+
+template <typename T>
+typename std::enable_if<is_uniquely_represented<T>::value>::type hash_append(vtb_hash& h, const T& value)
+{
+	vtbh_bytes(&h, (const unsigned char*)&value, sizeof(T));
+}
+
+// -0 and +0 are equal, so they have to hash the same.
+inline void hash_append(vtb_hash& h, float f)
+{
+	f = f == 0 ? 0.0f : f;
+	vtbh_bytes(&h, (const unsigned char*)&f, sizeof(f));
+}
+
+inline void hash_append(vtb_hash& h, double d)
+{
+	d = d == 0 ? 0.0 : d;
+	vtbh_bytes(&h, (const unsigned char*)&d, sizeof(d));
+}
+
+template <typename T, size_t N>
+typename std::enable_if<!is_uniquely_represented<T>::value>::type hash_append(vtb_hash& h, const T (&values)[N])
+{
+	for (size_t k = 0; k < N; k++)
+		hash_append(h, values[k]);
+}
+
+template <typename A, typename B>
+typename std::enable_if<!is_uniquely_represented<std::pair<A, B>>::value>::type hash_append(vtb_hash& h, const std::pair<A, B>& pair)
+{
+	hash_append(h, pair.first, pair.second);
+}
+
+template <size_t Index, typename Tuple>
+typename std::enable_if<Index == std::tuple_size<Tuple>::value>::type vtbh__append_tuple(vtb_hash&, const Tuple&)
+{
+}
+
+template <size_t Index, typename Tuple>
+typename std::enable_if<(Index < std::tuple_size<Tuple>::value)>::type vtbh__append_tuple(vtb_hash& h, const Tuple& tuple)
+{
+	hash_append(h, std::get<Index>(tuple));
+	vtbh__append_tuple<Index + 1>(h, tuple);
+}
+
+template <typename... Types>
+void hash_append(vtb_hash& h, const std::tuple<Types...>& tuple)
+{
+	vtbh__append_tuple<0>(h, tuple);
+}
+
+// The length goes in first so "ab", "c" and "a", "bc" hash differently.
+template <typename Char, typename Traits, typename Allocator>
+void hash_append(vtb_hash& h, const std::basic_string<Char, Traits, Allocator>& s)
+{
+	hash_append(h, (uint64_t)s.size());
+	vtbh_bytes(&h, (const unsigned char*)s.data(), s.size()*sizeof(Char));
+}
+
+template <typename T, typename Allocator>
+void vtbh__append_elements(vtb_hash& h, const std::vector<T, Allocator>& v, std::true_type)
+{
+	if (v.size())
+		vtbh_bytes(&h, (const unsigned char*)v.data(), v.size()*sizeof(T));
+}
+
+template <typename T, typename Allocator>
+void vtbh__append_elements(vtb_hash& h, const std::vector<T, Allocator>& v, std::false_type)
+{
+	for (size_t k = 0; k < v.size(); k++)
+	{
+		// vector<bool> hands out proxies, this turns them back into bools.
+		const T& element = v[k];
+		hash_append(h, element);
+	}
+}
+
+template <typename T, typename Allocator>
+void hash_append(vtb_hash& h, const std::vector<T, Allocator>& v)
+{
+	hash_append(h, (uint64_t)v.size());
+	vtbh__append_elements(h, v, std::integral_constant<bool, is_uniquely_represented<T>::value && !std::is_same<T, bool>::value>());
+}
+
+template <typename First, typename Second, typename... Rest>
+void hash_append(vtb_hash& h, const First& first, const Second& second, const Rest&... rest)
+{
+	hash_append(h, first);
+	hash_append(h, second, rest...);
+}
+
+}
+
+// Makes std::hash<type> use vtb::hash<type>. Use it outside of any namespace.
+#define VTBH_STD_HASH(type) namespace std { template <> struct hash<type> : vtb::hash<type> {}; }
 
+#endif // __cplusplus
 
 #endif // VTB__HASH_H
 
 
 
-#ifdef VTB_HASH_IMPLEMENTATION
+#if defined(VTB_HASH_IMPLEMENTATION) && !defined(VTB__HASH_IMPLEMENTED)
+#define VTB__HASH_IMPLEMENTED
 
 #ifndef VTBH_ASSERT
 #include <assert.h>
@@ -117,41 +490,350 @@ VTBHDEF vtb_hash vtbh_new()
 
 	h.hash = 0x39531FCD;
 	h.salt = 0x7A8F05C5;
+	h.key[0] = h.key[1] = 0;
+	h.state = h.pending = 0;
 
 	return h;
 }
 
-VTBHDEF void vtbh_bytes(vtb_hash* h, const unsigned char* bytes, size_t num_bytes)
+// splitmix64's output function. Every bit of the seed affects every bit of
+// the state, so nearby seeds don't give nearby states.
+static uint64_t vtbh__mix64(uint64_t x)
+{
+	x ^= x >> 30;
+	x *= 0xBF58476D1CE4E5B9ull;
+	x ^= x >> 27;
+	x *= 0x94D049BB133111EBull;
+	x ^= x >> 31;
+	return x;
+}
+
+static void vtbh__keyed_bytes(vtb_hash* h, const unsigned char* bytes, size_t num_bytes);
+
+VTBHDEF vtb_hash vtbh_new_seeded(uint64_t seed)
+{
+	uint64_t key = vtbh__mix64(seed + 0x9E3779B97F4A7C15ull);
+
+	vtb_hash h;
+
+	h.key[0] = key | 1; // Never 0, that means unseeded.
+	h.key[1] = vtbh__mix64(key + 0x9E3779B97F4A7C15ull);
+	h.state = vtbh__mix64(h.key[1] + 0x9E3779B97F4A7C15ull);
+	h.pending = 0;
+	h.salt = 0;
+
+	// So that hashing nothing gives a seeded hash too.
+	vtbh__keyed_bytes(&h, 0, 0);
+
+	return h;
+}
+
+#if defined(_WIN32)
+#include <windows.h>
+#include <bcrypt.h>
+#pragma comment(lib, "bcrypt")
+#elif defined(__APPLE__) || defined(__FreeBSD__) || defined(__OpenBSD__) || defined(__NetBSD__)
+#include <stdlib.h> // For arc4random_buf
+#else
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<sys/random.h>)
+#include <sys/random.h>
+#define VTBH__GETRANDOM
+#endif
+#endif
+#include <stdio.h> // For reading /dev/urandom
+#endif
+
+#include <time.h> // For the fallback
+
+static uint64_t vtbh__random64()
+{
+	uint64_t random = 0;
+
+#if defined(_WIN32)
+	BCryptGenRandom(NULL, (PUCHAR)&random, sizeof(random), BCRYPT_USE_SYSTEM_PREFERRED_RNG);
+#elif defined(__APPLE__) || defined(__FreeBSD__) || defined(__OpenBSD__) || defined(__NetBSD__)
+	arc4random_buf(&random, sizeof(random));
+#else
+	int done = 0;
+
+#ifdef VTBH__GETRANDOM
+	done = getrandom(&random, sizeof(random), 0) == (ssize_t)sizeof(random);
+#endif
+
+	if (!done)
+	{
+		FILE* file = fopen("/dev/urandom", "rb");
+		if (file)
+		{
+			if (fread(&random, sizeof(random), 1, file) != 1)
+				random = 0;
+			fclose(file);
+		}
+	}
+#endif
+
+	// Nothing worked. Where things ended up in memory and the time are
+	// better than a constant.
+	if (!random)
+		random = vtbh__mix64((uint64_t)(size_t)&random ^ (uint64_t)time(NULL) ^ (uint64_t)clock() << 32);
+
+	return random ? random : 1;
+}
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define VTBH__LOAD64(p) (uint64_t)_InterlockedCompareExchange64((volatile long long*)(p), 0, 0)
+#define VTBH__CAS64(p, desired) (uint64_t)_InterlockedCompareExchange64((volatile long long*)(p), (long long)(desired), 0)
+#else
+#define VTBH__LOAD64(p) __atomic_load_n(p, __ATOMIC_ACQUIRE)
+// Sets *p to desired if it's 0. Returns what was there.
+static uint64_t vtbh__cas64(uint64_t* p, uint64_t desired)
+{
+	uint64_t expected = 0;
+	__atomic_compare_exchange_n(p, &expected, desired, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+	return expected;
+}
+#define VTBH__CAS64(p, desired) vtbh__cas64(p, desired)
+#endif
+
+VTBHDEF uint64_t vtbh_process_seed()
+{
+	static uint64_t seed;
+
+	uint64_t current = VTBH__LOAD64(&seed);
+	if (current)
+		return current;
+
+	uint64_t candidate = vtbh__random64();
+
+	// If another thread got there first, everyone uses its seed.
+	current = VTBH__CAS64(&seed, candidate);
+
+	return current ? current : candidate;
+}
+
+#include <string.h> // For memcpy
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+#define VTBH__BIG_ENDIAN
+#endif
+
+// The extract part of MT, but with different numbers, applied to each byte
+// value repeated four times:
+//
+//     filled = byte|(byte<<8)|(byte<<16)|(byte<<24);
+//     filled ^= filled >> 10;
+//     filled ^= (filled << 6) & 0xCE962B40;
+//     filled ^= (filled << 16) & 0x77E30000;
+//     filled ^= filled >> 19;
+static const uint32_t vtbh__filled[256] =
+{
+	0x00000000, 0x00104103, 0xA000B682, 0xA010F781, 0x0044044D, 0x0054454E, 0xA044B2CF, 0xA054F3CC,
+	0x0A8A095B, 0x0A9A4858, 0xAA8ABFD9, 0xAA9AFEDA, 0x0ACE0D16, 0x0ADE4C15, 0xAACEBB94, 0xAADEFA97,
+	0x01101536, 0x01005435, 0xA110A3B4, 0xA100E2B7, 0x0154117B, 0x01445078, 0xA154A7F9, 0xA144E6FA,
+	0x0B9A1C6D, 0x0B8A5D6E, 0xAB9AAAEF, 0xAB8AEBEC, 0x0BDE1820, 0x0BCE5923, 0xABDEAEA2, 0xABCEEFA1,
+	0x080A2329, 0x081A622A, 0xA80A95AB, 0xA81AD4A8, 0x084E2764, 0x085E6667, 0xA84E91E6, 0xA85ED0E5,
+	0x02802A72, 0x02906B71, 0xA2809CF0, 0xA290DDF3, 0x02C42E3F, 0x02D46F3C, 0xA2C498BD, 0xA2D4D9BE,
+	0x091A361F, 0x090A771C, 0xA91A809D, 0xA90AC19E, 0x095E3252, 0x094E7351, 0xA95E84D0, 0xA94EC5D3,
+	0x03903F44, 0x03807E47, 0xA39089C6, 0xA380C8C5, 0x03D43B09, 0x03C47A0A, 0xA3D48D8B, 0xA3C4CC88,
+	0x140452D0, 0x141413D3, 0xB404E452, 0xB414A551, 0x1440569D, 0x1450179E, 0xB440E01F, 0xB450A11C,
+	0x1E8E5B8B, 0x1E9E1A88, 0xBE8EED09, 0xBE9EAC0A, 0x1ECA5FC6, 0x1EDA1EC5, 0xBECAE944, 0xBEDAA847,
+	0x151447E6, 0x150406E5, 0xB514F164, 0xB504B067, 0x155043AB, 0x154002A8, 0xB550F529, 0xB540B42A,
+	0x1F9E4EBD, 0x1F8E0FBE, 0xBF9EF83F, 0xBF8EB93C, 0x1FDA4AF0, 0x1FCA0BF3, 0xBFDAFC72, 0xBFCABD71,
+	0x1C0E71F9, 0x1C1E30FA, 0xBC0EC77B, 0xBC1E8678, 0x1C4A75B4, 0x1C5A34B7, 0xBC4AC336, 0xBC5A8235,
+	0x168478A2, 0x169439A1, 0xB684CE20, 0xB6948F23, 0x16C07CEF, 0x16D03DEC, 0xB6C0CA6D, 0xB6D08B6E,
+	0x1D1E64CF, 0x1D0E25CC, 0xBD1ED24D, 0xBD0E934E, 0x1D5A6082, 0x1D4A2181, 0xBD5AD600, 0xBD4A9703,
+	0x17946D94, 0x17842C97, 0xB794DB16, 0xB7849A15, 0x17D069D9, 0x17C028DA, 0xB7D0DF5B, 0xB7C09E58,
+	0x880099A0, 0x8810D8A3, 0x28002F22, 0x28106E21, 0x88449DED, 0x8854DCEE, 0x28442B6F, 0x28546A6C,
+	0x828A90FB, 0x829AD1F8, 0x228A2679, 0x229A677A, 0x82CE94B6, 0x82DED5B5, 0x22CE2234, 0x22DE6337,
+	0x89108C96, 0x8900CD95, 0x29103A14, 0x29007B17, 0x895488DB, 0x8944C9D8, 0x29543E59, 0x29447F5A,
+	0x839A85CD, 0x838AC4CE, 0x239A334F, 0x238A724C, 0x83DE8180, 0x83CEC083, 0x23DE3702, 0x23CE7601,
+	0x800ABA89, 0x801AFB8A, 0x200A0C0B, 0x201A4D08, 0x804EBEC4, 0x805EFFC7, 0x204E0846, 0x205E4945,
+	0x8A80B3D2, 0x8A90F2D1, 0x2A800550, 0x2A904453, 0x8AC4B79F, 0x8AD4F69C, 0x2AC4011D, 0x2AD4401E,
+	0x811AAFBF, 0x810AEEBC, 0x211A193D, 0x210A583E, 0x815EABF2, 0x814EEAF1, 0x215E1D70, 0x214E5C73,
+	0x8B90A6E4, 0x8B80E7E7, 0x2B901066, 0x2B805165, 0x8BD4A2A9, 0x8BC4E3AA, 0x2BD4142B, 0x2BC45528,
+	0x9C04CB70, 0x9C148A73, 0x3C047DF2, 0x3C143CF1, 0x9C40CF3D, 0x9C508E3E, 0x3C4079BF, 0x3C5038BC,
+	0x968EC22B, 0x969E8328, 0x368E74A9, 0x369E35AA, 0x96CAC666, 0x96DA8765, 0x36CA70E4, 0x36DA31E7,
+	0x9D14DE46, 0x9D049F45, 0x3D1468C4, 0x3D0429C7, 0x9D50DA0B, 0x9D409B08, 0x3D506C89, 0x3D402D8A,
+	0x979ED71D, 0x978E961E, 0x379E619F, 0x378E209C, 0x97DAD350, 0x97CA9253, 0x37DA65D2, 0x37CA24D1,
+	0x940EE859, 0x941EA95A, 0x340E5EDB, 0x341E1FD8, 0x944AEC14, 0x945AAD17, 0x344A5A96, 0x345A1B95,
+	0x9E84E102, 0x9E94A001, 0x3E845780, 0x3E941683, 0x9EC0E54F, 0x9ED0A44C, 0x3EC053CD, 0x3ED012CE,
+	0x951EFD6F, 0x950EBC6C, 0x351E4BED, 0x350E0AEE, 0x955AF922, 0x954AB821, 0x355A4FA0, 0x354A0EA3,
+	0x9F94F434, 0x9F84B537, 0x3F9442B6, 0x3F8403B5, 0x9FD0F079, 0x9FC0B17A, 0x3FD046FB, 0x3FC007F8,
+};
+
+static void vtbh__step(uint32_t* hash, uint32_t* salt, uint32_t byte)
+{
+	// Cycle all bits by 1. This way, even if the byte
+	// we are hashing is 0, we still get a large change.
+	*hash = ((*hash << 1) | (*hash >> 31)) + 1;
+	*salt = ((*salt << 1) | (*salt >> 31)) + 1;
+
+	*hash ^= vtbh__filled[byte] ^ *salt;
+}
+
+#if defined(_MSC_VER) && defined(_M_X64)
+#include <intrin.h> // For _umul128
+#endif
+
+// The 128-bit product of a and b with its halves xored together, the mix
+// wyhash uses. If either is secret, so is the result.
+static uint64_t vtbh__mum(uint64_t a, uint64_t b)
+{
+#if defined(__SIZEOF_INT128__)
+	__uint128_t product = (__uint128_t)a * b;
+	return (uint64_t)product ^ (uint64_t)(product >> 64);
+#elif defined(_MSC_VER) && defined(_M_X64)
+	uint64_t high;
+	uint64_t low = _umul128(a, b, &high);
+	return low ^ high;
+#else
+	uint64_t ll = (a & 0xFFFFFFFF) * (b & 0xFFFFFFFF);
+	uint64_t lh = (a & 0xFFFFFFFF) * (b >> 32);
+	uint64_t hl = (a >> 32) * (b & 0xFFFFFFFF);
+	uint64_t hh = (a >> 32) * (b >> 32);
+	uint64_t middle = (ll >> 32) + (lh & 0xFFFFFFFF) + (hl & 0xFFFFFFFF);
+	uint64_t low = (middle << 32) | (ll & 0xFFFFFFFF);
+	uint64_t high = hh + (lh >> 32) + (hl >> 32) + (middle >> 32);
+	return low ^ high;
+#endif
+}
+
+static uint64_t vtbh__load64_le(const unsigned char* bytes)
+{
+#ifdef VTBH__BIG_ENDIAN
+	return ((uint64_t)bytes[0]) | ((uint64_t)bytes[1] << 8) | ((uint64_t)bytes[2] << 16) | ((uint64_t)bytes[3] << 24) |
+		((uint64_t)bytes[4] << 32) | ((uint64_t)bytes[5] << 40) | ((uint64_t)bytes[6] << 48) | ((uint64_t)bytes[7] << 56);
+#else
+	uint64_t block;
+	memcpy(&block, bytes, sizeof(block));
+	return block;
+#endif
+}
+
+// vtbh_new_seeded's function. Bytes are gathered into little endian 8 byte
+// blocks, and each one is multiplied into the state with both halves of the
+// key, so unlike vtbh__step a difference in the input doesn't come out the
+// same whatever the seed. h->hash is brought up to date at the end of every
+// call, since there's no separate finish.
+static void vtbh__keyed_bytes(vtb_hash* h, const unsigned char* bytes, size_t num_bytes)
+{
+	uint64_t key0 = h->key[0];
+	uint64_t key1 = h->key[1];
+	uint64_t state = h->state;
+	uint64_t pending = h->pending;
+	uint32_t count = h->salt;
+	size_t k = 0;
+
+	// Finish a block an earlier call started.
+	for (; k < num_bytes && (count & 7); k++, count++)
+	{
+		pending |= (uint64_t)bytes[k] << (8*(count & 7));
+
+		if ((count & 7) == 7)
+		{
+			state = vtbh__mum(pending ^ key0, state ^ key1);
+			pending = 0;
+		}
+	}
+
+	for (; k + 8 <= num_bytes; k += 8, count += 8)
+		state = vtbh__mum(vtbh__load64_le(bytes + k) ^ key0, state ^ key1);
+
+	for (; k < num_bytes; k++, count++)
+		pending |= (uint64_t)bytes[k] << (8*(count & 7));
+
+	h->state = state;
+	h->pending = pending;
+	h->salt = count;
+
+	// The count keeps trailing zero bytes from disappearing into pending.
+	uint64_t result = vtbh__mum(pending ^ key1, state ^ key0 ^ count);
+	h->hash = (uint32_t)(result ^ (result >> 32));
+}
+
+// Hashes each 32-bit word's bytes from least to most significant, ie in
+// little endian order. Words are loaded with memcpy so they can be
+// unaligned.
+static void vtbh__words(vtb_hash* h, const unsigned char* words, size_t num_words)
 {
+	if (h->key[0])
+	{
+#ifdef VTBH__BIG_ENDIAN
+		// Swapped a batch at a time, since every call finalizes.
+		unsigned char bytes[64];
+		while (num_words)
+		{
+			size_t batch = num_words < sizeof(bytes)/4 ? num_words : sizeof(bytes)/4;
+			for (size_t k = 0; k < batch*4; k += 4)
+			{
+				bytes[k] = words[k + 3];
+				bytes[k + 1] = words[k + 2];
+				bytes[k + 2] = words[k + 1];
+				bytes[k + 3] = words[k];
+			}
+
+			vtbh__keyed_bytes(h, bytes, batch*4);
+			words += batch*4;
+			num_words -= batch;
+		}
+#else
+		// Already in little endian order.
+		vtbh__keyed_bytes(h, words, num_words*4);
+#endif
+		return;
+	}
+
 	uint32_t hash = h->hash;
 	uint32_t salt = h->salt;
 
-	for (unsigned int k = 0; k < (unsigned int)num_bytes; k++)
+	for (size_t k = 0; k < num_words; k++)
 	{
-		// Cycle all bits by 1. This way, even if the byte
-		// we are hashing is 0, we still get a large change.
-		uint32_t top_byte = hash >> 31;
-		hash = ((hash << 1) | top_byte) + 1;
+		uint32_t word;
+		memcpy(&word, words + k*4, sizeof(word));
 
-		top_byte = salt >> 31;
-		salt = ((salt << 1) | top_byte) + 1;
+		vtbh__step(&hash, &salt, word & 0xFF);
+		vtbh__step(&hash, &salt, (word >> 8) & 0xFF);
+		vtbh__step(&hash, &salt, (word >> 16) & 0xFF);
+		vtbh__step(&hash, &salt, word >> 24);
+	}
 
-		uint32_t byte = bytes[k];
-		uint32_t filled = byte|(byte<<8)|(byte<<16)|(byte<<24);
+	h->hash = hash;
+	h->salt = salt;
+}
 
-		// The extract part of MT, but with different numbers
-		filled ^= filled >> 10;
-		filled ^= (filled << 6) & 0xCE962B40;
-		filled ^= (filled << 16) & 0x77E30000;
-		filled ^= filled >> 19;
+VTBHDEF void vtbh_bytes(vtb_hash* h, const unsigned char* bytes, size_t num_bytes)
+{
+	if (h->key[0])
+	{
+		vtbh__keyed_bytes(h, bytes, num_bytes);
+		return;
+	}
 
-		filled ^= salt;
+#ifdef VTBH__BIG_ENDIAN
+	uint32_t hash = h->hash;
+	uint32_t salt = h->salt;
 
-		hash ^= filled;
-	}
+	for (size_t k = 0; k < num_bytes; k++)
+		vtbh__step(&hash, &salt, bytes[k]);
 
 	h->hash = hash;
 	h->salt = salt;
+#else
+	// Word loads are the same as the bytes in order here.
+	size_t num_words = num_bytes / 4;
+	vtbh__words(h, bytes, num_words);
+
+	uint32_t hash = h->hash;
+	uint32_t salt = h->salt;
+
+	for (size_t k = num_words*4; k < num_bytes; k++)
+		vtbh__step(&hash, &salt, bytes[k]);
+
+	h->hash = hash;
+	h->salt = salt;
+#endif
 }
 
 VTBHDEF inline void vtbh_byte(vtb_hash* h, unsigned char byte)
@@ -159,24 +841,33 @@ VTBHDEF inline void vtbh_byte(vtb_hash* h, unsigned char byte)
 	vtbh_bytes(h, &byte, 1);
 }
 
+// With VTBH_PORTABLE, ints and floats are hashed as little endian bytes, so
+// the results are the same on every platform. Without it they're hashed as
+// they are in memory, which is the same thing on little endian platforms.
+#ifdef VTBH_PORTABLE
+#define VTBH__NATIVE_WORDS(h, words, num_words) vtbh__words(h, (const unsigned char*)(words), num_words)
+#else
+#define VTBH__NATIVE_WORDS(h, words, num_words) vtbh_bytes(h, (const unsigned char*)(words), (num_words) * 4)
+#endif
+
 VTBHDEF void vtbh_ints(vtb_hash* h, unsigned int* ints, size_t num_ints)
 {
-	vtbh_bytes(h, (unsigned char*)ints, num_ints * sizeof(unsigned int));
+	VTBH__NATIVE_WORDS(h, ints, num_ints);
 }
 
 VTBHDEF void vtbh_int(vtb_hash* h, unsigned int i)
 {
-	vtbh_bytes(h, (unsigned char*)&i, sizeof(unsigned int));
+	VTBH__NATIVE_WORDS(h, &i, 1);
 }
 
 VTBHDEF void vtbh_floats(vtb_hash* h, const float* floats, size_t num_floats)
 {
-	vtbh_bytes(h, (unsigned char*)floats, num_floats * sizeof(float));
+	VTBH__NATIVE_WORDS(h, floats, num_floats);
 }
 
 VTBHDEF void vtbh_float(vtb_hash* h, float f)
 {
-	vtbh_bytes(h, (unsigned char*)&f, sizeof(float));
+	VTBH__NATIVE_WORDS(h, &f, 1);
 }
 
 VTBHDEF void vtbh_string(vtb_hash* h, const char* s, size_t length)
@@ -184,5 +875,1149 @@ VTBHDEF void vtbh_string(vtb_hash* h, const char* s, size_t length)
 	vtbh_bytes(h, (unsigned char*)s, length);
 }
 
+#if !defined(VTBH_NO_SIMD)
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define VTBH__AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#ifdef __SSE4_1__
+#include <smmintrin.h>
+#endif
+#define VTBH__SSE2
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define VTBH__NEON
+#endif
+#endif
+
+// The canonical hashes run VTBH__LANES independent multiply-rotate lanes,
+// one 32-bit word per lane per step, the same round as xxHash32. The SIMD
+// versions process exactly the same words in exactly the same lanes as the
+// plain C version, so they all agree.
+#define VTBH__LANES 16
+
+#define VTBH__PRIME1 0x9E3779B1u
+#define VTBH__PRIME2 0x85EBCA77u
+#define VTBH__PRIME3 0xC2B2AE3Du
+
+static uint32_t vtbh__rotl(uint32_t x, int r)
+{
+	return (x << r) | (x >> (32 - r));
+}
+
+static uint32_t vtbh__lane_round(uint32_t lane, uint32_t word)
+{
+	lane += word * VTBH__PRIME2;
+	lane = vtbh__rotl(lane, 13);
+	return lane * VTBH__PRIME1;
+}
+
+// -0 becomes +0 and every NaN becomes the same quiet NaN. Done on the bits
+// so that it doesn't depend on the floating point environment.
+static uint32_t vtbh__canonical_float(uint32_t bits)
+{
+	uint32_t magnitude = bits & 0x7FFFFFFFu;
+
+	if (magnitude == 0)
+		return 0;
+
+	if (magnitude > 0x7F800000u)
+		return 0x7FC00000u;
+
+	return bits;
+}
+
+static uint64_t vtbh__canonical_double(uint64_t bits)
+{
+	uint64_t magnitude = bits & 0x7FFFFFFFFFFFFFFFull;
+
+	if (magnitude == 0)
+		return 0;
+
+	if (magnitude > 0x7FF0000000000000ull)
+		return 0x7FF8000000000000ull;
+
+	return bits;
+}
+
+static void vtbh__lanes_start(const vtb_hash* h, uint32_t* lanes)
+{
+	for (int k = 0; k < VTBH__LANES; k++)
+		lanes[k] = (h->hash + VTBH__PRIME1 * (uint32_t)(k + 1)) ^ h->salt;
+}
+
+// Folds the lanes down to one word and hashes it into h with vtbh_bytes,
+// so h keeps working like any other vtb_hash.
+static void vtbh__lanes_finish(vtb_hash* h, const uint32_t* lanes, uint64_t num_words, uint32_t tag)
+{
+	uint32_t v = tag ^ (uint32_t)num_words ^ ((uint32_t)(num_words >> 32) * VTBH__PRIME3);
+
+	for (int k = 0; k < VTBH__LANES; k++)
+		v = vtbh__rotl((v ^ lanes[k]) * VTBH__PRIME1, 13);
+
+	v ^= v >> 15;
+	v *= VTBH__PRIME2;
+	v ^= v >> 13;
+	v *= VTBH__PRIME3;
+	v ^= v >> 16;
+
+	// Little endian, so the result doesn't depend on the platform.
+	unsigned char bytes[4];
+	bytes[0] = (unsigned char)v;
+	bytes[1] = (unsigned char)(v >> 8);
+	bytes[2] = (unsigned char)(v >> 16);
+	bytes[3] = (unsigned char)(v >> 24);
+
+	vtbh_bytes(h, bytes, sizeof(bytes));
+}
+
+#ifdef VTBH__SSE2
+
+#ifdef __SSE4_1__
+#define vtbh__mullo_128 _mm_mullo_epi32
+#else
+// SSE2 has no 32-bit low multiply. Do the even and odd lanes with the
+// 32x32->64 multiply and put the low halves back together.
+static __m128i vtbh__mullo_128(__m128i a, __m128i b)
+{
+	__m128i even = _mm_mul_epu32(a, b);
+	__m128i odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+	return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)), _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+}
+#endif
+
+static __m128i vtbh__round_128(__m128i lane, __m128i word)
+{
+	lane = _mm_add_epi32(lane, vtbh__mullo_128(word, _mm_set1_epi32((int)VTBH__PRIME2)));
+	lane = _mm_or_si128(_mm_slli_epi32(lane, 13), _mm_srli_epi32(lane, 19));
+	return vtbh__mullo_128(lane, _mm_set1_epi32((int)VTBH__PRIME1));
+}
+
+static __m128i vtbh__canonical_floats_128(__m128i bits)
+{
+	__m128i magnitude = _mm_and_si128(bits, _mm_set1_epi32(0x7FFFFFFF));
+	__m128i is_zero = _mm_cmpeq_epi32(magnitude, _mm_setzero_si128());
+	__m128i is_nan = _mm_cmpgt_epi32(magnitude, _mm_set1_epi32(0x7F800000));
+
+	bits = _mm_andnot_si128(is_zero, bits);
+	return _mm_or_si128(_mm_andnot_si128(is_nan, bits), _mm_and_si128(is_nan, _mm_set1_epi32(0x7FC00000)));
+}
+
+static __m128i vtbh__canonical_doubles_128(__m128i bits)
+{
+	__m128i magnitude = _mm_and_si128(bits, _mm_set_epi32(0x7FFFFFFF, -1, 0x7FFFFFFF, -1));
+	__m128i half_zero = _mm_cmpeq_epi32(magnitude, _mm_setzero_si128());
+	__m128i is_zero = _mm_and_si128(half_zero, _mm_shuffle_epi32(half_zero, _MM_SHUFFLE(2, 3, 0, 1)));
+	__m128i is_nan = _mm_castpd_si128(_mm_cmpunord_pd(_mm_castsi128_pd(bits), _mm_castsi128_pd(bits)));
+
+	bits = _mm_andnot_si128(is_zero, bits);
+	return _mm_or_si128(_mm_andnot_si128(is_nan, bits), _mm_and_si128(is_nan, _mm_set_epi32(0x7FF80000, 0, 0x7FF80000, 0)));
+}
+
+#endif
+
+#ifdef VTBH__AVX2
+
+static __m256i vtbh__round_256(__m256i lane, __m256i word)
+{
+	lane = _mm256_add_epi32(lane, _mm256_mullo_epi32(word, _mm256_set1_epi32((int)VTBH__PRIME2)));
+	lane = _mm256_or_si256(_mm256_slli_epi32(lane, 13), _mm256_srli_epi32(lane, 19));
+	return _mm256_mullo_epi32(lane, _mm256_set1_epi32((int)VTBH__PRIME1));
+}
+
+static __m256i vtbh__canonical_256(__m256i bits, __m256i magnitude_mask, __m256i nan_bits, int doubles)
+{
+	__m256i magnitude = _mm256_and_si256(bits, magnitude_mask);
+	__m256i is_zero, is_nan;
+
+	if (doubles)
+	{
+		is_zero = _mm256_cmpeq_epi64(magnitude, _mm256_setzero_si256());
+		is_nan = _mm256_cmpgt_epi64(magnitude, _mm256_set1_epi64x(0x7FF0000000000000ll));
+	}
+	else
+	{
+		is_zero = _mm256_cmpeq_epi32(magnitude, _mm256_setzero_si256());
+		is_nan = _mm256_cmpgt_epi32(magnitude, _mm256_set1_epi32(0x7F800000));
+	}
+
+	bits = _mm256_andnot_si256(is_zero, bits);
+	return _mm256_or_si256(_mm256_andnot_si256(is_nan, bits), _mm256_and_si256(is_nan, nan_bits));
+}
+
+#endif
+
+#ifdef VTBH__NEON
+
+static uint32x4_t vtbh__round_neon(uint32x4_t lane, uint32x4_t word)
+{
+	lane = vmlaq_u32(lane, word, vdupq_n_u32(VTBH__PRIME2));
+	lane = vsriq_n_u32(vshlq_n_u32(lane, 13), lane, 19);
+	return vmulq_u32(lane, vdupq_n_u32(VTBH__PRIME1));
+}
+
+static uint32x4_t vtbh__canonical_floats_neon(uint32x4_t bits)
+{
+	uint32x4_t magnitude = vandq_u32(bits, vdupq_n_u32(0x7FFFFFFFu));
+	uint32x4_t is_zero = vceqq_u32(magnitude, vdupq_n_u32(0));
+	uint32x4_t is_nan = vcgtq_u32(magnitude, vdupq_n_u32(0x7F800000u));
+
+	bits = vbicq_u32(bits, is_zero);
+	return vbslq_u32(is_nan, vdupq_n_u32(0x7FC00000u), bits);
+}
+
+#endif
+
+// Lane k gets word k of every group of VTBH__LANES words.
+static size_t vtbh__floats_simd(uint32_t* lanes, const float* floats, size_t num_floats)
+{
+	size_t k = 0;
+
+#if defined(VTBH__AVX2)
+	__m256i magnitude_mask = _mm256_set1_epi32(0x7FFFFFFF);
+	__m256i nan_bits = _mm256_set1_epi32(0x7FC00000);
+	__m256i a = _mm256_loadu_si256((const __m256i*)&lanes[0]);
+	__m256i b = _mm256_loadu_si256((const __m256i*)&lanes[8]);
+
+	for (; k + VTBH__LANES <= num_floats; k += VTBH__LANES)
+	{
+		a = vtbh__round_256(a, vtbh__canonical_256(_mm256_loadu_si256((const __m256i*)&floats[k]), magnitude_mask, nan_bits, 0));
+		b = vtbh__round_256(b, vtbh__canonical_256(_mm256_loadu_si256((const __m256i*)&floats[k + 8]), magnitude_mask, nan_bits, 0));
+	}
+
+	_mm256_storeu_si256((__m256i*)&lanes[0], a);
+	_mm256_storeu_si256((__m256i*)&lanes[8], b);
+#elif defined(VTBH__SSE2)
+	__m128i a = _mm_loadu_si128((const __m128i*)&lanes[0]);
+	__m128i b = _mm_loadu_si128((const __m128i*)&lanes[4]);
+	__m128i c = _mm_loadu_si128((const __m128i*)&lanes[8]);
+	__m128i d = _mm_loadu_si128((const __m128i*)&lanes[12]);
+
+	for (; k + VTBH__LANES <= num_floats; k += VTBH__LANES)
+	{
+		a = vtbh__round_128(a, vtbh__canonical_floats_128(_mm_loadu_si128((const __m128i*)&floats[k])));
+		b = vtbh__round_128(b, vtbh__canonical_floats_128(_mm_loadu_si128((const __m128i*)&floats[k + 4])));
+		c = vtbh__round_128(c, vtbh__canonical_floats_128(_mm_loadu_si128((const __m128i*)&floats[k + 8])));
+		d = vtbh__round_128(d, vtbh__canonical_floats_128(_mm_loadu_si128((const __m128i*)&floats[k + 12])));
+	}
+
+	_mm_storeu_si128((__m128i*)&lanes[0], a);
+	_mm_storeu_si128((__m128i*)&lanes[4], b);
+	_mm_storeu_si128((__m128i*)&lanes[8], c);
+	_mm_storeu_si128((__m128i*)&lanes[12], d);
+#elif defined(VTBH__NEON)
+	uint32x4_t a = vld1q_u32(&lanes[0]);
+	uint32x4_t b = vld1q_u32(&lanes[4]);
+	uint32x4_t c = vld1q_u32(&lanes[8]);
+	uint32x4_t d = vld1q_u32(&lanes[12]);
+
+	for (; k + VTBH__LANES <= num_floats; k += VTBH__LANES)
+	{
+		const uint32_t* words = (const uint32_t*)&floats[k];
+		a = vtbh__round_neon(a, vtbh__canonical_floats_neon(vld1q_u32(words)));
+		b = vtbh__round_neon(b, vtbh__canonical_floats_neon(vld1q_u32(words + 4)));
+		c = vtbh__round_neon(c, vtbh__canonical_floats_neon(vld1q_u32(words + 8)));
+		d = vtbh__round_neon(d, vtbh__canonical_floats_neon(vld1q_u32(words + 12)));
+	}
+
+	vst1q_u32(&lanes[0], a);
+	vst1q_u32(&lanes[4], b);
+	vst1q_u32(&lanes[8], c);
+	vst1q_u32(&lanes[12], d);
+#else
+	(void)lanes;
+	(void)floats;
+	(void)num_floats;
+#endif
+
+	return k;
+}
+
+// Each double is two words, low half first.
+static size_t vtbh__doubles_simd(uint32_t* lanes, const double* doubles, size_t num_doubles)
+{
+	size_t k = 0;
+
+#if defined(VTBH__AVX2)
+	__m256i magnitude_mask = _mm256_set1_epi64x(0x7FFFFFFFFFFFFFFFll);
+	__m256i nan_bits = _mm256_set1_epi64x(0x7FF8000000000000ll);
+	__m256i a = _mm256_loadu_si256((const __m256i*)&lanes[0]);
+	__m256i b = _mm256_loadu_si256((const __m256i*)&lanes[8]);
+
+	for (; k + VTBH__LANES/2 <= num_doubles; k += VTBH__LANES/2)
+	{
+		a = vtbh__round_256(a, vtbh__canonical_256(_mm256_loadu_si256((const __m256i*)&doubles[k]), magnitude_mask, nan_bits, 1));
+		b = vtbh__round_256(b, vtbh__canonical_256(_mm256_loadu_si256((const __m256i*)&doubles[k + 4]), magnitude_mask, nan_bits, 1));
+	}
+
+	_mm256_storeu_si256((__m256i*)&lanes[0], a);
+	_mm256_storeu_si256((__m256i*)&lanes[8], b);
+#elif defined(VTBH__SSE2)
+	__m128i a = _mm_loadu_si128((const __m128i*)&lanes[0]);
+	__m128i b = _mm_loadu_si128((const __m128i*)&lanes[4]);
+	__m128i c = _mm_loadu_si128((const __m128i*)&lanes[8]);
+	__m128i d = _mm_loadu_si128((const __m128i*)&lanes[12]);
+
+	for (; k + VTBH__LANES/2 <= num_doubles; k += VTBH__LANES/2)
+	{
+		a = vtbh__round_128(a, vtbh__canonical_doubles_128(_mm_loadu_si128((const __m128i*)&doubles[k])));
+		b = vtbh__round_128(b, vtbh__canonical_doubles_128(_mm_loadu_si128((const __m128i*)&doubles[k + 2])));
+		c = vtbh__round_128(c, vtbh__canonical_doubles_128(_mm_loadu_si128((const __m128i*)&doubles[k + 4])));
+		d = vtbh__round_128(d, vtbh__canonical_doubles_128(_mm_loadu_si128((const __m128i*)&doubles[k + 6])));
+	}
+
+	_mm_storeu_si128((__m128i*)&lanes[0], a);
+	_mm_storeu_si128((__m128i*)&lanes[4], b);
+	_mm_storeu_si128((__m128i*)&lanes[8], c);
+	_mm_storeu_si128((__m128i*)&lanes[12], d);
+#else
+	// NEON has no 64-bit compare in ARMv7, so doubles use the plain C path there.
+	(void)lanes;
+	(void)doubles;
+	(void)num_doubles;
+#endif
+
+	return k;
+}
+
+VTBHDEF void vtbh_floats_canonical(vtb_hash* h, const float* floats, size_t num_floats)
+{
+	uint32_t lanes[VTBH__LANES];
+	vtbh__lanes_start(h, lanes);
+
+	size_t k = vtbh__floats_simd(lanes, floats, num_floats);
+
+	for (; k < num_floats; k++)
+	{
+		uint32_t bits;
+		memcpy(&bits, &floats[k], sizeof(bits));
+		lanes[k % VTBH__LANES] = vtbh__lane_round(lanes[k % VTBH__LANES], vtbh__canonical_float(bits));
+	}
+
+	vtbh__lanes_finish(h, lanes, num_floats, 0x464C5433); // "FLT3"
+}
+
+VTBHDEF void vtbh_doubles_canonical(vtb_hash* h, const double* doubles, size_t num_doubles)
+{
+	uint32_t lanes[VTBH__LANES];
+	vtbh__lanes_start(h, lanes);
+
+	size_t k = vtbh__doubles_simd(lanes, doubles, num_doubles);
+
+	for (; k < num_doubles; k++)
+	{
+		uint64_t bits;
+		memcpy(&bits, &doubles[k], sizeof(bits));
+		bits = vtbh__canonical_double(bits);
+
+		size_t word = k*2;
+		lanes[word % VTBH__LANES] = vtbh__lane_round(lanes[word % VTBH__LANES], (uint32_t)bits);
+		lanes[(word + 1) % VTBH__LANES] = vtbh__lane_round(lanes[(word + 1) % VTBH__LANES], (uint32_t)(bits >> 32));
+	}
+
+	vtbh__lanes_finish(h, lanes, (uint64_t)num_doubles*2, 0x44424C36); // "DBL6"
+}
+
+// Random values for each byte, from splitmix64.
+static const uint64_t vtbh__gear[256] =
+{
+	0x2CB0F69F4ABEA221ull, 0x9417034723148989ull, 0xDD555950609DFE03ull, 0xDBAFB150DEB12800ull,
+	0x7E789B2E6C442CB6ull, 0xF41E5636C7E4F8C4ull, 0x0959D150F8FBA7E4ull, 0xA97316F13CDB9EEAull,
+	0x74CD8258F9520068ull, 0x55C74A62E116868Bull, 0xD2F4C799A2023CBDull, 0xDF98CB79A37B51B9ull,
+	0x396F5885524F3905ull, 0xAF1D56386CA3B276ull, 0xA9FFBE6B5104E85Aull, 0x6BD0C51B9FD533B3ull,
+	0x980CE91C50AB4B56ull, 0x28AC395780FE62C5ull, 0x768912E3A6BCEDC7ull, 0x50B3E8C9332C7C88ull,
+	0xCE3BBFE520BD47DAull, 0xCBA6C8E8E0BB7C4Full, 0xBF194DB8434A346Dull, 0x7D8F2A7B60416D7Full,
+	0x0849D1F6E0E10A5Eull, 0x7654B590D064E22Full, 0x16D1DA9507DF3AF2ull, 0xF63AEF1089EA30E4ull,
+	0x9ADE6673CC6C522Bull, 0x4C75BC274E37087Cull, 0xD35E12B49F51F27Bull, 0x22DDF2FFCEE481EAull,
+	0x06007FB13C59A1F1ull, 0x8966A38C651EA4DAull, 0x25242F018FC01AC6ull, 0xA73EC74FA31B717Cull,
+	0x7EE0ABDD9797D3A2ull, 0x5C06FF7DC4AC1880ull, 0x8434E41042C28A7Dull, 0x770A372D64327351ull,
+	0xEED940DAD9E9C06Dull, 0x8977E93646524825ull, 0xA9897F0A62A51616ull, 0xA35D4250C53F2B3Aull,
+	0x4072542A94B9C33Eull, 0x3154A7A62447E8ABull, 0x686865712A1A245Eull, 0x0FBA67727D7B3B98ull,
+	0x0634E2024536912Full, 0xD9FF52A26CF9881Aull, 0x9435DC0399F932DAull, 0x18D39FC1AF93E7F0ull,
+	0x12F7147C1E7F46ABull, 0xDEDF66783EDDB4A0ull, 0x6F75480614554798ull, 0xE40E95E8EF84BDE2ull,
+	0xBB41FE601FEFB566ull, 0x5C3702E4C7BF19F1ull, 0x8C7D1D0D3D4A8EC5ull, 0xEE779996BA62DCCBull,
+	0x80CCB15BF530844Bull, 0xDF56E7DC4D57959Cull, 0x9EB86A81FE90B68Eull, 0x6A25741FA696FBD3ull,
+	0x7009346385A45644ull, 0x8F4ACC8C1520DD73ull, 0x75A59D61AE0F8464ull, 0xD9600A5F4B8B735Cull,
+	0x90EE70D4C2774058ull, 0x8A5F6C4B9A613341ull, 0xBAE94E097390FD42ull, 0x653727708A8CAE7Cull,
+	0x54A64593163B976Full, 0x551FB9261926A565ull, 0x903B2AAD4C38672Aull, 0x83731D929AA1FF24ull,
+	0x48311D2EC01F36EDull, 0x53A5DB5B92E313EFull, 0xD3B8CB608AAB8B70ull, 0x0F022CD022EA0CBFull,
+	0xBA7E97A12F21BAA6ull, 0xB895ACC1E36F3046ull, 0x88CB4B1ADBF0F0C0ull, 0xA08F47EDD89B430Bull,
+	0x4060CCB36EFD6C18ull, 0x0DCF835FB6B9345Eull, 0x38DF4AC46EE5762Bull, 0x986360357932DCBDull,
+	0xBDEB8D63741FE7D9ull, 0x5D23CB0AEDFFC430ull, 0x6A5EFE3A842100A4ull, 0x0D4CC01BF4E09A16ull,
+	0x03DBEF4217C97212ull, 0x3D8DED6C69C8B3ACull, 0x53D290FA4DCEE280ull, 0x00CE706478000997ull,
+	0xBDF7B12C56756763ull, 0x06C99071719DC103ull, 0xD5897678E0DF3FEEull, 0x74429D9AC72F7146ull,
+	0x9730AE769149CBBAull, 0x10EC1A636FD6612Dull, 0x5DC5D9EA650FA766ull, 0xB360E068CAC3ADC2ull,
+	0xF8DF11CB5CE17A0Cull, 0xA9292BBAE2191DF9ull, 0x3F3D169157DA4AEFull, 0x41D2DAB33367F9DFull,
+	0x95E671EEFBD33CAEull, 0xD5BEDCACB64A8FA9ull, 0xE494760F1BA45656ull, 0x21B556B8B6EE2C5Full,
+	0xA1ED31D3D69B05CCull, 0x025819F971A39E83ull, 0xB9B3379A4081919Aull, 0x550758640BF14A28ull,
+	0x151FEEBB4E040F10ull, 0x423490DF7ADFC8B3ull, 0x8BAE8D6E276C88E4ull, 0x526DD4F720811612ull,
+	0xFFD5FB93B0B2D28Cull, 0xA9ABB68F830215A8ull, 0x1751110C78D039FEull, 0x103F09C76E08C0B5ull,
+	0x2862583CE905324Full, 0x939829751E945862ull, 0xFD2BAF95439547EEull, 0x3F96E3E88A7E3EF0ull,
+	0x3DB34783D40D6E72ull, 0xB2FD49E41FA25861ull, 0x18D2C928BF0BC4A3ull, 0x2806FF0A63CE82B4ull,
+	0x86748DE3E14404E4ull, 0xA22AE3B5FF1A68CEull, 0x316214DF224E0D71ull, 0xD8FB60F9BCDDE6B5ull,
+	0x75931E90D5B688CDull, 0x97974EEE0CEA70BAull, 0x3C0E3E31C2286C53ull, 0x538BC977BAA5C994ull,
+	0xF384A2908191BD29ull, 0x0E28D06838B555D6ull, 0xE3CF2205411E6D7Aull, 0xEDECB325806E77F0ull,
+	0x5B8463E7456B20B8ull, 0x5569BA971A13CABDull, 0x97D3D2E344F1E484ull, 0x17704EBFA5491F08ull,
+	0xD068968795A32B72ull, 0x7D579C7C04AEA72Aull, 0x056F6C5D6E07D38Dull, 0x8267CC6EC5069EFCull,
+	0xDF270C1EF21852DFull, 0x75F3CFA3FF5B74A8ull, 0x9453CD41C9093294ull, 0xAD8CC50D02158220ull,
+	0x494A8E68B6811522ull, 0xFDC2DC1FB526A978ull, 0xA00D7FB47AFA2772ull, 0x02A5A6B22B45D376ull,
+	0xDB7A320686BD2CBBull, 0xBB7EC9DB8ED84107ull, 0xA0419A506CB535EFull, 0x751678B4C82D1E2Aull,
+	0xD6A0398CA01EF5ACull, 0xBEC9D0E6FD0B27E8ull, 0x363ED5D997C510EAull, 0xAA8CFD101861575Full,
+	0xC35F6C57190C3646ull, 0xAA58EDD1230B6282ull, 0xAEE6BB4C99509C3Aull, 0x6A1E8C62DB7B532Bull,
+	0xD275C05E4924350Aull, 0xDD5C0DAA5D4B823Eull, 0xA9AE10999C1F45DAull, 0xD0778E076A846E20ull,
+	0x6F7304AECD9BBF45ull, 0x692AB383113C68AEull, 0x8B0280356F484328ull, 0x99866EFB37B72076ull,
+	0xB5797760C7108BA6ull, 0x439FEBC33D5C0CA0ull, 0xA306A36C73E81D09ull, 0xA927B037250BC6B9ull,
+	0xDF2BDE709A68740Bull, 0xEDCD706720F932CCull, 0x61A884C301EE6D4Eull, 0x8108084290F3F2EFull,
+	0x28321EA11485BD62ull, 0x969E36E0E6F9B6DEull, 0x3E6B1D5CF28C5483ull, 0xC72EBC0070076B77ull,
+	0x13D73121A7A448F6ull, 0x22743FA795FEB53Aull, 0x2BD608CCA7803150ull, 0xCAE4B5723D21581Cull,
+	0x8E70BBB87A85A239ull, 0xD98023B873B129AEull, 0x77B69E4FCFE53920ull, 0x0508E387973F9B5Full,
+	0xBF2966D283C64F11ull, 0xAECDF57019E23471ull, 0x36E7A8E998FE1E04ull, 0x0780542BB39C8CD9ull,
+	0x4095E66DAB7AEE65ull, 0x2086704201A7469Eull, 0x5A5D698442D2E216ull, 0xE421106739485E0Cull,
+	0xEA88E48D6EEDD5EDull, 0xF8F91DAD5142564Dull, 0x0504199B2E70F466ull, 0xA0B0E2C6526D6EE5ull,
+	0xFB3BEF18A0E0C8A9ull, 0x197B1A5236D9566Bull, 0xB14E3945730A5BDFull, 0xB9B7D6906877EA75ull,
+	0xF618A46B8DE61FC1ull, 0x3FB889497A2F1241ull, 0xB3AEEAF7FEFA8BC5ull, 0xCBE100A2EFD63F9Aull,
+	0x3556152543CC4204ull, 0xD9605D470D63AB58ull, 0x15545749B38B81B5ull, 0x22DB5BAA269E9752ull,
+	0x780040E30AA2C9E6ull, 0xC180448B0640C9CBull, 0x6B2A492483C9456Eull, 0xA76CEE29E128036Cull,
+	0x089F699D6BB0F074ull, 0x29FAF34444846ECAull, 0xB3C982023F05A58Bull, 0xE6EFC66581E03A5Aull,
+	0x52939EB64B758485ull, 0xF9354E3DF005A534ull, 0xC68B2A012AA99D70ull, 0xEA7D677DC1397E0Full,
+	0x1734BD4C86DE6E03ull, 0x0356A82459388A9Full, 0xC43AA3ECE4266EE2ull, 0x893BC7D1412EAE2Dull,
+	0x3AAB49744F9B080Eull, 0xED294B9DFC776923ull, 0xCD6E499B5D4DADE2ull, 0x9550E1F6C3B36609ull,
+	0x2283C0A27F964EF1ull, 0x3A9760919B276C63ull, 0xDEC8B25069A70CFBull, 0x3B5FAB4305A819C8ull,
+	0x37ACCF033FB26034ull, 0x9C01F1C52E8578DDull, 0xC810F4676D8701DFull, 0x6233712C854B1DFCull,
+	0x90FA9224644845D6ull, 0x9305A3AFE347F3D0ull, 0xD5E66DBD1941872Bull, 0xE23FA3D2BA84472Eull,
+};
+
+// Gear shifts the hash left by one bit per byte, so bit k only depends on
+// the last k+1 bytes. Boundaries test the top bits, which see the full 64
+// byte window. Before the chunk reaches avg_size the mask has two more bits
+// and after it two fewer, which pulls chunk sizes in towards avg_size
+// (FastCDC's normalized chunking).
+VTBHDEF vtb_chunker vtbh_chunker_new(size_t min_size, size_t avg_size, size_t max_size)
+{
+	VTBH__CHECK(min_size >= 1);
+	VTBH__CHECK(min_size <= avg_size && avg_size <= max_size);
+	VTBH__CHECK(avg_size >= 64);
+
+	int bits = 0;
+	while (((size_t)2 << bits) <= avg_size)
+		bits++;
+
+	vtb_chunker c;
+	c.hash = 0;
+	c.mask_small = ~(uint64_t)0 << (64 - (bits + 2));
+	c.mask_large = ~(uint64_t)0 << (64 - (bits - 2));
+	c.length = 0;
+	c.skip_size = min_size > 64 ? min_size - 64 : 0;
+	c.min_size = min_size;
+	c.avg_size = (size_t)1 << bits;
+	c.max_size = max_size;
+
+	return c;
+}
+
+VTBHDEF int vtbh_chunker_byte(vtb_chunker* c, unsigned char byte)
+{
+	c->length++;
+
+	// Bytes before the last 64 of min_size can't affect any boundary.
+	if (c->length <= c->skip_size)
+		return 0;
+
+	c->hash = (c->hash << 1) + vtbh__gear[byte];
+
+	if (c->length < c->min_size)
+		return 0;
+
+	uint64_t mask = c->length < c->avg_size ? c->mask_small : c->mask_large;
+
+	if (!(c->hash & mask) || c->length >= c->max_size)
+	{
+		c->hash = 0;
+		c->length = 0;
+		return 1;
+	}
+
+	return 0;
+}
+
+VTBHDEF size_t vtbh_chunker_next(vtb_chunker* c, const unsigned char* bytes, size_t num_bytes)
+{
+	size_t length = c->length;
+	size_t k = 0;
+
+	if (length < c->skip_size)
+	{
+		size_t skip = c->skip_size - length;
+		if (skip >= num_bytes)
+		{
+			c->length = length + num_bytes;
+			return 0;
+		}
+
+		k = skip;
+		length += skip;
+	}
+
+	uint64_t hash = c->hash;
+
+	// One loop per mask, so the inner loops are just the shift, add and
+	// test. Each region ends at the chunk length where the next one starts.
+	size_t region_ends[3] = { c->min_size - 1, c->avg_size - 1, c->max_size - 1 };
+	uint64_t masks[3] = { 0, c->mask_small, c->mask_large };
+
+	for (int r = 0; r < 3; r++)
+	{
+		if (length >= region_ends[r])
+			continue;
+
+		size_t count = region_ends[r] - length;
+		if (count > num_bytes - k)
+			count = num_bytes - k;
+
+		size_t end = k + count;
+		uint64_t mask = masks[r];
+
+		if (!mask)
+		{
+			for (; k < end; k++)
+				hash = (hash << 1) + vtbh__gear[bytes[k]];
+		}
+		else
+		{
+			for (; k < end; k++)
+			{
+				hash = (hash << 1) + vtbh__gear[bytes[k]];
+
+				if (!(hash & mask))
+				{
+					c->hash = 0;
+					c->length = 0;
+					return k + 1;
+				}
+			}
+		}
+
+		length += count;
+
+		if (k == num_bytes)
+		{
+			c->hash = hash;
+			c->length = length;
+			return 0;
+		}
+	}
+
+	// Already max_size - 1 bytes long coming in, with nothing to feed.
+	if (k == num_bytes)
+	{
+		c->hash = hash;
+		c->length = length;
+		return 0;
+	}
+
+	// The chunk is max_size - 1 bytes long, the next byte ends it.
+	c->hash = 0;
+	c->length = 0;
+	return k + 1;
+}
+
+// Polynomials are evaluated in the field of integers modulo the Mersenne
+// prime 2^61-1, where reducing is just shifts and adds.
+#define VTBH__CHASH_PRIME 0x1FFFFFFFFFFFFFFFull
+#define VTBH__CHASH_BASE 0x016A09E667F3BCC9ull
+
+static uint64_t vtbh__chash_reduce(uint64_t x)
+{
+	x = (x & VTBH__CHASH_PRIME) + (x >> 61);
+	return x >= VTBH__CHASH_PRIME ? x - VTBH__CHASH_PRIME : x;
+}
+
+// a and b must be less than 2^61-1.
+static uint64_t vtbh__chash_mul(uint64_t a, uint64_t b)
+{
+#ifdef __SIZEOF_INT128__
+	unsigned __int128 x = (unsigned __int128)a * b;
+	return vtbh__chash_reduce(((uint64_t)x & VTBH__CHASH_PRIME) + (uint64_t)(x >> 61));
+#else
+	// 2^64 = 8 and 2^61 = 1 modulo 2^61-1.
+	uint64_t a0 = a & 0xFFFFFFFF, a1 = a >> 32;
+	uint64_t b0 = b & 0xFFFFFFFF, b1 = b >> 32;
+
+	uint64_t low = a0 * b0;
+	uint64_t middle = a0 * b1 + a1 * b0;
+	uint64_t high = a1 * b1;
+
+	uint64_t sum = high * 8 + (middle >> 29) + ((middle & 0x1FFFFFFF) << 32) + (low & VTBH__CHASH_PRIME) + (low >> 61);
+	return vtbh__chash_reduce(sum);
+#endif
+}
+
+static uint64_t vtbh__chash_pow(uint64_t exponent)
+{
+	uint64_t result = 1;
+	uint64_t base = VTBH__CHASH_BASE;
+
+	while (exponent)
+	{
+		if (exponent & 1)
+			result = vtbh__chash_mul(result, base);
+
+		base = vtbh__chash_mul(base, base);
+		exponent >>= 1;
+	}
+
+	return result;
+}
+
+VTBHDEF vtb_chash vtbh_chash_new()
+{
+	vtb_chash c;
+
+	c.value = 0;
+	c.length = 0;
+
+	return c;
+}
+
+// value = sum of (byte+1) * BASE^(bytes after it). The +1 is so that zero
+// bytes still change the value.
+VTBHDEF void vtbh_chash_bytes(vtb_chash* c, const unsigned char* bytes, size_t num_bytes)
+{
+	uint64_t value = c->value;
+	size_t k = 0;
+
+#ifdef __SIZEOF_INT128__
+	// Eight bytes at a time: the products are independent and only the sum
+	// needs reducing. It's less than 2^123, so nothing overflows. These are
+	// BASE^8 down to BASE^0.
+	static const uint64_t powers[9] =
+	{
+		0x1FB4F9E3DA987C12ull,
+		0x1885B90D426DA605ull,
+		0x1DF59BC28CBAD3F0ull,
+		0x07C6557E84D8C200ull,
+		0x00E12EE299D32CACull,
+		0x169BE6CA05CC79A4ull,
+		0x1FF76525AECDD5D0ull,
+		0x016A09E667F3BCC9ull,
+		0x0000000000000001ull,
+	};
+
+	for (; k + 8 <= num_bytes; k += 8)
+	{
+		unsigned __int128 x = (unsigned __int128)value * powers[0];
+
+		for (int j = 0; j < 8; j++)
+			x += (unsigned __int128)(bytes[k + j] + 1) * powers[j + 1];
+
+		value = vtbh__chash_reduce(((uint64_t)x & VTBH__CHASH_PRIME) + ((uint64_t)(x >> 61) & VTBH__CHASH_PRIME) + (uint64_t)(x >> 122));
+	}
+#endif
+
+	for (; k < num_bytes; k++)
+		value = vtbh__chash_reduce(vtbh__chash_mul(value, VTBH__CHASH_BASE) + bytes[k] + 1);
+
+	c->value = value;
+	c->length += num_bytes;
+}
+
+VTBHDEF vtb_chash vtbh_combine(vtb_chash a, vtb_chash b)
+{
+	vtb_chash c;
+
+	c.value = vtbh__chash_reduce(vtbh__chash_mul(a.value, vtbh__chash_pow(b.length)) + b.value);
+	c.length = a.length + b.length;
+
+	return c;
+}
+
+VTBHDEF uint64_t vtbh_chash_digest(vtb_chash c)
+{
+	// The finalizer from MurmurHash3. The constant keeps the empty hash from
+	// being 0.
+	uint64_t x = c.value ^ (c.length * 0x9E3779B97F4A7C15ull) ^ 0x2545F4914F6CDD1Dull;
+
+	x ^= x >> 33;
+	x *= 0xFF51AFD7ED558CCDull;
+	x ^= x >> 33;
+	x *= 0xC4CEB9FE1A85EC53ull;
+	x ^= x >> 33;
+
+	return x;
+}
+
+
+// CRC-32C is computed on the bit-reflected polynomial, with the state
+// inverted before and after. Internally these work on the raw state.
+#define VTBH__CRC32C_POLY 0x82F63B78u
+
+// vtbh__crc32c_table[0] is the usual byte at a time table, and [k] is [0]
+// followed by k zero bytes, for slice-by-8.
+static const uint32_t vtbh__crc32c_table[8][256] =
+{
+	{
+		0x00000000, 0xF26B8303, 0xE13B70F7, 0x1350F3F4, 0xC79A971F, 0x35F1141C, 0x26A1E7E8, 0xD4CA64EB,
+		0x8AD958CF, 0x78B2DBCC, 0x6BE22838, 0x9989AB3B, 0x4D43CFD0, 0xBF284CD3, 0xAC78BF27, 0x5E133C24,
+		0x105EC76F, 0xE235446C, 0xF165B798, 0x030E349B, 0xD7C45070, 0x25AFD373, 0x36FF2087, 0xC494A384,
+		0x9A879FA0, 0x68EC1CA3, 0x7BBCEF57, 0x89D76C54, 0x5D1D08BF, 0xAF768BBC, 0xBC267848, 0x4E4DFB4B,
+		0x20BD8EDE, 0xD2D60DDD, 0xC186FE29, 0x33ED7D2A, 0xE72719C1, 0x154C9AC2, 0x061C6936, 0xF477EA35,
+		0xAA64D611, 0x580F5512, 0x4B5FA6E6, 0xB93425E5, 0x6DFE410E, 0x9F95C20D, 0x8CC531F9, 0x7EAEB2FA,
+		0x30E349B1, 0xC288CAB2, 0xD1D83946, 0x23B3BA45, 0xF779DEAE, 0x05125DAD, 0x1642AE59, 0xE4292D5A,
+		0xBA3A117E, 0x4851927D, 0x5B016189, 0xA96AE28A, 0x7DA08661, 0x8FCB0562, 0x9C9BF696, 0x6EF07595,
+		0x417B1DBC, 0xB3109EBF, 0xA0406D4B, 0x522BEE48, 0x86E18AA3, 0x748A09A0, 0x67DAFA54, 0x95B17957,
+		0xCBA24573, 0x39C9C670, 0x2A993584, 0xD8F2B687, 0x0C38D26C, 0xFE53516F, 0xED03A29B, 0x1F682198,
+		0x5125DAD3, 0xA34E59D0, 0xB01EAA24, 0x42752927, 0x96BF4DCC, 0x64D4CECF, 0x77843D3B, 0x85EFBE38,
+		0xDBFC821C, 0x2997011F, 0x3AC7F2EB, 0xC8AC71E8, 0x1C661503, 0xEE0D9600, 0xFD5D65F4, 0x0F36E6F7,
+		0x61C69362, 0x93AD1061, 0x80FDE395, 0x72966096, 0xA65C047D, 0x5437877E, 0x4767748A, 0xB50CF789,
+		0xEB1FCBAD, 0x197448AE, 0x0A24BB5A, 0xF84F3859, 0x2C855CB2, 0xDEEEDFB1, 0xCDBE2C45, 0x3FD5AF46,
+		0x7198540D, 0x83F3D70E, 0x90A324FA, 0x62C8A7F9, 0xB602C312, 0x44694011, 0x5739B3E5, 0xA55230E6,
+		0xFB410CC2, 0x092A8FC1, 0x1A7A7C35, 0xE811FF36, 0x3CDB9BDD, 0xCEB018DE, 0xDDE0EB2A, 0x2F8B6829,
+		0x82F63B78, 0x709DB87B, 0x63CD4B8F, 0x91A6C88C, 0x456CAC67, 0xB7072F64, 0xA457DC90, 0x563C5F93,
+		0x082F63B7, 0xFA44E0B4, 0xE9141340, 0x1B7F9043, 0xCFB5F4A8, 0x3DDE77AB, 0x2E8E845F, 0xDCE5075C,
+		0x92A8FC17, 0x60C37F14, 0x73938CE0, 0x81F80FE3, 0x55326B08, 0xA759E80B, 0xB4091BFF, 0x466298FC,
+		0x1871A4D8, 0xEA1A27DB, 0xF94AD42F, 0x0B21572C, 0xDFEB33C7, 0x2D80B0C4, 0x3ED04330, 0xCCBBC033,
+		0xA24BB5A6, 0x502036A5, 0x4370C551, 0xB11B4652, 0x65D122B9, 0x97BAA1BA, 0x84EA524E, 0x7681D14D,
+		0x2892ED69, 0xDAF96E6A, 0xC9A99D9E, 0x3BC21E9D, 0xEF087A76, 0x1D63F975, 0x0E330A81, 0xFC588982,
+		0xB21572C9, 0x407EF1CA, 0x532E023E, 0xA145813D, 0x758FE5D6, 0x87E466D5, 0x94B49521, 0x66DF1622,
+		0x38CC2A06, 0xCAA7A905, 0xD9F75AF1, 0x2B9CD9F2, 0xFF56BD19, 0x0D3D3E1A, 0x1E6DCDEE, 0xEC064EED,
+		0xC38D26C4, 0x31E6A5C7, 0x22B65633, 0xD0DDD530, 0x0417B1DB, 0xF67C32D8, 0xE52CC12C, 0x1747422F,
+		0x49547E0B, 0xBB3FFD08, 0xA86F0EFC, 0x5A048DFF, 0x8ECEE914, 0x7CA56A17, 0x6FF599E3, 0x9D9E1AE0,
+		0xD3D3E1AB, 0x21B862A8, 0x32E8915C, 0xC083125F, 0x144976B4, 0xE622F5B7, 0xF5720643, 0x07198540,
+		0x590AB964, 0xAB613A67, 0xB831C993, 0x4A5A4A90, 0x9E902E7B, 0x6CFBAD78, 0x7FAB5E8C, 0x8DC0DD8F,
+		0xE330A81A, 0x115B2B19, 0x020BD8ED, 0xF0605BEE, 0x24AA3F05, 0xD6C1BC06, 0xC5914FF2, 0x37FACCF1,
+		0x69E9F0D5, 0x9B8273D6, 0x88D28022, 0x7AB90321, 0xAE7367CA, 0x5C18E4C9, 0x4F48173D, 0xBD23943E,
+		0xF36E6F75, 0x0105EC76, 0x12551F82, 0xE03E9C81, 0x34F4F86A, 0xC69F7B69, 0xD5CF889D, 0x27A40B9E,
+		0x79B737BA, 0x8BDCB4B9, 0x988C474D, 0x6AE7C44E, 0xBE2DA0A5, 0x4C4623A6, 0x5F16D052, 0xAD7D5351,
+	},
+	{
+		0x00000000, 0x13A29877, 0x274530EE, 0x34E7A899, 0x4E8A61DC, 0x5D28F9AB, 0x69CF5132, 0x7A6DC945,
+		0x9D14C3B8, 0x8EB65BCF, 0xBA51F356, 0xA9F36B21, 0xD39EA264, 0xC03C3A13, 0xF4DB928A, 0xE7790AFD,
+		0x3FC5F181, 0x2C6769F6, 0x1880C16F, 0x0B225918, 0x714F905D, 0x62ED082A, 0x560AA0B3, 0x45A838C4,
+		0xA2D13239, 0xB173AA4E, 0x859402D7, 0x96369AA0, 0xEC5B53E5, 0xFFF9CB92, 0xCB1E630B, 0xD8BCFB7C,
+		0x7F8BE302, 0x6C297B75, 0x58CED3EC, 0x4B6C4B9B, 0x310182DE, 0x22A31AA9, 0x1644B230, 0x05E62A47,
+		0xE29F20BA, 0xF13DB8CD, 0xC5DA1054, 0xD6788823, 0xAC154166, 0xBFB7D911, 0x8B507188, 0x98F2E9FF,
+		0x404E1283, 0x53EC8AF4, 0x670B226D, 0x74A9BA1A, 0x0EC4735F, 0x1D66EB28, 0x298143B1, 0x3A23DBC6,
+		0xDD5AD13B, 0xCEF8494C, 0xFA1FE1D5, 0xE9BD79A2, 0x93D0B0E7, 0x80722890, 0xB4958009, 0xA737187E,
+		0xFF17C604, 0xECB55E73, 0xD852F6EA, 0xCBF06E9D, 0xB19DA7D8, 0xA23F3FAF, 0x96D89736, 0x857A0F41,
+		0x620305BC, 0x71A19DCB, 0x45463552, 0x56E4AD25, 0x2C896460, 0x3F2BFC17, 0x0BCC548E, 0x186ECCF9,
+		0xC0D23785, 0xD370AFF2, 0xE797076B, 0xF4359F1C, 0x8E585659, 0x9DFACE2E, 0xA91D66B7, 0xBABFFEC0,
+		0x5DC6F43D, 0x4E646C4A, 0x7A83C4D3, 0x69215CA4, 0x134C95E1, 0x00EE0D96, 0x3409A50F, 0x27AB3D78,
+		0x809C2506, 0x933EBD71, 0xA7D915E8, 0xB47B8D9F, 0xCE1644DA, 0xDDB4DCAD, 0xE9537434, 0xFAF1EC43,
+		0x1D88E6BE, 0x0E2A7EC9, 0x3ACDD650, 0x296F4E27, 0x53028762, 0x40A01F15, 0x7447B78C, 0x67E52FFB,
+		0xBF59D487, 0xACFB4CF0, 0x981CE469, 0x8BBE7C1E, 0xF1D3B55B, 0xE2712D2C, 0xD69685B5, 0xC5341DC2,
+		0x224D173F, 0x31EF8F48, 0x050827D1, 0x16AABFA6, 0x6CC776E3, 0x7F65EE94, 0x4B82460D, 0x5820DE7A,
+		0xFBC3FAF9, 0xE861628E, 0xDC86CA17, 0xCF245260, 0xB5499B25, 0xA6EB0352, 0x920CABCB, 0x81AE33BC,
+		0x66D73941, 0x7575A136, 0x419209AF, 0x523091D8, 0x285D589D, 0x3BFFC0EA, 0x0F186873, 0x1CBAF004,
+		0xC4060B78, 0xD7A4930F, 0xE3433B96, 0xF0E1A3E1, 0x8A8C6AA4, 0x992EF2D3, 0xADC95A4A, 0xBE6BC23D,
+		0x5912C8C0, 0x4AB050B7, 0x7E57F82E, 0x6DF56059, 0x1798A91C, 0x043A316B, 0x30DD99F2, 0x237F0185,
+		0x844819FB, 0x97EA818C, 0xA30D2915, 0xB0AFB162, 0xCAC27827, 0xD960E050, 0xED8748C9, 0xFE25D0BE,
+		0x195CDA43, 0x0AFE4234, 0x3E19EAAD, 0x2DBB72DA, 0x57D6BB9F, 0x447423E8, 0x70938B71, 0x63311306,
+		0xBB8DE87A, 0xA82F700D, 0x9CC8D894, 0x8F6A40E3, 0xF50789A6, 0xE6A511D1, 0xD242B948, 0xC1E0213F,
+		0x26992BC2, 0x353BB3B5, 0x01DC1B2C, 0x127E835B, 0x68134A1E, 0x7BB1D269, 0x4F567AF0, 0x5CF4E287,
+		0x04D43CFD, 0x1776A48A, 0x23910C13, 0x30339464, 0x4A5E5D21, 0x59FCC556, 0x6D1B6DCF, 0x7EB9F5B8,
+		0x99C0FF45, 0x8A626732, 0xBE85CFAB, 0xAD2757DC, 0xD74A9E99, 0xC4E806EE, 0xF00FAE77, 0xE3AD3600,
+		0x3B11CD7C, 0x28B3550B, 0x1C54FD92, 0x0FF665E5, 0x759BACA0, 0x663934D7, 0x52DE9C4E, 0x417C0439,
+		0xA6050EC4, 0xB5A796B3, 0x81403E2A, 0x92E2A65D, 0xE88F6F18, 0xFB2DF76F, 0xCFCA5FF6, 0xDC68C781,
+		0x7B5FDFFF, 0x68FD4788, 0x5C1AEF11, 0x4FB87766, 0x35D5BE23, 0x26772654, 0x12908ECD, 0x013216BA,
+		0xE64B1C47, 0xF5E98430, 0xC10E2CA9, 0xD2ACB4DE, 0xA8C17D9B, 0xBB63E5EC, 0x8F844D75, 0x9C26D502,
+		0x449A2E7E, 0x5738B609, 0x63DF1E90, 0x707D86E7, 0x0A104FA2, 0x19B2D7D5, 0x2D557F4C, 0x3EF7E73B,
+		0xD98EEDC6, 0xCA2C75B1, 0xFECBDD28, 0xED69455F, 0x97048C1A, 0x84A6146D, 0xB041BCF4, 0xA3E32483,
+	},
+	{
+		0x00000000, 0xA541927E, 0x4F6F520D, 0xEA2EC073, 0x9EDEA41A, 0x3B9F3664, 0xD1B1F617, 0x74F06469,
+		0x38513EC5, 0x9D10ACBB, 0x773E6CC8, 0xD27FFEB6, 0xA68F9ADF, 0x03CE08A1, 0xE9E0C8D2, 0x4CA15AAC,
+		0x70A27D8A, 0xD5E3EFF4, 0x3FCD2F87, 0x9A8CBDF9, 0xEE7CD990, 0x4B3D4BEE, 0xA1138B9D, 0x045219E3,
+		0x48F3434F, 0xEDB2D131, 0x079C1142, 0xA2DD833C, 0xD62DE755, 0x736C752B, 0x9942B558, 0x3C032726,
+		0xE144FB14, 0x4405696A, 0xAE2BA919, 0x0B6A3B67, 0x7F9A5F0E, 0xDADBCD70, 0x30F50D03, 0x95B49F7D,
+		0xD915C5D1, 0x7C5457AF, 0x967A97DC, 0x333B05A2, 0x47CB61CB, 0xE28AF3B5, 0x08A433C6, 0xADE5A1B8,
+		0x91E6869E, 0x34A714E0, 0xDE89D493, 0x7BC846ED, 0x0F382284, 0xAA79B0FA, 0x40577089, 0xE516E2F7,
+		0xA9B7B85B, 0x0CF62A25, 0xE6D8EA56, 0x43997828, 0x37691C41, 0x92288E3F, 0x78064E4C, 0xDD47DC32,
+		0xC76580D9, 0x622412A7, 0x880AD2D4, 0x2D4B40AA, 0x59BB24C3, 0xFCFAB6BD, 0x16D476CE, 0xB395E4B0,
+		0xFF34BE1C, 0x5A752C62, 0xB05BEC11, 0x151A7E6F, 0x61EA1A06, 0xC4AB8878, 0x2E85480B, 0x8BC4DA75,
+		0xB7C7FD53, 0x12866F2D, 0xF8A8AF5E, 0x5DE93D20, 0x29195949, 0x8C58CB37, 0x66760B44, 0xC337993A,
+		0x8F96C396, 0x2AD751E8, 0xC0F9919B, 0x65B803E5, 0x1148678C, 0xB409F5F2, 0x5E273581, 0xFB66A7FF,
+		0x26217BCD, 0x8360E9B3, 0x694E29C0, 0xCC0FBBBE, 0xB8FFDFD7, 0x1DBE4DA9, 0xF7908DDA, 0x52D11FA4,
+		0x1E704508, 0xBB31D776, 0x511F1705, 0xF45E857B, 0x80AEE112, 0x25EF736C, 0xCFC1B31F, 0x6A802161,
+		0x56830647, 0xF3C29439, 0x19EC544A, 0xBCADC634, 0xC85DA25D, 0x6D1C3023, 0x8732F050, 0x2273622E,
+		0x6ED23882, 0xCB93AAFC, 0x21BD6A8F, 0x84FCF8F1, 0xF00C9C98, 0x554D0EE6, 0xBF63CE95, 0x1A225CEB,
+		0x8B277743, 0x2E66E53D, 0xC448254E, 0x6109B730, 0x15F9D359, 0xB0B84127, 0x5A968154, 0xFFD7132A,
+		0xB3764986, 0x1637DBF8, 0xFC191B8B, 0x595889F5, 0x2DA8ED9C, 0x88E97FE2, 0x62C7BF91, 0xC7862DEF,
+		0xFB850AC9, 0x5EC498B7, 0xB4EA58C4, 0x11ABCABA, 0x655BAED3, 0xC01A3CAD, 0x2A34FCDE, 0x8F756EA0,
+		0xC3D4340C, 0x6695A672, 0x8CBB6601, 0x29FAF47F, 0x5D0A9016, 0xF84B0268, 0x1265C21B, 0xB7245065,
+		0x6A638C57, 0xCF221E29, 0x250CDE5A, 0x804D4C24, 0xF4BD284D, 0x51FCBA33, 0xBBD27A40, 0x1E93E83E,
+		0x5232B292, 0xF77320EC, 0x1D5DE09F, 0xB81C72E1, 0xCCEC1688, 0x69AD84F6, 0x83834485, 0x26C2D6FB,
+		0x1AC1F1DD, 0xBF8063A3, 0x55AEA3D0, 0xF0EF31AE, 0x841F55C7, 0x215EC7B9, 0xCB7007CA, 0x6E3195B4,
+		0x2290CF18, 0x87D15D66, 0x6DFF9D15, 0xC8BE0F6B, 0xBC4E6B02, 0x190FF97C, 0xF321390F, 0x5660AB71,
+		0x4C42F79A, 0xE90365E4, 0x032DA597, 0xA66C37E9, 0xD29C5380, 0x77DDC1FE, 0x9DF3018D, 0x38B293F3,
+		0x7413C95F, 0xD1525B21, 0x3B7C9B52, 0x9E3D092C, 0xEACD6D45, 0x4F8CFF3B, 0xA5A23F48, 0x00E3AD36,
+		0x3CE08A10, 0x99A1186E, 0x738FD81D, 0xD6CE4A63, 0xA23E2E0A, 0x077FBC74, 0xED517C07, 0x4810EE79,
+		0x04B1B4D5, 0xA1F026AB, 0x4BDEE6D8, 0xEE9F74A6, 0x9A6F10CF, 0x3F2E82B1, 0xD50042C2, 0x7041D0BC,
+		0xAD060C8E, 0x08479EF0, 0xE2695E83, 0x4728CCFD, 0x33D8A894, 0x96993AEA, 0x7CB7FA99, 0xD9F668E7,
+		0x9557324B, 0x3016A035, 0xDA386046, 0x7F79F238, 0x0B899651, 0xAEC8042F, 0x44E6C45C, 0xE1A75622,
+		0xDDA47104, 0x78E5E37A, 0x92CB2309, 0x378AB177, 0x437AD51E, 0xE63B4760, 0x0C158713, 0xA954156D,
+		0xE5F54FC1, 0x40B4DDBF, 0xAA9A1DCC, 0x0FDB8FB2, 0x7B2BEBDB, 0xDE6A79A5, 0x3444B9D6, 0x91052BA8,
+	},
+	{
+		0x00000000, 0xDD45AAB8, 0xBF672381, 0x62228939, 0x7B2231F3, 0xA6679B4B, 0xC4451272, 0x1900B8CA,
+		0xF64463E6, 0x2B01C95E, 0x49234067, 0x9466EADF, 0x8D665215, 0x5023F8AD, 0x32017194, 0xEF44DB2C,
+		0xE964B13D, 0x34211B85, 0x560392BC, 0x8B463804, 0x924680CE, 0x4F032A76, 0x2D21A34F, 0xF06409F7,
+		0x1F20D2DB, 0xC2657863, 0xA047F15A, 0x7D025BE2, 0x6402E328, 0xB9474990, 0xDB65C0A9, 0x06206A11,
+		0xD725148B, 0x0A60BE33, 0x6842370A, 0xB5079DB2, 0xAC072578, 0x71428FC0, 0x136006F9, 0xCE25AC41,
+		0x2161776D, 0xFC24DDD5, 0x9E0654EC, 0x4343FE54, 0x5A43469E, 0x8706EC26, 0xE524651F, 0x3861CFA7,
+		0x3E41A5B6, 0xE3040F0E, 0x81268637, 0x5C632C8F, 0x45639445, 0x98263EFD, 0xFA04B7C4, 0x27411D7C,
+		0xC805C650, 0x15406CE8, 0x7762E5D1, 0xAA274F69, 0xB327F7A3, 0x6E625D1B, 0x0C40D422, 0xD1057E9A,
+		0xABA65FE7, 0x76E3F55F, 0x14C17C66, 0xC984D6DE, 0xD0846E14, 0x0DC1C4AC, 0x6FE34D95, 0xB2A6E72D,
+		0x5DE23C01, 0x80A796B9, 0xE2851F80, 0x3FC0B538, 0x26C00DF2, 0xFB85A74A, 0x99A72E73, 0x44E284CB,
+		0x42C2EEDA, 0x9F874462, 0xFDA5CD5B, 0x20E067E3, 0x39E0DF29, 0xE4A57591, 0x8687FCA8, 0x5BC25610,
+		0xB4868D3C, 0x69C32784, 0x0BE1AEBD, 0xD6A40405, 0xCFA4BCCF, 0x12E11677, 0x70C39F4E, 0xAD8635F6,
+		0x7C834B6C, 0xA1C6E1D4, 0xC3E468ED, 0x1EA1C255, 0x07A17A9F, 0xDAE4D027, 0xB8C6591E, 0x6583F3A6,
+		0x8AC7288A, 0x57828232, 0x35A00B0B, 0xE8E5A1B3, 0xF1E51979, 0x2CA0B3C1, 0x4E823AF8, 0x93C79040,
+		0x95E7FA51, 0x48A250E9, 0x2A80D9D0, 0xF7C57368, 0xEEC5CBA2, 0x3380611A, 0x51A2E823, 0x8CE7429B,
+		0x63A399B7, 0xBEE6330F, 0xDCC4BA36, 0x0181108E, 0x1881A844, 0xC5C402FC, 0xA7E68BC5, 0x7AA3217D,
+		0x52A0C93F, 0x8FE56387, 0xEDC7EABE, 0x30824006, 0x2982F8CC, 0xF4C75274, 0x96E5DB4D, 0x4BA071F5,
+		0xA4E4AAD9, 0x79A10061, 0x1B838958, 0xC6C623E0, 0xDFC69B2A, 0x02833192, 0x60A1B8AB, 0xBDE41213,
+		0xBBC47802, 0x6681D2BA, 0x04A35B83, 0xD9E6F13B, 0xC0E649F1, 0x1DA3E349, 0x7F816A70, 0xA2C4C0C8,
+		0x4D801BE4, 0x90C5B15C, 0xF2E73865, 0x2FA292DD, 0x36A22A17, 0xEBE780AF, 0x89C50996, 0x5480A32E,
+		0x8585DDB4, 0x58C0770C, 0x3AE2FE35, 0xE7A7548D, 0xFEA7EC47, 0x23E246FF, 0x41C0CFC6, 0x9C85657E,
+		0x73C1BE52, 0xAE8414EA, 0xCCA69DD3, 0x11E3376B, 0x08E38FA1, 0xD5A62519, 0xB784AC20, 0x6AC10698,
+		0x6CE16C89, 0xB1A4C631, 0xD3864F08, 0x0EC3E5B0, 0x17C35D7A, 0xCA86F7C2, 0xA8A47EFB, 0x75E1D443,
+		0x9AA50F6F, 0x47E0A5D7, 0x25C22CEE, 0xF8878656, 0xE1873E9C, 0x3CC29424, 0x5EE01D1D, 0x83A5B7A5,
+		0xF90696D8, 0x24433C60, 0x4661B559, 0x9B241FE1, 0x8224A72B, 0x5F610D93, 0x3D4384AA, 0xE0062E12,
+		0x0F42F53E, 0xD2075F86, 0xB025D6BF, 0x6D607C07, 0x7460C4CD, 0xA9256E75, 0xCB07E74C, 0x16424DF4,
+		0x106227E5, 0xCD278D5D, 0xAF050464, 0x7240AEDC, 0x6B401616, 0xB605BCAE, 0xD4273597, 0x09629F2F,
+		0xE6264403, 0x3B63EEBB, 0x59416782, 0x8404CD3A, 0x9D0475F0, 0x4041DF48, 0x22635671, 0xFF26FCC9,
+		0x2E238253, 0xF36628EB, 0x9144A1D2, 0x4C010B6A, 0x5501B3A0, 0x88441918, 0xEA669021, 0x37233A99,
+		0xD867E1B5, 0x05224B0D, 0x6700C234, 0xBA45688C, 0xA345D046, 0x7E007AFE, 0x1C22F3C7, 0xC167597F,
+		0xC747336E, 0x1A0299D6, 0x782010EF, 0xA565BA57, 0xBC65029D, 0x6120A825, 0x0302211C, 0xDE478BA4,
+		0x31035088, 0xEC46FA30, 0x8E647309, 0x5321D9B1, 0x4A21617B, 0x9764CBC3, 0xF54642FA, 0x2803E842,
+	},
+	{
+		0x00000000, 0x38116FAC, 0x7022DF58, 0x4833B0F4, 0xE045BEB0, 0xD854D11C, 0x906761E8, 0xA8760E44,
+		0xC5670B91, 0xFD76643D, 0xB545D4C9, 0x8D54BB65, 0x2522B521, 0x1D33DA8D, 0x55006A79, 0x6D1105D5,
+		0x8F2261D3, 0xB7330E7F, 0xFF00BE8B, 0xC711D127, 0x6F67DF63, 0x5776B0CF, 0x1F45003B, 0x27546F97,
+		0x4A456A42, 0x725405EE, 0x3A67B51A, 0x0276DAB6, 0xAA00D4F2, 0x9211BB5E, 0xDA220BAA, 0xE2336406,
+		0x1BA8B557, 0x23B9DAFB, 0x6B8A6A0F, 0x539B05A3, 0xFBED0BE7, 0xC3FC644B, 0x8BCFD4BF, 0xB3DEBB13,
+		0xDECFBEC6, 0xE6DED16A, 0xAEED619E, 0x96FC0E32, 0x3E8A0076, 0x069B6FDA, 0x4EA8DF2E, 0x76B9B082,
+		0x948AD484, 0xAC9BBB28, 0xE4A80BDC, 0xDCB96470, 0x74CF6A34, 0x4CDE0598, 0x04EDB56C, 0x3CFCDAC0,
+		0x51EDDF15, 0x69FCB0B9, 0x21CF004D, 0x19DE6FE1, 0xB1A861A5, 0x89B90E09, 0xC18ABEFD, 0xF99BD151,
+		0x37516AAE, 0x0F400502, 0x4773B5F6, 0x7F62DA5A, 0xD714D41E, 0xEF05BBB2, 0xA7360B46, 0x9F2764EA,
+		0xF236613F, 0xCA270E93, 0x8214BE67, 0xBA05D1CB, 0x1273DF8F, 0x2A62B023, 0x625100D7, 0x5A406F7B,
+		0xB8730B7D, 0x806264D1, 0xC851D425, 0xF040BB89, 0x5836B5CD, 0x6027DA61, 0x28146A95, 0x10050539,
+		0x7D1400EC, 0x45056F40, 0x0D36DFB4, 0x3527B018, 0x9D51BE5C, 0xA540D1F0, 0xED736104, 0xD5620EA8,
+		0x2CF9DFF9, 0x14E8B055, 0x5CDB00A1, 0x64CA6F0D, 0xCCBC6149, 0xF4AD0EE5, 0xBC9EBE11, 0x848FD1BD,
+		0xE99ED468, 0xD18FBBC4, 0x99BC0B30, 0xA1AD649C, 0x09DB6AD8, 0x31CA0574, 0x79F9B580, 0x41E8DA2C,
+		0xA3DBBE2A, 0x9BCAD186, 0xD3F96172, 0xEBE80EDE, 0x439E009A, 0x7B8F6F36, 0x33BCDFC2, 0x0BADB06E,
+		0x66BCB5BB, 0x5EADDA17, 0x169E6AE3, 0x2E8F054F, 0x86F90B0B, 0xBEE864A7, 0xF6DBD453, 0xCECABBFF,
+		0x6EA2D55C, 0x56B3BAF0, 0x1E800A04, 0x269165A8, 0x8EE76BEC, 0xB6F60440, 0xFEC5B4B4, 0xC6D4DB18,
+		0xABC5DECD, 0x93D4B161, 0xDBE70195, 0xE3F66E39, 0x4B80607D, 0x73910FD1, 0x3BA2BF25, 0x03B3D089,
+		0xE180B48F, 0xD991DB23, 0x91A26BD7, 0xA9B3047B, 0x01C50A3F, 0x39D46593, 0x71E7D567, 0x49F6BACB,
+		0x24E7BF1E, 0x1CF6D0B2, 0x54C56046, 0x6CD40FEA, 0xC4A201AE, 0xFCB36E02, 0xB480DEF6, 0x8C91B15A,
+		0x750A600B, 0x4D1B0FA7, 0x0528BF53, 0x3D39D0FF, 0x954FDEBB, 0xAD5EB117, 0xE56D01E3, 0xDD7C6E4F,
+		0xB06D6B9A, 0x887C0436, 0xC04FB4C2, 0xF85EDB6E, 0x5028D52A, 0x6839BA86, 0x200A0A72, 0x181B65DE,
+		0xFA2801D8, 0xC2396E74, 0x8A0ADE80, 0xB21BB12C, 0x1A6DBF68, 0x227CD0C4, 0x6A4F6030, 0x525E0F9C,
+		0x3F4F0A49, 0x075E65E5, 0x4F6DD511, 0x777CBABD, 0xDF0AB4F9, 0xE71BDB55, 0xAF286BA1, 0x9739040D,
+		0x59F3BFF2, 0x61E2D05E, 0x29D160AA, 0x11C00F06, 0xB9B60142, 0x81A76EEE, 0xC994DE1A, 0xF185B1B6,
+		0x9C94B463, 0xA485DBCF, 0xECB66B3B, 0xD4A70497, 0x7CD10AD3, 0x44C0657F, 0x0CF3D58B, 0x34E2BA27,
+		0xD6D1DE21, 0xEEC0B18D, 0xA6F30179, 0x9EE26ED5, 0x36946091, 0x0E850F3D, 0x46B6BFC9, 0x7EA7D065,
+		0x13B6D5B0, 0x2BA7BA1C, 0x63940AE8, 0x5B856544, 0xF3F36B00, 0xCBE204AC, 0x83D1B458, 0xBBC0DBF4,
+		0x425B0AA5, 0x7A4A6509, 0x3279D5FD, 0x0A68BA51, 0xA21EB415, 0x9A0FDBB9, 0xD23C6B4D, 0xEA2D04E1,
+		0x873C0134, 0xBF2D6E98, 0xF71EDE6C, 0xCF0FB1C0, 0x6779BF84, 0x5F68D028, 0x175B60DC, 0x2F4A0F70,
+		0xCD796B76, 0xF56804DA, 0xBD5BB42E, 0x854ADB82, 0x2D3CD5C6, 0x152DBA6A, 0x5D1E0A9E, 0x650F6532,
+		0x081E60E7, 0x300F0F4B, 0x783CBFBF, 0x402DD013, 0xE85BDE57, 0xD04AB1FB, 0x9879010F, 0xA0686EA3,
+	},
+	{
+		0x00000000, 0xEF306B19, 0xDB8CA0C3, 0x34BCCBDA, 0xB2F53777, 0x5DC55C6E, 0x697997B4, 0x8649FCAD,
+		0x6006181F, 0x8F367306, 0xBB8AB8DC, 0x54BAD3C5, 0xD2F32F68, 0x3DC34471, 0x097F8FAB, 0xE64FE4B2,
+		0xC00C303E, 0x2F3C5B27, 0x1B8090FD, 0xF4B0FBE4, 0x72F90749, 0x9DC96C50, 0xA975A78A, 0x4645CC93,
+		0xA00A2821, 0x4F3A4338, 0x7B8688E2, 0x94B6E3FB, 0x12FF1F56, 0xFDCF744F, 0xC973BF95, 0x2643D48C,
+		0x85F4168D, 0x6AC47D94, 0x5E78B64E, 0xB148DD57, 0x370121FA, 0xD8314AE3, 0xEC8D8139, 0x03BDEA20,
+		0xE5F20E92, 0x0AC2658B, 0x3E7EAE51, 0xD14EC548, 0x570739E5, 0xB83752FC, 0x8C8B9926, 0x63BBF23F,
+		0x45F826B3, 0xAAC84DAA, 0x9E748670, 0x7144ED69, 0xF70D11C4, 0x183D7ADD, 0x2C81B107, 0xC3B1DA1E,
+		0x25FE3EAC, 0xCACE55B5, 0xFE729E6F, 0x1142F576, 0x970B09DB, 0x783B62C2, 0x4C87A918, 0xA3B7C201,
+		0x0E045BEB, 0xE13430F2, 0xD588FB28, 0x3AB89031, 0xBCF16C9C, 0x53C10785, 0x677DCC5F, 0x884DA746,
+		0x6E0243F4, 0x813228ED, 0xB58EE337, 0x5ABE882E, 0xDCF77483, 0x33C71F9A, 0x077BD440, 0xE84BBF59,
+		0xCE086BD5, 0x213800CC, 0x1584CB16, 0xFAB4A00F, 0x7CFD5CA2, 0x93CD37BB, 0xA771FC61, 0x48419778,
+		0xAE0E73CA, 0x413E18D3, 0x7582D309, 0x9AB2B810, 0x1CFB44BD, 0xF3CB2FA4, 0xC777E47E, 0x28478F67,
+		0x8BF04D66, 0x64C0267F, 0x507CEDA5, 0xBF4C86BC, 0x39057A11, 0xD6351108, 0xE289DAD2, 0x0DB9B1CB,
+		0xEBF65579, 0x04C63E60, 0x307AF5BA, 0xDF4A9EA3, 0x5903620E, 0xB6330917, 0x828FC2CD, 0x6DBFA9D4,
+		0x4BFC7D58, 0xA4CC1641, 0x9070DD9B, 0x7F40B682, 0xF9094A2F, 0x16392136, 0x2285EAEC, 0xCDB581F5,
+		0x2BFA6547, 0xC4CA0E5E, 0xF076C584, 0x1F46AE9D, 0x990F5230, 0x763F3929, 0x4283F2F3, 0xADB399EA,
+		0x1C08B7D6, 0xF338DCCF, 0xC7841715, 0x28B47C0C, 0xAEFD80A1, 0x41CDEBB8, 0x75712062, 0x9A414B7B,
+		0x7C0EAFC9, 0x933EC4D0, 0xA7820F0A, 0x48B26413, 0xCEFB98BE, 0x21CBF3A7, 0x1577387D, 0xFA475364,
+		0xDC0487E8, 0x3334ECF1, 0x0788272B, 0xE8B84C32, 0x6EF1B09F, 0x81C1DB86, 0xB57D105C, 0x5A4D7B45,
+		0xBC029FF7, 0x5332F4EE, 0x678E3F34, 0x88BE542D, 0x0EF7A880, 0xE1C7C399, 0xD57B0843, 0x3A4B635A,
+		0x99FCA15B, 0x76CCCA42, 0x42700198, 0xAD406A81, 0x2B09962C, 0xC439FD35, 0xF08536EF, 0x1FB55DF6,
+		0xF9FAB944, 0x16CAD25D, 0x22761987, 0xCD46729E, 0x4B0F8E33, 0xA43FE52A, 0x90832EF0, 0x7FB345E9,
+		0x59F09165, 0xB6C0FA7C, 0x827C31A6, 0x6D4C5ABF, 0xEB05A612, 0x0435CD0B, 0x308906D1, 0xDFB96DC8,
+		0x39F6897A, 0xD6C6E263, 0xE27A29B9, 0x0D4A42A0, 0x8B03BE0D, 0x6433D514, 0x508F1ECE, 0xBFBF75D7,
+		0x120CEC3D, 0xFD3C8724, 0xC9804CFE, 0x26B027E7, 0xA0F9DB4A, 0x4FC9B053, 0x7B757B89, 0x94451090,
+		0x720AF422, 0x9D3A9F3B, 0xA98654E1, 0x46B63FF8, 0xC0FFC355, 0x2FCFA84C, 0x1B736396, 0xF443088F,
+		0xD200DC03, 0x3D30B71A, 0x098C7CC0, 0xE6BC17D9, 0x60F5EB74, 0x8FC5806D, 0xBB794BB7, 0x544920AE,
+		0xB206C41C, 0x5D36AF05, 0x698A64DF, 0x86BA0FC6, 0x00F3F36B, 0xEFC39872, 0xDB7F53A8, 0x344F38B1,
+		0x97F8FAB0, 0x78C891A9, 0x4C745A73, 0xA344316A, 0x250DCDC7, 0xCA3DA6DE, 0xFE816D04, 0x11B1061D,
+		0xF7FEE2AF, 0x18CE89B6, 0x2C72426C, 0xC3422975, 0x450BD5D8, 0xAA3BBEC1, 0x9E87751B, 0x71B71E02,
+		0x57F4CA8E, 0xB8C4A197, 0x8C786A4D, 0x63480154, 0xE501FDF9, 0x0A3196E0, 0x3E8D5D3A, 0xD1BD3623,
+		0x37F2D291, 0xD8C2B988, 0xEC7E7252, 0x034E194B, 0x8507E5E6, 0x6A378EFF, 0x5E8B4525, 0xB1BB2E3C,
+	},
+	{
+		0x00000000, 0x68032CC8, 0xD0065990, 0xB8057558, 0xA5E0C5D1, 0xCDE3E919, 0x75E69C41, 0x1DE5B089,
+		0x4E2DFD53, 0x262ED19B, 0x9E2BA4C3, 0xF628880B, 0xEBCD3882, 0x83CE144A, 0x3BCB6112, 0x53C84DDA,
+		0x9C5BFAA6, 0xF458D66E, 0x4C5DA336, 0x245E8FFE, 0x39BB3F77, 0x51B813BF, 0xE9BD66E7, 0x81BE4A2F,
+		0xD27607F5, 0xBA752B3D, 0x02705E65, 0x6A7372AD, 0x7796C224, 0x1F95EEEC, 0xA7909BB4, 0xCF93B77C,
+		0x3D5B83BD, 0x5558AF75, 0xED5DDA2D, 0x855EF6E5, 0x98BB466C, 0xF0B86AA4, 0x48BD1FFC, 0x20BE3334,
+		0x73767EEE, 0x1B755226, 0xA370277E, 0xCB730BB6, 0xD696BB3F, 0xBE9597F7, 0x0690E2AF, 0x6E93CE67,
+		0xA100791B, 0xC90355D3, 0x7106208B, 0x19050C43, 0x04E0BCCA, 0x6CE39002, 0xD4E6E55A, 0xBCE5C992,
+		0xEF2D8448, 0x872EA880, 0x3F2BDDD8, 0x5728F110, 0x4ACD4199, 0x22CE6D51, 0x9ACB1809, 0xF2C834C1,
+		0x7AB7077A, 0x12B42BB2, 0xAAB15EEA, 0xC2B27222, 0xDF57C2AB, 0xB754EE63, 0x0F519B3B, 0x6752B7F3,
+		0x349AFA29, 0x5C99D6E1, 0xE49CA3B9, 0x8C9F8F71, 0x917A3FF8, 0xF9791330, 0x417C6668, 0x297F4AA0,
+		0xE6ECFDDC, 0x8EEFD114, 0x36EAA44C, 0x5EE98884, 0x430C380D, 0x2B0F14C5, 0x930A619D, 0xFB094D55,
+		0xA8C1008F, 0xC0C22C47, 0x78C7591F, 0x10C475D7, 0x0D21C55E, 0x6522E996, 0xDD279CCE, 0xB524B006,
+		0x47EC84C7, 0x2FEFA80F, 0x97EADD57, 0xFFE9F19F, 0xE20C4116, 0x8A0F6DDE, 0x320A1886, 0x5A09344E,
+		0x09C17994, 0x61C2555C, 0xD9C72004, 0xB1C40CCC, 0xAC21BC45, 0xC422908D, 0x7C27E5D5, 0x1424C91D,
+		0xDBB77E61, 0xB3B452A9, 0x0BB127F1, 0x63B20B39, 0x7E57BBB0, 0x16549778, 0xAE51E220, 0xC652CEE8,
+		0x959A8332, 0xFD99AFFA, 0x459CDAA2, 0x2D9FF66A, 0x307A46E3, 0x58796A2B, 0xE07C1F73, 0x887F33BB,
+		0xF56E0EF4, 0x9D6D223C, 0x25685764, 0x4D6B7BAC, 0x508ECB25, 0x388DE7ED, 0x808892B5, 0xE88BBE7D,
+		0xBB43F3A7, 0xD340DF6F, 0x6B45AA37, 0x034686FF, 0x1EA33676, 0x76A01ABE, 0xCEA56FE6, 0xA6A6432E,
+		0x6935F452, 0x0136D89A, 0xB933ADC2, 0xD130810A, 0xCCD53183, 0xA4D61D4B, 0x1CD36813, 0x74D044DB,
+		0x27180901, 0x4F1B25C9, 0xF71E5091, 0x9F1D7C59, 0x82F8CCD0, 0xEAFBE018, 0x52FE9540, 0x3AFDB988,
+		0xC8358D49, 0xA036A181, 0x1833D4D9, 0x7030F811, 0x6DD54898, 0x05D66450, 0xBDD31108, 0xD5D03DC0,
+		0x8618701A, 0xEE1B5CD2, 0x561E298A, 0x3E1D0542, 0x23F8B5CB, 0x4BFB9903, 0xF3FEEC5B, 0x9BFDC093,
+		0x546E77EF, 0x3C6D5B27, 0x84682E7F, 0xEC6B02B7, 0xF18EB23E, 0x998D9EF6, 0x2188EBAE, 0x498BC766,
+		0x1A438ABC, 0x7240A674, 0xCA45D32C, 0xA246FFE4, 0xBFA34F6D, 0xD7A063A5, 0x6FA516FD, 0x07A63A35,
+		0x8FD9098E, 0xE7DA2546, 0x5FDF501E, 0x37DC7CD6, 0x2A39CC5F, 0x423AE097, 0xFA3F95CF, 0x923CB907,
+		0xC1F4F4DD, 0xA9F7D815, 0x11F2AD4D, 0x79F18185, 0x6414310C, 0x0C171DC4, 0xB412689C, 0xDC114454,
+		0x1382F328, 0x7B81DFE0, 0xC384AAB8, 0xAB878670, 0xB66236F9, 0xDE611A31, 0x66646F69, 0x0E6743A1,
+		0x5DAF0E7B, 0x35AC22B3, 0x8DA957EB, 0xE5AA7B23, 0xF84FCBAA, 0x904CE762, 0x2849923A, 0x404ABEF2,
+		0xB2828A33, 0xDA81A6FB, 0x6284D3A3, 0x0A87FF6B, 0x17624FE2, 0x7F61632A, 0xC7641672, 0xAF673ABA,
+		0xFCAF7760, 0x94AC5BA8, 0x2CA92EF0, 0x44AA0238, 0x594FB2B1, 0x314C9E79, 0x8949EB21, 0xE14AC7E9,
+		0x2ED97095, 0x46DA5C5D, 0xFEDF2905, 0x96DC05CD, 0x8B39B544, 0xE33A998C, 0x5B3FECD4, 0x333CC01C,
+		0x60F48DC6, 0x08F7A10E, 0xB0F2D456, 0xD8F1F89E, 0xC5144817, 0xAD1764DF, 0x15121187, 0x7D113D4F,
+	},
+	{
+		0x00000000, 0x493C7D27, 0x9278FA4E, 0xDB448769, 0x211D826D, 0x6821FF4A, 0xB3657823, 0xFA590504,
+		0x423B04DA, 0x0B0779FD, 0xD043FE94, 0x997F83B3, 0x632686B7, 0x2A1AFB90, 0xF15E7CF9, 0xB86201DE,
+		0x847609B4, 0xCD4A7493, 0x160EF3FA, 0x5F328EDD, 0xA56B8BD9, 0xEC57F6FE, 0x37137197, 0x7E2F0CB0,
+		0xC64D0D6E, 0x8F717049, 0x5435F720, 0x1D098A07, 0xE7508F03, 0xAE6CF224, 0x7528754D, 0x3C14086A,
+		0x0D006599, 0x443C18BE, 0x9F789FD7, 0xD644E2F0, 0x2C1DE7F4, 0x65219AD3, 0xBE651DBA, 0xF759609D,
+		0x4F3B6143, 0x06071C64, 0xDD439B0D, 0x947FE62A, 0x6E26E32E, 0x271A9E09, 0xFC5E1960, 0xB5626447,
+		0x89766C2D, 0xC04A110A, 0x1B0E9663, 0x5232EB44, 0xA86BEE40, 0xE1579367, 0x3A13140E, 0x732F6929,
+		0xCB4D68F7, 0x827115D0, 0x593592B9, 0x1009EF9E, 0xEA50EA9A, 0xA36C97BD, 0x782810D4, 0x31146DF3,
+		0x1A00CB32, 0x533CB615, 0x8878317C, 0xC1444C5B, 0x3B1D495F, 0x72213478, 0xA965B311, 0xE059CE36,
+		0x583BCFE8, 0x1107B2CF, 0xCA4335A6, 0x837F4881, 0x79264D85, 0x301A30A2, 0xEB5EB7CB, 0xA262CAEC,
+		0x9E76C286, 0xD74ABFA1, 0x0C0E38C8, 0x453245EF, 0xBF6B40EB, 0xF6573DCC, 0x2D13BAA5, 0x642FC782,
+		0xDC4DC65C, 0x9571BB7B, 0x4E353C12, 0x07094135, 0xFD504431, 0xB46C3916, 0x6F28BE7F, 0x2614C358,
+		0x1700AEAB, 0x5E3CD38C, 0x857854E5, 0xCC4429C2, 0x361D2CC6, 0x7F2151E1, 0xA465D688, 0xED59ABAF,
+		0x553BAA71, 0x1C07D756, 0xC743503F, 0x8E7F2D18, 0x7426281C, 0x3D1A553B, 0xE65ED252, 0xAF62AF75,
+		0x9376A71F, 0xDA4ADA38, 0x010E5D51, 0x48322076, 0xB26B2572, 0xFB575855, 0x2013DF3C, 0x692FA21B,
+		0xD14DA3C5, 0x9871DEE2, 0x4335598B, 0x0A0924AC, 0xF05021A8, 0xB96C5C8F, 0x6228DBE6, 0x2B14A6C1,
+		0x34019664, 0x7D3DEB43, 0xA6796C2A, 0xEF45110D, 0x151C1409, 0x5C20692E, 0x8764EE47, 0xCE589360,
+		0x763A92BE, 0x3F06EF99, 0xE44268F0, 0xAD7E15D7, 0x572710D3, 0x1E1B6DF4, 0xC55FEA9D, 0x8C6397BA,
+		0xB0779FD0, 0xF94BE2F7, 0x220F659E, 0x6B3318B9, 0x916A1DBD, 0xD856609A, 0x0312E7F3, 0x4A2E9AD4,
+		0xF24C9B0A, 0xBB70E62D, 0x60346144, 0x29081C63, 0xD3511967, 0x9A6D6440, 0x4129E329, 0x08159E0E,
+		0x3901F3FD, 0x703D8EDA, 0xAB7909B3, 0xE2457494, 0x181C7190, 0x51200CB7, 0x8A648BDE, 0xC358F6F9,
+		0x7B3AF727, 0x32068A00, 0xE9420D69, 0xA07E704E, 0x5A27754A, 0x131B086D, 0xC85F8F04, 0x8163F223,
+		0xBD77FA49, 0xF44B876E, 0x2F0F0007, 0x66337D20, 0x9C6A7824, 0xD5560503, 0x0E12826A, 0x472EFF4D,
+		0xFF4CFE93, 0xB67083B4, 0x6D3404DD, 0x240879FA, 0xDE517CFE, 0x976D01D9, 0x4C2986B0, 0x0515FB97,
+		0x2E015D56, 0x673D2071, 0xBC79A718, 0xF545DA3F, 0x0F1CDF3B, 0x4620A21C, 0x9D642575, 0xD4585852,
+		0x6C3A598C, 0x250624AB, 0xFE42A3C2, 0xB77EDEE5, 0x4D27DBE1, 0x041BA6C6, 0xDF5F21AF, 0x96635C88,
+		0xAA7754E2, 0xE34B29C5, 0x380FAEAC, 0x7133D38B, 0x8B6AD68F, 0xC256ABA8, 0x19122CC1, 0x502E51E6,
+		0xE84C5038, 0xA1702D1F, 0x7A34AA76, 0x3308D751, 0xC951D255, 0x806DAF72, 0x5B29281B, 0x1215553C,
+		0x230138CF, 0x6A3D45E8, 0xB179C281, 0xF845BFA6, 0x021CBAA2, 0x4B20C785, 0x906440EC, 0xD9583DCB,
+		0x613A3C15, 0x28064132, 0xF342C65B, 0xBA7EBB7C, 0x4027BE78, 0x091BC35F, 0xD25F4436, 0x9B633911,
+		0xA777317B, 0xEE4B4C5C, 0x350FCB35, 0x7C33B612, 0x866AB316, 0xCF56CE31, 0x14124958, 0x5D2E347F,
+		0xE54C35A1, 0xAC704886, 0x7734CFEF, 0x3E08B2C8, 0xC451B7CC, 0x8D6DCAEB, 0x56294D82, 0x1F1530A5,
+	},
+};
+
+static uint32_t vtbh__crc32c_table_bytes(uint32_t crc, const unsigned char* bytes, size_t num_bytes)
+{
+	for (; num_bytes >= 8; bytes += 8, num_bytes -= 8)
+	{
+		uint32_t low = crc ^ (bytes[0] | (bytes[1] << 8) | (bytes[2] << 16) | ((uint32_t)bytes[3] << 24));
+		uint32_t high = bytes[4] | (bytes[5] << 8) | (bytes[6] << 16) | ((uint32_t)bytes[7] << 24);
+
+		crc = vtbh__crc32c_table[7][low & 0xFF] ^ vtbh__crc32c_table[6][(low >> 8) & 0xFF] ^
+			vtbh__crc32c_table[5][(low >> 16) & 0xFF] ^ vtbh__crc32c_table[4][low >> 24] ^
+			vtbh__crc32c_table[3][high & 0xFF] ^ vtbh__crc32c_table[2][(high >> 8) & 0xFF] ^
+			vtbh__crc32c_table[1][(high >> 16) & 0xFF] ^ vtbh__crc32c_table[0][high >> 24];
+	}
+
+	for (; num_bytes; bytes++, num_bytes--)
+		crc = vtbh__crc32c_table[0][(crc ^ *bytes) & 0xFF] ^ (crc >> 8);
+
+	return crc;
+}
+
+// a*b modulo the polynomial, in the reflected representation where x^0 is
+// 0x80000000.
+static uint32_t vtbh__crc32c_multiply(uint32_t a, uint32_t b)
+{
+	uint32_t product = 0;
+
+	for (uint32_t m = 0x80000000u; m; m >>= 1)
+	{
+		if (a & m)
+			product ^= b;
+
+		b = b & 1 ? (b >> 1) ^ VTBH__CRC32C_POLY : b >> 1;
+	}
+
+	return product;
+}
+
+// x^(8*num_bytes) modulo the polynomial. Multiplying a raw state by this
+// is the same as running num_bytes zeros through it.
+static uint32_t vtbh__crc32c_zeros(uint64_t num_bytes)
+{
+	uint32_t result = 0x80000000u;
+	uint32_t power = 0x00800000u; // x^8
+
+	while (num_bytes)
+	{
+		if (num_bytes & 1)
+			result = vtbh__crc32c_multiply(result, power);
+
+		power = vtbh__crc32c_multiply(power, power);
+		num_bytes >>= 1;
+	}
+
+	return result;
+}
+
+#if !defined(VTBH_NO_SIMD) && defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <nmmintrin.h>
+#include <wmmintrin.h>
+#define VTBH__CRC32C_HARDWARE
+#define VTBH__CRC32C_TARGET __attribute__((target("sse4.2")))
+#define VTBH__CRC32C_U64(crc, word) _mm_crc32_u64(crc, word)
+#define VTBH__CRC32C_U8(crc, byte) _mm_crc32_u8(crc, byte)
+#elif !defined(VTBH_NO_SIMD) && defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#define VTBH__CRC32C_HARDWARE
+#define VTBH__CRC32C_TARGET
+#define VTBH__CRC32C_U64(crc, word) __crc32cd(crc, word)
+#define VTBH__CRC32C_U8(crc, byte) __crc32cb(crc, byte)
+#endif
+
+#ifdef VTBH__CRC32C_HARDWARE
+
+#ifdef __x86_64__
+// Shifts crc by a fixed number of zero bytes with one carry-less multiply.
+// constant is x^(8*num_bytes - 33): the multiply adds a factor of x, and
+// the crc32 of the 64-bit product adds x^32 and reduces.
+__attribute__((target("sse4.2,pclmul"))) static uint32_t vtbh__crc32c_shift_clmul(uint32_t crc, uint32_t constant)
+{
+	__m128i product = _mm_clmulepi64_si128(_mm_cvtsi32_si128((int)crc), _mm_cvtsi32_si128((int)constant), 0);
+	return (uint32_t)_mm_crc32_u64(0, (uint64_t)_mm_cvtsi128_si64(product));
+}
+#endif
+
+// The crc32 instruction has a latency of 3 but can start one every cycle,
+// so big buffers are split into three blocks that are run at the same time
+// and then shifted into place and combined.
+VTBH__CRC32C_TARGET static uint32_t vtbh__crc32c_hardware_bytes(uint32_t crc, const unsigned char* bytes, size_t num_bytes, int has_clmul)
+{
+	static const size_t block_sizes[2] = { 8192, 256 };
+
+	// Shifts by one and two blocks: x^(8*bytes - 33) for the carry-less
+	// multiply, and x^(8*bytes) for vtbh__crc32c_multiply.
+	static const uint32_t clmul_shifts[2][2] = { { 0x54A86326, 0x1DC403CC }, { 0xB9E02B86, 0xDD7E3B0C } };
+	static const uint32_t shifts[2][2] = { { 0x28461564, 0xBF455269 }, { 0x88E56F72, 0x74C360A4 } };
+
+	(void)has_clmul;
+	(void)clmul_shifts;
+
+	for (int b = 0; b < 2; b++)
+	{
+		size_t block_size = block_sizes[b];
+
+		while (num_bytes >= block_size*3)
+		{
+			uint64_t crc0 = crc;
+			uint64_t crc1 = 0;
+			uint64_t crc2 = 0;
+
+			for (size_t k = 0; k < block_size; k += 8)
+			{
+				uint64_t word0, word1, word2;
+				memcpy(&word0, bytes + k, sizeof(word0));
+				memcpy(&word1, bytes + block_size + k, sizeof(word1));
+				memcpy(&word2, bytes + block_size*2 + k, sizeof(word2));
+
+				crc0 = VTBH__CRC32C_U64(crc0, word0);
+				crc1 = VTBH__CRC32C_U64(crc1, word1);
+				crc2 = VTBH__CRC32C_U64(crc2, word2);
+			}
+
+#ifdef __x86_64__
+			if (has_clmul)
+				crc = vtbh__crc32c_shift_clmul((uint32_t)crc0, clmul_shifts[b][1]) ^ vtbh__crc32c_shift_clmul((uint32_t)crc1, clmul_shifts[b][0]) ^ (uint32_t)crc2;
+			else
+#endif
+				crc = vtbh__crc32c_multiply(shifts[b][1], (uint32_t)crc0) ^ vtbh__crc32c_multiply(shifts[b][0], (uint32_t)crc1) ^ (uint32_t)crc2;
+
+			bytes += block_size*3;
+			num_bytes -= block_size*3;
+		}
+	}
+
+	uint64_t crc64 = crc;
+
+	for (; num_bytes >= 8; bytes += 8, num_bytes -= 8)
+	{
+		uint64_t word;
+		memcpy(&word, bytes, sizeof(word));
+		crc64 = VTBH__CRC32C_U64(crc64, word);
+	}
+
+	crc = (uint32_t)crc64;
+
+	for (; num_bytes; bytes++, num_bytes--)
+		crc = VTBH__CRC32C_U8(crc, *bytes);
+
+	return crc;
+}
+
+#endif
+
+VTBHDEF vtb_crc32c vtbh_crc32c_new()
+{
+	vtb_crc32c c;
+
+	c.crc = 0;
+
+	return c;
+}
+
+VTBHDEF void vtbh_crc32c(vtb_crc32c* c, const unsigned char* bytes, size_t num_bytes)
+{
+	uint32_t crc = ~c->crc;
+
+#if defined(VTBH__CRC32C_HARDWARE) && defined(__x86_64__)
+	if (__builtin_cpu_supports("sse4.2"))
+#ifdef VTBH_CRC32C_NO_CLMUL
+		crc = vtbh__crc32c_hardware_bytes(crc, bytes, num_bytes, 0);
+#else
+		crc = vtbh__crc32c_hardware_bytes(crc, bytes, num_bytes, __builtin_cpu_supports("pclmul"));
+#endif
+	else
+		crc = vtbh__crc32c_table_bytes(crc, bytes, num_bytes);
+#elif defined(VTBH__CRC32C_HARDWARE)
+	crc = vtbh__crc32c_hardware_bytes(crc, bytes, num_bytes, 0);
+#else
+	crc = vtbh__crc32c_table_bytes(crc, bytes, num_bytes);
+#endif
+
+	c->crc = ~crc;
+}
+
+// The inversions cancel out, so this works on finished CRCs: the CRC of
+// A||B is the CRC of A run through len(B) zeros, xor the CRC of B.
+VTBHDEF uint32_t vtbh_crc32c_combine(uint32_t crc_a, uint32_t crc_b, size_t length_b)
+{
+	return vtbh__crc32c_multiply(vtbh__crc32c_zeros(length_b), crc_a) ^ crc_b;
+}
+
 
 #endif
\ No newline at end of file
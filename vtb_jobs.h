@@ -0,0 +1,695 @@
+/*
+vtb_jobs.h - public domain work stealing job system
+
+This software is dual-licensed to the public domain and under the
+following license: you are granted a perpetual, irrevocable license
+to copy, modify, publish, and distribute this file as you see fit.
+
+This is a job scheduler for spreading small pieces of work over every core.
+Each worker thread owns a Chase-Lev deque. A worker pushes and pops jobs on
+its own end of the deque without any locks, and when it runs out it steals
+from the other end of somebody else's. Threads that aren't workers, like
+your main thread, submit into a shared queue and help run jobs while they
+wait.
+
+Waiting is done with counters instead of blocking. A job can spawn child
+jobs against a counter and then wait on it, and while it waits it runs
+other jobs, so no worker ever sits blocked on its children.
+
+Requires C++11.
+
+
+COMPILING AND LINKING
+	You must
+
+	#define VTB_JOBS_IMPLEMENTATION
+
+	in exactly one C++ file that includes this header, before the include
+	like this:
+
+	#define VTB_JOBS_IMPLEMENTATION
+	#include "vtb_jobs.h"
+
+	All other files can be just #include "vtb_jobs.h" without the #define
+
+
+QUICK START
+	vtb_jobs* jobs = vtbj_create(-1); // One worker per core, minus this thread
+
+	vtbj_counter counter;
+	vtbj_run(jobs, hash_asset, &assets[0], &counter);
+	vtbj_run(jobs, hash_asset, &assets[1], &counter);
+	vtbj_wait(jobs, &counter); // Runs jobs until both are done
+
+	// Calls square_range(data, begin, end) over pieces of [0, 100000)
+	vtbj_parallel_for(jobs, 0, 100000, square_range, data, 0);
+
+	vtbj_destroy(jobs);
+
+
+LIMITS
+	Jobs come out of a pool of VTBJ_MAX_JOBS_PER_THREAD per worker, so that
+	submitting doesn't allocate. Threads that aren't workers share one more
+	pool that size, owned by the scheduler, so they can exit while their
+	jobs are still queued. If a pool has more jobs than that in flight at
+	once the extra ones are allocated with new. Each worker deque
+	holds VTBJ_DEQUE_SIZE jobs.
+	If it's full the job is run immediately instead of being queued. Both
+	must be powers of two.
+
+
+ASSERT
+	Define VTBJ_ASSERT(boolval) to override assert() and not use assert.h
+*/
+
+#ifndef VTB__JOBS_H
+#define VTB__JOBS_H
+
+#ifdef VTBJ_STATIC
+#define VTBJDEF static
+#else
+#define VTBJDEF extern
+#endif
+
+#include <stdint.h> // For int64_t
+#include <atomic>
+
+#ifndef VTBJ_MAX_JOBS_PER_THREAD
+#define VTBJ_MAX_JOBS_PER_THREAD 4096
+#endif
+
+#ifndef VTBJ_DEQUE_SIZE
+#define VTBJ_DEQUE_SIZE 4096
+#endif
+
+typedef void (*vtbj_function)(void* data);
+typedef void (*vtbj_range_function)(void* data, int64_t begin, int64_t end);
+
+// Counts jobs that haven't finished yet. vtbj_run increments it, and it's
+// decremented when the job is done.
+struct vtbj_counter
+{
+	vtbj_counter() : m_value(0) {}
+	std::atomic<int32_t> m_value;
+};
+
+struct vtb_jobs;
+
+// Starts num_workers worker threads. Pass -1 to start one fewer than the
+// number of hardware threads, since the thread that waits also runs jobs.
+// With 0 there are no workers and vtbj_wait runs everything itself.
+VTBJDEF vtb_jobs* vtbj_create(int num_workers);
+
+// Stops and joins the workers. Jobs still queued are not run, so wait on
+// your counters first.
+VTBJDEF void vtbj_destroy(vtb_jobs* jobs);
+
+// Returns the number of worker threads.
+VTBJDEF int vtbj_getnumworkers(vtb_jobs* jobs);
+
+// Queues function(data) to be run on some thread. If counter isn't 0 it's
+// incremented now and decremented once the job has returned. Can be called
+// from any thread, including from inside a job.
+VTBJDEF void vtbj_run(vtb_jobs* jobs, vtbj_function function, void* data, vtbj_counter* counter);
+
+// Runs jobs until the counter reaches zero.
+VTBJDEF void vtbj_wait(vtb_jobs* jobs, vtbj_counter* counter);
+
+// Calls function(data, b, e) over disjoint pieces [b, e) that together
+// cover [begin, end), and returns when they are all done. Pieces are split
+// in half recursively, so idle threads steal big pieces first. grain is
+// the largest piece that isn't split further. Pass 0 to pick one from the
+// range length and the number of workers.
+VTBJDEF void vtbj_parallel_for(vtb_jobs* jobs, int64_t begin, int64_t end, vtbj_range_function function, void* data, int64_t grain);
+
+#endif // VTB__JOBS_H
+
+
+
+#ifdef VTB_JOBS_IMPLEMENTATION
+
+#ifndef VTBJ_ASSERT
+#include <assert.h>
+#define VTBJ_ASSERT(x) assert(x)
+#endif
+
+#ifdef VTBJ_DEBUG
+#define VTBJ__ASSERT VTBJ_ASSERT
+#define VTBJ__CHECK VTBJ_ASSERT
+#else
+#define VTBJ__ASSERT(x)
+#define VTBJ__CHECK VTBJ_ASSERT
+#endif
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#if defined(__i386__) || defined(__x86_64__)
+#include <immintrin.h>
+#define VTBJ__PAUSE() _mm_pause()
+#else
+#define VTBJ__PAUSE() std::this_thread::yield()
+#endif
+
+// Spins for a while, then starts giving up the time slice, in case the
+// thread we're waiting on is waiting for this core.
+static void vtbj__backoff(int* spins)
+{
+	if (++*spins < 64)
+		VTBJ__PAUSE();
+	else
+		std::this_thread::yield();
+}
+
+struct vtbj__job
+{
+	void (*m_execute)(vtb_jobs* jobs, vtbj__job* job);
+	vtbj_counter* m_counter;
+	std::atomic<int> m_in_flight; // 0 when this pool entry can be reused.
+	int m_allocated; // 1 if this job came from new rather than a pool.
+
+	vtbj_function m_function;
+	vtbj_range_function m_range_function;
+	void* m_data;
+	int64_t m_begin;
+	int64_t m_end;
+	int64_t m_grain;
+};
+
+// Chase-Lev deque, with the memory orderings from "Correct and Efficient
+// Work-Stealing for Weak Memory Models", Le et al. 2013. The owner pushes
+// and pops at the bottom, thieves take from the top. The padding keeps the
+// owner's and the thieves' indexes on separate cache lines.
+struct vtbj__deque
+{
+	std::atomic<int64_t> m_top;
+	char m_top_padding[64 - sizeof(std::atomic<int64_t>)];
+	std::atomic<int64_t> m_bottom;
+	char m_bottom_padding[64 - sizeof(std::atomic<int64_t>)];
+	std::atomic<vtbj__job*> m_jobs[VTBJ_DEQUE_SIZE];
+};
+
+struct vtb_jobs
+{
+	int m_num_workers;
+	vtbj__deque* m_deques;
+	std::thread* m_threads;
+
+	// Jobs submitted by threads that aren't workers.
+	std::mutex m_shared_mutex;
+	vtbj__job** m_shared_jobs;
+	int64_t m_shared_head;
+	int64_t m_shared_tail;
+	std::atomic<int64_t> m_shared_count;
+	vtbj__job* m_shared_pool;
+	std::atomic<uint32_t> m_shared_pool_next;
+
+	// Idle workers sleep here. m_epoch changes every time work is added, so a
+	// worker that saw the same epoch before and after deciding to sleep knows
+	// it didn't miss anything.
+	std::mutex m_sleep_mutex;
+	std::condition_variable m_sleep_condition;
+	std::atomic<int64_t> m_epoch;
+	std::atomic<int> m_sleepers;
+	std::atomic<int> m_shutdown;
+};
+
+static_assert((VTBJ_DEQUE_SIZE & (VTBJ_DEQUE_SIZE-1)) == 0, "VTBJ_DEQUE_SIZE must be a power of two");
+static_assert((VTBJ_MAX_JOBS_PER_THREAD & (VTBJ_MAX_JOBS_PER_THREAD-1)) == 0, "VTBJ_MAX_JOBS_PER_THREAD must be a power of two");
+
+// Per thread state. Worker threads set m_jobs to the scheduler they belong
+// to and m_worker to their index in it, and get a job pool. Other threads
+// leave m_jobs at 0 and use the scheduler's m_shared_pool.
+struct vtbj__thread
+{
+	vtbj__thread() : m_jobs(0), m_worker(-1), m_random(0), m_pool(0), m_pool_next(0) {}
+	~vtbj__thread() { delete[] m_pool; }
+
+	vtb_jobs* m_jobs;
+	int m_worker;
+	uint32_t m_random;
+
+	vtbj__job* m_pool;
+	uint32_t m_pool_next;
+};
+
+static thread_local vtbj__thread vtbj__this_thread;
+
+static int vtbj__deque_push(vtbj__deque* deque, vtbj__job* job)
+{
+	int64_t bottom = deque->m_bottom.load(std::memory_order_relaxed);
+	int64_t top = deque->m_top.load(std::memory_order_acquire);
+
+	if (bottom - top >= VTBJ_DEQUE_SIZE)
+		return 0;
+
+	deque->m_jobs[bottom & (VTBJ_DEQUE_SIZE-1)].store(job, std::memory_order_relaxed);
+	deque->m_bottom.store(bottom + 1, std::memory_order_release);
+
+	return 1;
+}
+
+static vtbj__job* vtbj__deque_pop(vtbj__deque* deque)
+{
+	int64_t bottom = deque->m_bottom.load(std::memory_order_relaxed) - 1;
+	deque->m_bottom.store(bottom, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	int64_t top = deque->m_top.load(std::memory_order_relaxed);
+
+	if (top > bottom)
+	{
+		deque->m_bottom.store(bottom + 1, std::memory_order_relaxed);
+		return 0;
+	}
+
+	vtbj__job* job = deque->m_jobs[bottom & (VTBJ_DEQUE_SIZE-1)].load(std::memory_order_relaxed);
+
+	if (top == bottom)
+	{
+		// Last job. Race the thieves for it.
+		if (!deque->m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+			job = 0;
+
+		deque->m_bottom.store(bottom + 1, std::memory_order_relaxed);
+	}
+
+	return job;
+}
+
+static vtbj__job* vtbj__deque_steal(vtbj__deque* deque)
+{
+	int64_t top = deque->m_top.load(std::memory_order_acquire);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	int64_t bottom = deque->m_bottom.load(std::memory_order_acquire);
+
+	if (top >= bottom)
+		return 0;
+
+	vtbj__job* job = deque->m_jobs[top & (VTBJ_DEQUE_SIZE-1)].load(std::memory_order_relaxed);
+
+	if (!deque->m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+		return 0;
+
+	return job;
+}
+
+static void vtbj__notify(vtb_jobs* jobs)
+{
+	jobs->m_epoch.fetch_add(1, std::memory_order_seq_cst);
+
+	if (jobs->m_sleepers.load(std::memory_order_seq_cst))
+	{
+		// Taking the lock means a worker can't be between checking the epoch
+		// and starting to wait when we notify.
+		jobs->m_sleep_mutex.lock();
+		jobs->m_sleep_mutex.unlock();
+		jobs->m_sleep_condition.notify_one();
+	}
+}
+
+static vtbj__job* vtbj__new_pool()
+{
+	vtbj__job* pool = new vtbj__job[VTBJ_MAX_JOBS_PER_THREAD];
+	for (int k = 0; k < VTBJ_MAX_JOBS_PER_THREAD; k++)
+	{
+		pool[k].m_in_flight.store(0, std::memory_order_relaxed);
+		pool[k].m_allocated = 0;
+	}
+
+	return pool;
+}
+
+static vtbj__thread* vtbj__get_thread()
+{
+	vtbj__thread* thread = &vtbj__this_thread;
+
+	if (!thread->m_random)
+		thread->m_random = (uint32_t)(size_t)thread | 1;
+
+	return thread;
+}
+
+// Returns the calling thread's deque index in jobs, or -1 if it isn't one of
+// its workers.
+static int vtbj__worker(vtb_jobs* jobs, vtbj__thread* thread)
+{
+	return thread->m_jobs == jobs ? thread->m_worker : -1;
+}
+
+static void vtbj__execute(vtb_jobs* jobs, vtbj__job* job)
+{
+	vtbj_counter* counter = job->m_counter;
+
+	job->m_execute(jobs, job);
+
+	// The job can be reused as soon as this is cleared, so read everything first.
+	if (job->m_allocated)
+		delete job;
+	else
+		job->m_in_flight.store(0, std::memory_order_release);
+
+	if (counter)
+		counter->m_value.fetch_sub(1, std::memory_order_release);
+}
+
+static vtbj__job* vtbj__find_job(vtb_jobs* jobs, vtbj__thread* thread)
+{
+	vtbj__job* job;
+	int worker = vtbj__worker(jobs, thread);
+
+	if (worker >= 0)
+	{
+		job = vtbj__deque_pop(&jobs->m_deques[worker]);
+		if (job)
+			return job;
+	}
+
+	if (jobs->m_shared_count.load(std::memory_order_acquire) > 0)
+	{
+		std::lock_guard<std::mutex> lock(jobs->m_shared_mutex);
+
+		if (jobs->m_shared_head != jobs->m_shared_tail)
+		{
+			// Workers take the oldest job, like a steal. Other threads take the
+			// newest, like popping their own deque, so that the jobs they run
+			// while waiting go depth first and don't nest without bound.
+			if (worker >= 0)
+				job = jobs->m_shared_jobs[jobs->m_shared_tail++ & (VTBJ_DEQUE_SIZE-1)];
+			else
+				job = jobs->m_shared_jobs[--jobs->m_shared_head & (VTBJ_DEQUE_SIZE-1)];
+
+			jobs->m_shared_count.fetch_sub(1, std::memory_order_release);
+			return job;
+		}
+	}
+
+	if (!jobs->m_num_workers)
+		return 0;
+
+	// xorshift32 to pick where to start looking, so thieves spread out.
+	thread->m_random ^= thread->m_random << 13;
+	thread->m_random ^= thread->m_random >> 17;
+	thread->m_random ^= thread->m_random << 5;
+
+	int start = (int)(thread->m_random % (uint32_t)jobs->m_num_workers);
+	for (int k = 0; k < jobs->m_num_workers; k++)
+	{
+		int victim = (start + k) % jobs->m_num_workers;
+		if (victim == worker)
+			continue;
+
+		job = vtbj__deque_steal(&jobs->m_deques[victim]);
+		if (job)
+			return job;
+	}
+
+	return 0;
+}
+
+static int vtbj__run_one(vtb_jobs* jobs, vtbj__thread* thread)
+{
+	vtbj__job* job = vtbj__find_job(jobs, thread);
+	if (!job)
+		return 0;
+
+	vtbj__execute(jobs, job);
+	return 1;
+}
+
+static void vtbj__worker_main(vtb_jobs* jobs, int worker)
+{
+	vtbj__thread* thread = vtbj__get_thread();
+	thread->m_jobs = jobs;
+	thread->m_worker = worker;
+
+	if (!thread->m_pool)
+		thread->m_pool = vtbj__new_pool();
+
+	while (!jobs->m_shutdown.load(std::memory_order_acquire))
+	{
+		int64_t epoch = jobs->m_epoch.load(std::memory_order_seq_cst);
+
+		if (vtbj__run_one(jobs, thread))
+			continue;
+
+		// Spin a little before sleeping, work tends to come in bursts.
+		int found = 0;
+		for (int k = 0; k < 64 && !found; k++)
+		{
+			VTBJ__PAUSE();
+			found = vtbj__run_one(jobs, thread);
+		}
+
+		if (found)
+			continue;
+
+		std::unique_lock<std::mutex> lock(jobs->m_sleep_mutex);
+		jobs->m_sleepers.fetch_add(1, std::memory_order_seq_cst);
+
+		while (jobs->m_epoch.load(std::memory_order_seq_cst) == epoch && !jobs->m_shutdown.load(std::memory_order_acquire))
+			jobs->m_sleep_condition.wait(lock);
+
+		jobs->m_sleepers.fetch_sub(1, std::memory_order_seq_cst);
+	}
+
+	thread->m_jobs = 0;
+}
+
+static vtbj__job* vtbj__allocate_job(vtb_jobs* jobs, vtbj__thread* thread)
+{
+	vtbj__job* job;
+
+	// Anyone else might exit before their jobs run, and take a thread_local
+	// pool with them, so use the scheduler's. Several threads can share it.
+	if (vtbj__worker(jobs, thread) < 0)
+	{
+		uint32_t next = jobs->m_shared_pool_next.fetch_add(1, std::memory_order_relaxed);
+		job = &jobs->m_shared_pool[next & (VTBJ_MAX_JOBS_PER_THREAD-1)];
+
+		int in_flight = 0;
+		if (!job->m_in_flight.compare_exchange_strong(in_flight, 1, std::memory_order_acquire, std::memory_order_relaxed))
+		{
+			job = new vtbj__job;
+			job->m_allocated = 1;
+		}
+
+		return job;
+	}
+
+	job = &thread->m_pool[thread->m_pool_next & (VTBJ_MAX_JOBS_PER_THREAD-1)];
+
+	// Too many jobs in flight. Don't wait for the pool entry, it may belong
+	// to a job further up this thread's own stack.
+	if (job->m_in_flight.load(std::memory_order_acquire))
+	{
+		job = new vtbj__job;
+		job->m_allocated = 1;
+		return job;
+	}
+
+	thread->m_pool_next++;
+
+	job->m_in_flight.store(1, std::memory_order_relaxed);
+	return job;
+}
+
+static void vtbj__submit(vtb_jobs* jobs, vtbj__thread* thread, vtbj__job* job)
+{
+	if (job->m_counter)
+		job->m_counter->m_value.fetch_add(1, std::memory_order_relaxed);
+
+	int worker = vtbj__worker(jobs, thread);
+
+	if (worker >= 0)
+	{
+		if (!vtbj__deque_push(&jobs->m_deques[worker], job))
+		{
+			// Deque is full, just do it now.
+			vtbj__execute(jobs, job);
+			return;
+		}
+	}
+	else
+	{
+		std::unique_lock<std::mutex> lock(jobs->m_shared_mutex);
+
+		if (jobs->m_shared_head - jobs->m_shared_tail >= VTBJ_DEQUE_SIZE)
+		{
+			lock.unlock();
+			vtbj__execute(jobs, job);
+			return;
+		}
+
+		jobs->m_shared_jobs[jobs->m_shared_head++ & (VTBJ_DEQUE_SIZE-1)] = job;
+		jobs->m_shared_count.fetch_add(1, std::memory_order_release);
+	}
+
+	vtbj__notify(jobs);
+}
+
+static void vtbj__execute_function(vtb_jobs* jobs, vtbj__job* job)
+{
+	(void)jobs;
+	job->m_function(job->m_data);
+}
+
+static void vtbj__execute_range(vtb_jobs* jobs, vtbj__job* job)
+{
+	vtbj__thread* thread = vtbj__get_thread();
+
+	int64_t begin = job->m_begin;
+	int64_t end = job->m_end;
+
+	// Split off the top half for somebody else until the piece is small.
+	vtbj_counter children;
+	while (end - begin > job->m_grain)
+	{
+		int64_t middle = begin + (end - begin)/2;
+
+		vtbj__job* child = vtbj__allocate_job(jobs, thread);
+		child->m_execute = vtbj__execute_range;
+		child->m_counter = &children;
+		child->m_range_function = job->m_range_function;
+		child->m_data = job->m_data;
+		child->m_begin = middle;
+		child->m_end = end;
+		child->m_grain = job->m_grain;
+
+		vtbj__submit(jobs, thread, child);
+
+		end = middle;
+	}
+
+	job->m_range_function(job->m_data, begin, end);
+
+	vtbj_wait(jobs, &children);
+}
+
+VTBJDEF vtb_jobs* vtbj_create(int num_workers)
+{
+	VTBJ__CHECK(num_workers >= -1);
+
+	if (num_workers < 0)
+	{
+		num_workers = (int)std::thread::hardware_concurrency() - 1;
+		if (num_workers < 0)
+			num_workers = 0;
+	}
+
+	vtb_jobs* jobs = new vtb_jobs;
+	jobs->m_num_workers = num_workers;
+	jobs->m_deques = new vtbj__deque[num_workers ? num_workers : 1];
+	jobs->m_shared_jobs = new vtbj__job*[VTBJ_DEQUE_SIZE];
+	jobs->m_shared_head = jobs->m_shared_tail = 0;
+	jobs->m_shared_count.store(0, std::memory_order_relaxed);
+	jobs->m_shared_pool = vtbj__new_pool();
+	jobs->m_shared_pool_next.store(0, std::memory_order_relaxed);
+	jobs->m_epoch.store(0, std::memory_order_relaxed);
+	jobs->m_sleepers.store(0, std::memory_order_relaxed);
+	jobs->m_shutdown.store(0, std::memory_order_relaxed);
+
+	for (int k = 0; k < num_workers; k++)
+	{
+		jobs->m_deques[k].m_top.store(0, std::memory_order_relaxed);
+		jobs->m_deques[k].m_bottom.store(0, std::memory_order_relaxed);
+	}
+
+	jobs->m_threads = new std::thread[num_workers ? num_workers : 1];
+	for (int k = 0; k < num_workers; k++)
+		jobs->m_threads[k] = std::thread(vtbj__worker_main, jobs, k);
+
+	return jobs;
+}
+
+VTBJDEF void vtbj_destroy(vtb_jobs* jobs)
+{
+	VTBJ__CHECK(jobs);
+
+	{
+		std::lock_guard<std::mutex> lock(jobs->m_sleep_mutex);
+		jobs->m_shutdown.store(1, std::memory_order_release);
+	}
+	jobs->m_sleep_condition.notify_all();
+
+	for (int k = 0; k < jobs->m_num_workers; k++)
+		jobs->m_threads[k].join();
+
+	delete[] jobs->m_threads;
+	delete[] jobs->m_shared_jobs;
+	delete[] jobs->m_shared_pool;
+	delete[] jobs->m_deques;
+	delete jobs;
+}
+
+VTBJDEF int vtbj_getnumworkers(vtb_jobs* jobs)
+{
+	VTBJ__CHECK(jobs);
+
+	return jobs->m_num_workers;
+}
+
+VTBJDEF void vtbj_run(vtb_jobs* jobs, vtbj_function function, void* data, vtbj_counter* counter)
+{
+	VTBJ__CHECK(jobs);
+	VTBJ__CHECK(function);
+
+	vtbj__thread* thread = vtbj__get_thread();
+
+	vtbj__job* job = vtbj__allocate_job(jobs, thread);
+	job->m_execute = vtbj__execute_function;
+	job->m_counter = counter;
+	job->m_function = function;
+	job->m_data = data;
+
+	vtbj__submit(jobs, thread, job);
+}
+
+VTBJDEF void vtbj_wait(vtb_jobs* jobs, vtbj_counter* counter)
+{
+	VTBJ__CHECK(jobs);
+	VTBJ__CHECK(counter);
+
+	vtbj__thread* thread = vtbj__get_thread();
+
+	int spins = 0;
+	while (counter->m_value.load(std::memory_order_acquire) > 0)
+	{
+		if (vtbj__run_one(jobs, thread))
+			spins = 0;
+		else
+			vtbj__backoff(&spins);
+	}
+}
+
+VTBJDEF void vtbj_parallel_for(vtb_jobs* jobs, int64_t begin, int64_t end, vtbj_range_function function, void* data, int64_t grain)
+{
+	VTBJ__CHECK(jobs);
+	VTBJ__CHECK(function);
+
+	if (end <= begin)
+		return;
+
+	if (grain <= 0)
+	{
+		// About 8 pieces per thread, enough that stealing can even out
+		// uneven pieces without paying for a job per element.
+		int64_t threads = jobs->m_num_workers + 1;
+		grain = (end - begin) / (threads * 8);
+		if (grain < 1)
+			grain = 1;
+	}
+
+	vtbj__job job;
+	job.m_counter = 0;
+	job.m_allocated = 0;
+	job.m_range_function = function;
+	job.m_data = data;
+	job.m_begin = begin;
+	job.m_end = end;
+	job.m_grain = grain;
+
+	vtbj__execute_range(jobs, &job);
+}
+
+#endif
@@ -0,0 +1,821 @@
+/*
+vtb_log.h - public domain asynchronous logger
+
+This software is dual-licensed to the public domain and under the
+following license: you are granted a perpetual, irrevocable license
+to copy, modify, publish, and distribute this file as you see fit.
+
+This is a logger for threads that can't afford to wait on stdio. Logging
+doesn't format anything. It copies the format string pointer, a pointer to
+a function that knows the argument types, and the arguments themselves in
+binary into a ring (vtb_alloc_ring.h) that belongs to the calling thread.
+A background thread wakes up every VTBL_FLUSH_INTERVAL_MS, copies the
+records out of every thread's ring, formats them with snprintf and writes
+them with one writev per ring.
+
+Each ring has a spinlock, but the only other thread that ever takes it is
+the flusher, and only for as long as it takes to memcpy the records out.
+A log call costs a thread_local lookup, the lock, and the copies.
+
+Requires C++11 and POSIX writev. Ring memory comes from vtbar_alloc, so you
+also need to #define VTB_ALLOC_RING_IMPLEMENTATION in one file.
+
+
+COMPILING AND LINKING
+	You must
+
+	#define VTB_LOG_IMPLEMENTATION
+
+	in exactly one C++ file that includes this header, before the include
+	like this:
+
+	#define VTB_LOG_IMPLEMENTATION
+	#include "vtb_log.h"
+
+	All other files can be just #include "vtb_log.h" without the #define
+
+
+QUICK START
+	vtb_log* log = vtbl_create(1); // Writes to stdout
+
+	VTBL_LOG(log, "loaded %s in %.2fms\n", name, ms);
+
+	vtbl_flush(log); // Waits until everything logged so far is written
+
+	vtbl_destroy(log);
+
+
+ARGUMENTS
+	Numbers, enums and pointers are copied as they are. char* and const
+	char* are taken to be strings, and the characters are copied, so they
+	don't have to outlive the call. Anything else fails to compile. The
+	format string itself is not copied, so it has to live until it's
+	written. A string literal is best.
+
+	VTBL_LOG checks the format against the arguments like printf does.
+	vtbl_write is the same without the check.
+
+	Nothing is added to what you log, not even a newline.
+
+
+LIMITS
+	Each thread gets a ring of VTBL_RING_SIZE bytes the first time it logs.
+	When the thread exits, the flusher writes out what's left in its ring
+	and frees it, so threads coming and going don't add up. If a ring is
+	full the record is
+	dropped rather than making the thread wait, and the flusher writes a
+	line saying how many were dropped. So is a record bigger than a quarter
+	of VTBL_RING_SIZE. A record formats to at most
+	VTBL_TEXT_SIZE-1 characters, anything beyond that is cut off.
+
+	Threads must stop logging before vtbl_destroy.
+
+
+VTB_DEBUG_PRINT
+	To send vtb_debug_print from vtb.h, and so VAssert and VStubbed, through
+	a log instead of puts:
+
+	vtbl_setdefault(log);
+	vtb_set_debug_print(vtbl_debug_print, vtbl_debug_flush);
+
+	Failed asserts call vtbl_debug_flush before they break, so their message
+	isn't lost.
+
+
+ASSERT
+	Define VTBL_ASSERT(boolval) to override assert() and not use assert.h
+*/
+
+#ifndef VTB__LOG_H
+#define VTB__LOG_H
+
+#ifdef VTBL_STATIC
+#define VTBLDEF static
+#else
+#define VTBLDEF extern
+#endif
+
+#include <stdint.h> // For int64_t
+#include <stdio.h>  // For snprintf
+#include <string.h> // For memcpy
+#include <type_traits>
+
+#include "vtb_alloc_ring.h"
+
+#ifndef VTBL_RING_SIZE
+#define VTBL_RING_SIZE (64*1024)
+#endif
+
+#ifndef VTBL_TEXT_SIZE
+#define VTBL_TEXT_SIZE (16*1024)
+#endif
+
+#ifndef VTBL_FLUSH_INTERVAL_MS
+#define VTBL_FLUSH_INTERVAL_MS 10
+#endif
+
+struct vtb_log;
+
+// Starts a flusher thread that writes to the file descriptor fd, which
+// stays yours to close after vtbl_destroy.
+VTBLDEF vtb_log* vtbl_create(int fd);
+
+// Writes everything that's left and stops the flusher.
+VTBLDEF void vtbl_destroy(vtb_log* log);
+
+// Returns once everything logged before the call, by any thread, has been
+// written.
+VTBLDEF void vtbl_flush(vtb_log* log);
+
+// Logs text as it is. The characters are copied.
+VTBLDEF void vtbl_print(vtb_log* log, const char* text);
+
+// Logs format and args, to be formatted later by snprintf. Returns false if
+// the thread's ring was full and the record was dropped.
+template <typename... Args>
+bool vtbl_write(vtb_log* log, const char* format, const Args&... args);
+
+// Like vtbl_write, but the compiler checks format against the arguments.
+#define VTBL_LOG(log, ...) ((void)(false && printf(__VA_ARGS__)), vtbl_write(log, __VA_ARGS__))
+
+// Returns the number of records dropped because a ring was full.
+VTBLDEF int64_t vtbl_getnumdropped(vtb_log* log);
+
+// Sets the log that vtbl_debug_print and vtbl_debug_flush use. Pass 0 to
+// clear it.
+VTBLDEF void vtbl_setdefault(vtb_log* log);
+
+// For vtb_set_debug_print. These log to and flush the default log, or go
+// straight to stderr if there isn't one.
+VTBLDEF void vtbl_debug_print(const char* text);
+VTBLDEF void vtbl_debug_flush();
+
+// Everything below is how vtbl_write captures arguments.
+
+struct vtbl__thread;
+
+typedef int (*vtbl__formatter)(char* out, size_t size, const char* format, const uint8_t* args);
+
+// Starts every record in the ring. A formatter of 0 means the record is text
+// from vtbl_print.
+struct vtbl__record
+{
+	vtbl__formatter m_formatter;
+	const char* m_format;
+};
+
+// Locks the calling thread's ring and allocates size bytes in it. Returns 0,
+// unlocked, if it's full. Otherwise call vtbl__end when the record is written.
+VTBLDEF void* vtbl__begin(vtb_log* log, size_t size, vtbl__thread** thread);
+VTBLDEF void vtbl__end(vtbl__thread* thread);
+
+template <typename T, bool Plain = std::is_arithmetic<T>::value || std::is_enum<T>::value || std::is_pointer<T>::value>
+struct vtbl__arg
+{
+	static_assert(Plain, "vtbl_write can only capture numbers, enums, pointers and C strings");
+
+	typedef T type;
+
+	static size_t size(T) { return sizeof(T); }
+
+	static uint8_t* write(uint8_t* p, T value)
+	{
+		memcpy(p, &value, sizeof(T));
+		return p + sizeof(T);
+	}
+
+	static T read(const uint8_t** p)
+	{
+		T value;
+		memcpy(&value, *p, sizeof(T));
+		*p += sizeof(T);
+		return value;
+	}
+};
+
+template <>
+struct vtbl__arg<const char*, true>
+{
+	typedef const char* type;
+
+	static size_t size(const char* value) { return strlen(value ? value : "(null)") + 1; }
+
+	static uint8_t* write(uint8_t* p, const char* value)
+	{
+		if (!value)
+			value = "(null)";
+
+		size_t length = strlen(value) + 1;
+		memcpy(p, value, length);
+		return p + length;
+	}
+
+	static const char* read(const uint8_t** p)
+	{
+		const char* value = (const char*)*p;
+		*p += strlen(value) + 1;
+		return value;
+	}
+};
+
+template <>
+struct vtbl__arg<char*, true> : vtbl__arg<const char*, true>
+{
+};
+
+template <typename... Args>
+struct vtbl__args;
+
+template <>
+struct vtbl__args<>
+{
+	static size_t size() { return 0; }
+
+	static uint8_t* write(uint8_t* p) { return p; }
+
+	// The format comes from the caller, who VTBL_LOG has already checked.
+#ifdef __GNUC__
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wformat-nonliteral"
+#pragma GCC diagnostic ignored "-Wformat-security"
+#endif
+	template <typename... Done>
+	static int format(char* out, size_t out_size, const char* format, const uint8_t*, Done... done)
+	{
+		return snprintf(out, out_size, format, done...);
+	}
+#ifdef __GNUC__
+#pragma GCC diagnostic pop
+#endif
+};
+
+// Reads the arguments back one at a time, appending each to done, then
+// hands them all to snprintf.
+template <typename T, typename... Rest>
+struct vtbl__args<T, Rest...>
+{
+	static size_t size(const T& value, const Rest&... rest)
+	{
+		return vtbl__arg<T>::size(value) + vtbl__args<Rest...>::size(rest...);
+	}
+
+	static uint8_t* write(uint8_t* p, const T& value, const Rest&... rest)
+	{
+		return vtbl__args<Rest...>::write(vtbl__arg<T>::write(p, value), rest...);
+	}
+
+	template <typename... Done>
+	static int format(char* out, size_t out_size, const char* format, const uint8_t* p, Done... done)
+	{
+		typename vtbl__arg<T>::type value = vtbl__arg<T>::read(&p);
+		return vtbl__args<Rest...>::format(out, out_size, format, p, done..., value);
+	}
+};
+
+template <typename... Args>
+int vtbl__format(char* out, size_t size, const char* format, const uint8_t* args)
+{
+	return vtbl__args<Args...>::format(out, size, format, args);
+}
+
+template <typename... Args>
+bool vtbl_write(vtb_log* log, const char* format, const Args&... args)
+{
+	// const so that string literals come through as const char*, not char*.
+	typedef vtbl__args<typename std::decay<const Args>::type...> captured;
+
+	vtbl__thread* thread;
+	uint8_t* p = (uint8_t*)vtbl__begin(log, sizeof(vtbl__record) + captured::size(args...), &thread);
+	if (!p)
+		return false;
+
+	vtbl__record record;
+	record.m_formatter = vtbl__format<typename std::decay<const Args>::type...>;
+	record.m_format = format;
+	memcpy(p, &record, sizeof(record));
+
+	captured::write(p + sizeof(record), args...);
+
+	vtbl__end(thread);
+	return true;
+}
+
+#endif // VTB__LOG_H
+
+
+
+#ifdef VTB_LOG_IMPLEMENTATION
+
+#ifndef VTBL_ASSERT
+#include <assert.h>
+#define VTBL_ASSERT(x) assert(x)
+#endif
+
+#ifdef VTBL_DEBUG
+#define VTBL__ASSERT VTBL_ASSERT
+#define VTBL__CHECK VTBL_ASSERT
+#else
+#define VTBL__ASSERT(x)
+#define VTBL__CHECK VTBL_ASSERT
+#endif
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include <errno.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#if defined(__i386__) || defined(__x86_64__)
+#include <immintrin.h>
+#define VTBL__PAUSE() _mm_pause()
+#else
+#define VTBL__PAUSE() std::this_thread::yield()
+#endif
+
+// Most iovecs passed to one writev.
+#define VTBL__MAX_IOV 64
+
+struct vtbl__thread
+{
+	std::atomic<int> m_lock;
+	vtb_ring_allocator m_ring;
+	std::atomic<bool> m_exited; // Set when the thread exits, so the flusher can free it once it's drained.
+	std::atomic<int> m_refs;    // One for the log and one for the thread. Whichever lets go last deletes it.
+	uint32_t m_log_id;
+	vtbl__thread* m_next;       // In the log's list.
+	vtbl__thread* m_next_owned; // In the thread's list of its rings, one per log.
+};
+
+struct vtb_log
+{
+	int m_fd;
+	uint32_t m_id; // Never reused, so a thread's cached ring can't be mistaken for one from a destroyed log.
+
+	std::atomic<vtbl__thread*> m_threads;
+	std::atomic<int64_t> m_dropped;
+
+	std::thread m_flusher;
+	std::mutex m_mutex;
+	std::condition_variable m_wake;    // The flusher waits on this.
+	std::condition_variable m_flushed; // vtbl_flush waits on this.
+	int64_t m_flush_requested;
+	int64_t m_flush_done;
+	bool m_shutdown;
+
+	// Only the flusher touches these.
+	int64_t m_dropped_reported;
+	uint8_t* m_staging;
+	char* m_text;
+	struct iovec m_iov[VTBL__MAX_IOV];
+	int m_num_iov;
+	size_t m_text_used;
+};
+
+struct vtbl__this_thread_cache
+{
+	uint32_t m_log_id;
+	vtbl__thread* m_thread;
+};
+
+static void vtbl__release(vtbl__thread* thread)
+{
+	if (thread->m_refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+		delete thread;
+}
+
+// Only touched on a cache miss and when the thread exits, so logging
+// doesn't pay for a thread_local with a destructor.
+struct vtbl__thread_exit
+{
+	vtbl__thread* m_owned = nullptr;
+
+	~vtbl__thread_exit()
+	{
+		while (m_owned)
+		{
+			vtbl__thread* next = m_owned->m_next_owned;
+			m_owned->m_exited.store(true, std::memory_order_release);
+			vtbl__release(m_owned);
+			m_owned = next;
+		}
+	}
+};
+
+static std::atomic<uint32_t> vtbl__next_log_id(1);
+static std::atomic<vtb_log*> vtbl__default(nullptr);
+static thread_local vtbl__this_thread_cache vtbl__this_thread;
+static thread_local vtbl__thread_exit vtbl__this_thread_exit;
+
+static void vtbl__lock(vtbl__thread* thread)
+{
+	while (thread->m_lock.exchange(1, std::memory_order_acquire))
+	{
+		while (thread->m_lock.load(std::memory_order_relaxed))
+			VTBL__PAUSE();
+	}
+}
+
+static void vtbl__unlock(vtbl__thread* thread)
+{
+	thread->m_lock.store(0, std::memory_order_release);
+}
+
+static vtbl__thread* vtbl__get_thread(vtb_log* log)
+{
+	vtbl__this_thread_cache* cache = &vtbl__this_thread;
+	if (cache->m_log_id == log->m_id)
+		return cache->m_thread;
+
+	// Look through this thread's own rings, not the log's list, since the
+	// flusher frees from that. Rings that only this thread still holds
+	// belong to logs that were destroyed.
+	vtbl__thread* thread = 0;
+	vtbl__thread** link = &vtbl__this_thread_exit.m_owned;
+	while (*link)
+	{
+		vtbl__thread* owned = *link;
+		if (owned->m_log_id == log->m_id)
+		{
+			thread = owned;
+			break;
+		}
+
+		if (owned->m_refs.load(std::memory_order_acquire) == 1)
+		{
+			*link = owned->m_next_owned;
+			delete owned;
+		}
+		else
+			link = &owned->m_next_owned;
+	}
+
+	if (!thread)
+	{
+		thread = new vtbl__thread;
+		thread->m_lock.store(0, std::memory_order_relaxed);
+		vtbar_initializememory(&thread->m_ring, VTBL_RING_SIZE);
+		thread->m_exited.store(false, std::memory_order_relaxed);
+		thread->m_refs.store(2, std::memory_order_relaxed);
+		thread->m_log_id = log->m_id;
+		thread->m_next_owned = vtbl__this_thread_exit.m_owned;
+		vtbl__this_thread_exit.m_owned = thread;
+
+		vtbl__thread* head = log->m_threads.load(std::memory_order_relaxed);
+		do
+			thread->m_next = head;
+		while (!log->m_threads.compare_exchange_weak(head, thread, std::memory_order_release, std::memory_order_relaxed));
+	}
+
+	cache->m_log_id = log->m_id;
+	cache->m_thread = thread;
+	return thread;
+}
+
+VTBLDEF void* vtbl__begin(vtb_log* log, size_t size, vtbl__thread** thread)
+{
+	VTBL__CHECK(log);
+
+	// Big records would leave too little room for anything else.
+	if (size > VTBL_RING_SIZE/4)
+	{
+		log->m_dropped.fetch_add(1, std::memory_order_relaxed);
+		return 0;
+	}
+
+	*thread = vtbl__get_thread(log);
+	vtbl__lock(*thread);
+
+	void* memory = vtbar_alloc(&(*thread)->m_ring, (int32_t)size);
+	if (!memory)
+	{
+		vtbl__unlock(*thread);
+		log->m_dropped.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	return memory;
+}
+
+VTBLDEF void vtbl__end(vtbl__thread* thread)
+{
+	vtbl__unlock(thread);
+}
+
+static void vtbl__write_all(vtb_log* log)
+{
+	struct iovec* iov = log->m_iov;
+	int count = log->m_num_iov;
+
+	while (count)
+	{
+		ssize_t written = writev(log->m_fd, iov, count);
+		if (written < 0)
+		{
+			if (errno == EINTR)
+				continue;
+			break; // Nowhere to report it, the records are lost.
+		}
+
+		while (count && (size_t)written >= iov->iov_len)
+		{
+			written -= (ssize_t)iov->iov_len;
+			iov++;
+			count--;
+		}
+
+		if (count)
+		{
+			iov->iov_base = (char*)iov->iov_base + written;
+			iov->iov_len -= (size_t)written;
+		}
+	}
+
+	log->m_num_iov = 0;
+	log->m_text_used = 0;
+}
+
+// Queues length bytes at text for the next writev, joining it onto the
+// last iovec if they're adjacent.
+static void vtbl__queue(vtb_log* log, const char* text, size_t length)
+{
+	if (!length)
+		return;
+
+	if (log->m_num_iov)
+	{
+		struct iovec* last = &log->m_iov[log->m_num_iov-1];
+		if ((const char*)last->iov_base + last->iov_len == text)
+		{
+			last->iov_len += length;
+			return;
+		}
+	}
+
+	if (log->m_num_iov == VTBL__MAX_IOV)
+		vtbl__write_all(log);
+
+	log->m_iov[log->m_num_iov].iov_base = (void*)text;
+	log->m_iov[log->m_num_iov].iov_len = length;
+	log->m_num_iov++;
+}
+
+static void vtbl__format_record(vtb_log* log, const vtbl__record* record, const uint8_t* args)
+{
+	// Writing resets m_text, so it can't happen between formatting and queueing.
+	if (log->m_num_iov == VTBL__MAX_IOV)
+		vtbl__write_all(log);
+
+	size_t room = VTBL_TEXT_SIZE - log->m_text_used;
+	int length = record->m_formatter(log->m_text + log->m_text_used, room, record->m_format, args);
+	if (length < 0)
+		return;
+
+	if ((size_t)length >= room && log->m_text_used)
+	{
+		// Didn't fit after what's already there. Write that and start over.
+		vtbl__write_all(log);
+
+		room = VTBL_TEXT_SIZE;
+		length = record->m_formatter(log->m_text, room, record->m_format, args);
+		if (length < 0)
+			return;
+	}
+
+	if ((size_t)length >= room)
+		length = (int)room - 1;
+
+	vtbl__queue(log, log->m_text + log->m_text_used, (size_t)length);
+	log->m_text_used += (size_t)length;
+}
+
+static void vtbl__drain(vtb_log* log)
+{
+	int64_t dropped = log->m_dropped.load(std::memory_order_relaxed);
+	if (dropped != log->m_dropped_reported)
+	{
+		int length = snprintf(log->m_text, VTBL_TEXT_SIZE, "vtb_log: dropped %lld records, the ring was full\n", (long long)(dropped - log->m_dropped_reported));
+		vtbl__queue(log, log->m_text, (size_t)length);
+		log->m_text_used = (size_t)length;
+		log->m_dropped_reported = dropped;
+	}
+
+	vtbl__thread* previous = 0;
+	vtbl__thread* thread = log->m_threads.load(std::memory_order_acquire);
+	while (thread)
+	{
+		// Read first, so that everything it logged before exiting is
+		// drained below.
+		bool exited = thread->m_exited.load(std::memory_order_acquire);
+
+		// Copy the records out so the thread isn't held up while they're
+		// formatted. Each one is its length and then its bytes. They fit
+		// because the ring's own headers are bigger than the lengths.
+		size_t staged = 0;
+
+		vtbl__lock(thread);
+		while (!vtbar_isempty(&thread->m_ring))
+		{
+			void* record;
+			int32_t length;
+			vtbar_peektail(&thread->m_ring, &record, &length);
+
+			memcpy(log->m_staging + staged, &length, sizeof(length));
+			memcpy(log->m_staging + staged + sizeof(length), record, (size_t)length);
+			staged += sizeof(length) + (size_t)length;
+
+			vtbar_freetail(&thread->m_ring, 0, 0);
+		}
+		vtbl__unlock(thread);
+
+		size_t read = 0;
+		while (read < staged)
+		{
+			int32_t length;
+			memcpy(&length, log->m_staging + read, sizeof(length));
+			const uint8_t* bytes = log->m_staging + read + sizeof(length);
+			read += sizeof(length) + (size_t)length;
+
+			vtbl__record record;
+			memcpy(&record, bytes, sizeof(record));
+
+			if (record.m_formatter)
+				vtbl__format_record(log, &record, bytes + sizeof(record));
+			else
+				vtbl__queue(log, (const char*)bytes + sizeof(record), strlen((const char*)bytes + sizeof(record)));
+		}
+
+		// The staging buffer is reused for the next thread, so anything
+		// pointing into it has to go now.
+		vtbl__write_all(log);
+
+		vtbl__thread* next = thread->m_next;
+
+		if (exited)
+		{
+			// Only the flusher unlinks, and new rings only go on the front,
+			// so this is only a race when it's first.
+			vtbl__thread* expected = thread;
+			if (previous)
+				previous->m_next = next;
+			else if (!log->m_threads.compare_exchange_strong(expected, next, std::memory_order_acquire, std::memory_order_acquire))
+			{
+				previous = expected;
+				while (previous->m_next != thread)
+					previous = previous->m_next;
+				previous->m_next = next;
+			}
+
+			vtbar_destroy(&thread->m_ring);
+			vtbl__release(thread);
+		}
+		else
+			previous = thread;
+
+		thread = next;
+	}
+
+	vtbl__write_all(log);
+}
+
+static void vtbl__flusher_main(vtb_log* log)
+{
+	std::unique_lock<std::mutex> lock(log->m_mutex);
+
+	for (;;)
+	{
+		std::chrono::steady_clock::time_point wake = std::chrono::steady_clock::now() + std::chrono::milliseconds(VTBL_FLUSH_INTERVAL_MS);
+		while (!log->m_shutdown && log->m_flush_requested == log->m_flush_done)
+		{
+			if (log->m_wake.wait_until(lock, wake) == std::cv_status::timeout)
+				break;
+		}
+
+		bool shutdown = log->m_shutdown;
+		int64_t requested = log->m_flush_requested;
+
+		lock.unlock();
+		vtbl__drain(log);
+		lock.lock();
+
+		log->m_flush_done = requested;
+		log->m_flushed.notify_all();
+
+		if (shutdown)
+			return;
+	}
+}
+
+VTBLDEF vtb_log* vtbl_create(int fd)
+{
+	VTBL__CHECK(fd >= 0);
+
+	vtb_log* log = new vtb_log;
+	log->m_fd = fd;
+	log->m_id = vtbl__next_log_id.fetch_add(1, std::memory_order_relaxed);
+	log->m_threads.store(0, std::memory_order_relaxed);
+	log->m_dropped.store(0, std::memory_order_relaxed);
+	log->m_flush_requested = log->m_flush_done = 0;
+	log->m_shutdown = false;
+	log->m_dropped_reported = 0;
+	log->m_staging = new uint8_t[VTBL_RING_SIZE];
+	log->m_text = new char[VTBL_TEXT_SIZE];
+	log->m_num_iov = 0;
+	log->m_text_used = 0;
+
+	log->m_flusher = std::thread(vtbl__flusher_main, log);
+
+	return log;
+}
+
+VTBLDEF void vtbl_destroy(vtb_log* log)
+{
+	VTBL__CHECK(log);
+
+	vtb_log* expected = log;
+	vtbl__default.compare_exchange_strong(expected, 0);
+
+	{
+		std::lock_guard<std::mutex> lock(log->m_mutex);
+		log->m_shutdown = true;
+	}
+	log->m_wake.notify_one();
+	log->m_flusher.join();
+
+	vtbl__thread* thread = log->m_threads.load(std::memory_order_acquire);
+	while (thread)
+	{
+		vtbl__thread* next = thread->m_next;
+		vtbar_destroy(&thread->m_ring);
+		vtbl__release(thread); // Threads still running let go of theirs later, see vtbl__get_thread.
+		thread = next;
+	}
+
+	delete[] log->m_staging;
+	delete[] log->m_text;
+	delete log;
+}
+
+VTBLDEF void vtbl_flush(vtb_log* log)
+{
+	VTBL__CHECK(log);
+
+	std::unique_lock<std::mutex> lock(log->m_mutex);
+	int64_t ticket = ++log->m_flush_requested;
+	log->m_wake.notify_one();
+
+	while (log->m_flush_done < ticket)
+		log->m_flushed.wait(lock);
+}
+
+VTBLDEF void vtbl_print(vtb_log* log, const char* text)
+{
+	VTBL__CHECK(text);
+
+	size_t length = strlen(text) + 1;
+
+	vtbl__thread* thread;
+	uint8_t* p = (uint8_t*)vtbl__begin(log, sizeof(vtbl__record) + length, &thread);
+	if (!p)
+		return;
+
+	vtbl__record record;
+	record.m_formatter = 0;
+	record.m_format = 0;
+	memcpy(p, &record, sizeof(record));
+	memcpy(p + sizeof(record), text, length);
+
+	vtbl__end(thread);
+}
+
+VTBLDEF int64_t vtbl_getnumdropped(vtb_log* log)
+{
+	VTBL__CHECK(log);
+
+	return log->m_dropped.load(std::memory_order_relaxed);
+}
+
+VTBLDEF void vtbl_setdefault(vtb_log* log)
+{
+	vtbl__default.store(log, std::memory_order_release);
+}
+
+VTBLDEF void vtbl_debug_print(const char* text)
+{
+	vtb_log* log = vtbl__default.load(std::memory_order_acquire);
+	if (log)
+		vtbl_print(log, text);
+	else
+		fputs(text, stderr);
+}
+
+VTBLDEF void vtbl_debug_flush()
+{
+	vtb_log* log = vtbl__default.load(std::memory_order_acquire);
+	if (log)
+		vtbl_flush(log);
+}
+
+#endif
@@ -0,0 +1,530 @@
+/*
+vtb_trace.h - public domain binary trace format for vtb.h profile zones
+
+This software is dual-licensed to the public domain and under the
+following license: you are granted a perpetual, irrevocable license
+to copy, modify, publish, and distribute this file as you see fit.
+
+vtb_profile_write_chrome_trace() in vtb.h writes about 80 bytes of JSON per
+zone, which is slow to write and too big to keep for long captures. This
+writes the same zones in a compact binary format instead, usually 3 to 5
+bytes per zone, and reads them back. tools/vtb_trace_decode.cpp turns a
+trace into Chrome trace JSON or a table of per-zone statistics offline.
+
+Zone names are interned: each distinct name is written once and zones refer
+to it by a small id. Names are looked up by their vtb_hash, so the same
+name at two call sites gets the same id. Each thread's zones are written
+together, and timestamps are written as the difference from the previous
+zone's, so they fit in a byte or two.
+
+The writer needs vtb.h and vtb_hash.h, so you also need to #define
+VTB_IMPLEMENTATION and VTB_HASH_IMPLEMENTATION in one file. The reader
+doesn't use them.
+
+
+COMPILING AND LINKING
+	You must
+
+	#define VTB_TRACE_IMPLEMENTATION
+
+	in exactly one C++ file that includes this header, before the include
+	like this:
+
+	#define VTB_TRACE_IMPLEMENTATION
+	#include "vtb_trace.h"
+
+	All other files can be just #include "vtb_trace.h" without the #define
+
+
+QUICK START
+	// Record zones with VProfileZone from vtb.h, then
+	FILE* file = fopen("capture.vtbt", "wb");
+	vtbt_write_profile(file);
+	fclose(file);
+
+	// Later, with the whole file in memory:
+	vtbt_reader r;
+	if (vtbt_open(&r, data, size))
+	{
+		vtbt_event e;
+		while (vtbt_next(&r, &e))
+			printf("%u %s %f\n", e.m_thread_id, e.m_name, (e.m_end - e.m_begin) / vtbt_getticksperus(&r));
+
+		vtbt_close(&r);
+	}
+
+
+FORMAT
+	Integers are LEB128 varints: 7 bits at a time, low bits first, with the
+	high bit set on every byte but the last. Signed ones are zigzag encoded
+	first, so small negative numbers are small too.
+
+	"VTBT"             4 bytes
+	version            1 byte, currently 1
+	ticks per us       8 byte little endian IEEE double
+
+	Then any number of records, each starting with a one byte tag:
+
+	VTBT_TAG_NAME      length, then that many bytes of name. Names get ids
+	                   0, 1, 2... in the order they appear, and always come
+	                   before the first zone that uses them.
+	VTBT_TAG_THREAD    thread id, zone count, then that many zones:
+	                   signed begin - previous begin, end - begin, name id.
+	                   Previous begin starts at 0 in each thread record.
+
+	A thread can have more than one thread record. Within one, zones are in
+	the order they ended, so an enclosing zone comes after the ones inside
+	it and begins can go backwards.
+
+
+ASSERT
+	Define VTBT_ASSERT(boolval) to override assert() and not use assert.h
+*/
+
+#ifndef VTB__TRACE_H
+#define VTB__TRACE_H
+
+#ifdef VTBT_STATIC
+#define VTBTDEF static
+#else
+#define VTBTDEF extern
+#endif
+
+#include <stdint.h> // For uint64_t
+#include <stddef.h> // For size_t
+#include <stdio.h>  // For FILE
+
+#define VTBT_VERSION 1
+
+#define VTBT_TAG_NAME 1
+#define VTBT_TAG_THREAD 2
+
+typedef struct
+{
+	uint32_t m_thread_id;
+	uint32_t m_name_id;
+	const char* m_name; // Lives until vtbt_close
+	uint64_t m_begin;   // In ticks, see vtbt_getticksperus
+	uint64_t m_end;
+} vtbt_event;
+
+#define VTB__PRIVATE_MEMBER(type, name) type vtb__##name
+
+// WARNING: Don't directly reference members of this struct. I reserve
+// the right to change them from version to version.
+typedef struct
+{
+	VTB__PRIVATE_MEMBER(const uint8_t*, m_data);
+	VTB__PRIVATE_MEMBER(size_t, m_size);
+	VTB__PRIVATE_MEMBER(size_t, m_position);
+	VTB__PRIVATE_MEMBER(double, m_ticks_per_us);
+
+	VTB__PRIVATE_MEMBER(char**, m_names);
+	VTB__PRIVATE_MEMBER(uint32_t, m_num_names);
+	VTB__PRIVATE_MEMBER(uint32_t, m_names_capacity);
+
+	// The thread record being read.
+	VTB__PRIVATE_MEMBER(uint32_t, m_thread_id);
+	VTB__PRIVATE_MEMBER(uint64_t, m_remaining);
+	VTB__PRIVATE_MEMBER(uint64_t, m_previous_begin);
+
+	VTB__PRIVATE_MEMBER(int, m_corrupt);
+} vtbt_reader;
+
+// Writes every zone vtb.h has recorded to file. Returns 1 on success, 0 if
+// a write failed. Export while the recording threads are quiet, as with
+// vtb_profile_write_chrome_trace.
+VTBTDEF int vtbt_write_profile(FILE* file);
+
+// Starts reading the trace in data, which has to stay put until vtbt_close.
+// Returns 0 if it doesn't start with a trace header this version can read,
+// in which case you don't need to call vtbt_close.
+VTBTDEF int vtbt_open(vtbt_reader* r, const void* data, size_t size);
+
+// Reads the next zone. Returns 0 when there are no more, or if the rest of
+// the trace is malformed, which vtbt_iscorrupt tells you.
+VTBTDEF int vtbt_next(vtbt_reader* r, vtbt_event* e);
+
+// Returns 1 if vtbt_next stopped because the trace was malformed or cut off.
+VTBTDEF int vtbt_iscorrupt(vtbt_reader* r);
+
+// Returns the number of timestamp ticks in a microsecond.
+VTBTDEF double vtbt_getticksperus(vtbt_reader* r);
+
+// Returns the number of names read so far, and one of them. Once vtbt_next
+// has returned 0 these are all of the names in the trace.
+VTBTDEF uint32_t vtbt_getnumnames(vtbt_reader* r);
+VTBTDEF const char* vtbt_getname(vtbt_reader* r, uint32_t name_id);
+
+VTBTDEF void vtbt_close(vtbt_reader* r);
+
+#endif // VTB__TRACE_H
+
+
+
+#ifdef VTB_TRACE_IMPLEMENTATION
+
+#ifndef VTBT_ASSERT
+#include <assert.h>
+#define VTBT_ASSERT(x) assert(x)
+#endif
+
+#ifdef VTBT_DEBUG
+#define VTBT__ASSERT VTBT_ASSERT
+#define VTBT__CHECK VTBT_ASSERT
+#else
+#define VTBT__ASSERT(x)
+#define VTBT__CHECK VTBT_ASSERT
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "vtb.h"
+#include "vtb_hash.h"
+
+static size_t vtbt__put_varint(uint8_t* out, uint64_t value)
+{
+	size_t length = 0;
+	while (value >= 0x80)
+	{
+		out[length++] = (uint8_t)(value | 0x80);
+		value >>= 7;
+	}
+	out[length++] = (uint8_t)value;
+	return length;
+}
+
+static uint64_t vtbt__zigzag(int64_t value)
+{
+	return ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+}
+
+static int64_t vtbt__unzigzag(uint64_t value)
+{
+	return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+}
+
+// A varint is at most 10 bytes.
+#define VTBT__MAX_VARINT 10
+
+struct vtbt__name
+{
+	const char* m_name; // 0 if the slot is empty
+	uint32_t m_hash;
+	uint32_t m_id;
+};
+
+struct vtbt__writer
+{
+	FILE* m_file;
+	int m_failed;
+
+	// Open addressing, always less than half full.
+	vtbt__name* m_names;
+	uint32_t m_table_size;
+	uint32_t m_num_names;
+
+	// The thread record being built. It's written when the thread changes,
+	// once the number of zones is known.
+	uint32_t m_thread_id;
+	uint64_t m_count;
+	uint64_t m_previous_begin;
+	uint8_t* m_events;
+	size_t m_events_size;
+	size_t m_events_capacity;
+};
+
+static void vtbt__write(vtbt__writer* w, const void* bytes, size_t size)
+{
+	if (!w->m_failed && fwrite(bytes, 1, size, w->m_file) != size)
+		w->m_failed = 1;
+}
+
+static void vtbt__write_varint(vtbt__writer* w, uint64_t value)
+{
+	uint8_t bytes[VTBT__MAX_VARINT];
+	vtbt__write(w, bytes, vtbt__put_varint(bytes, value));
+}
+
+static void vtbt__grow_names(vtbt__writer* w)
+{
+	uint32_t old_size = w->m_table_size;
+	vtbt__name* old_names = w->m_names;
+
+	w->m_table_size = old_size ? old_size*2 : 64;
+	w->m_names = (vtbt__name*)calloc(w->m_table_size, sizeof(vtbt__name));
+
+	for (uint32_t k = 0; k < old_size; k++)
+	{
+		if (!old_names[k].m_name)
+			continue;
+
+		uint32_t slot = old_names[k].m_hash & (w->m_table_size-1);
+		while (w->m_names[slot].m_name)
+			slot = (slot + 1) & (w->m_table_size-1);
+		w->m_names[slot] = old_names[k];
+	}
+
+	free(old_names);
+}
+
+// Returns the id of name, writing a name record the first time it's seen.
+static uint32_t vtbt__intern(vtbt__writer* w, const char* name)
+{
+	size_t length = strlen(name);
+
+	vtb_hash h = vtbh_new();
+	vtbh_string(&h, name, length);
+
+	uint32_t slot = h.hash & (w->m_table_size-1);
+	for (; w->m_names[slot].m_name; slot = (slot + 1) & (w->m_table_size-1))
+	{
+		vtbt__name* entry = &w->m_names[slot];
+		if (entry->m_hash == h.hash && (entry->m_name == name || strcmp(entry->m_name, name) == 0))
+			return entry->m_id;
+	}
+
+	uint32_t id = w->m_num_names++;
+	w->m_names[slot].m_name = name;
+	w->m_names[slot].m_hash = h.hash;
+	w->m_names[slot].m_id = id;
+
+	uint8_t tag = VTBT_TAG_NAME;
+	vtbt__write(w, &tag, 1);
+	vtbt__write_varint(w, length);
+	vtbt__write(w, name, length);
+
+	if (w->m_num_names*2 > w->m_table_size)
+		vtbt__grow_names(w);
+
+	return id;
+}
+
+static void vtbt__end_thread(vtbt__writer* w)
+{
+	if (!w->m_count)
+		return;
+
+	uint8_t tag = VTBT_TAG_THREAD;
+	vtbt__write(w, &tag, 1);
+	vtbt__write_varint(w, w->m_thread_id);
+	vtbt__write_varint(w, w->m_count);
+	vtbt__write(w, w->m_events, w->m_events_size);
+
+	w->m_count = 0;
+	w->m_previous_begin = 0;
+	w->m_events_size = 0;
+}
+
+static void vtbt__write_event(void* data, uint32_t thread_id, const vtb_profile_event* event)
+{
+	vtbt__writer* w = (vtbt__writer*)data;
+
+	if (thread_id != w->m_thread_id)
+	{
+		vtbt__end_thread(w);
+		w->m_thread_id = thread_id;
+	}
+
+	uint32_t name_id = vtbt__intern(w, event->m_name);
+
+	if (w->m_events_size + 3*VTBT__MAX_VARINT > w->m_events_capacity)
+	{
+		w->m_events_capacity = w->m_events_capacity ? w->m_events_capacity*2 : 4096;
+		w->m_events = (uint8_t*)realloc(w->m_events, w->m_events_capacity);
+		VTBT__CHECK(w->m_events);
+	}
+
+	uint8_t* out = w->m_events + w->m_events_size;
+	out += vtbt__put_varint(out, vtbt__zigzag((int64_t)(event->m_begin - w->m_previous_begin)));
+	out += vtbt__put_varint(out, event->m_end - event->m_begin);
+	out += vtbt__put_varint(out, name_id);
+	w->m_events_size = (size_t)(out - w->m_events);
+
+	w->m_previous_begin = event->m_begin;
+	w->m_count++;
+}
+
+VTBTDEF int vtbt_write_profile(FILE* file)
+{
+	VTBT__CHECK(file);
+
+	vtbt__writer w;
+	memset(&w, 0, sizeof(w));
+	w.m_file = file;
+	vtbt__grow_names(&w);
+
+	uint8_t header[13];
+	memcpy(header, "VTBT", 4);
+	header[4] = VTBT_VERSION;
+
+	double ticks_per_us = vtb_profile_ticks_per_us();
+	uint64_t bits;
+	memcpy(&bits, &ticks_per_us, sizeof(bits));
+	for (int k = 0; k < 8; k++)
+		header[5 + k] = (uint8_t)(bits >> (8*k));
+
+	vtbt__write(&w, header, sizeof(header));
+
+	vtb_profile_foreach(vtbt__write_event, &w);
+	vtbt__end_thread(&w);
+
+	free(w.m_names);
+	free(w.m_events);
+
+	return !w.m_failed;
+}
+
+static int vtbt__corrupt(vtbt_reader* r)
+{
+	r->vtb__m_corrupt = 1;
+	r->vtb__m_position = r->vtb__m_size;
+	return 0;
+}
+
+static int vtbt__read_varint(vtbt_reader* r, uint64_t* value)
+{
+	*value = 0;
+	for (int shift = 0; shift < 64; shift += 7)
+	{
+		if (r->vtb__m_position >= r->vtb__m_size)
+			return vtbt__corrupt(r);
+
+		uint8_t byte = r->vtb__m_data[r->vtb__m_position++];
+		*value |= (uint64_t)(byte & 0x7f) << shift;
+
+		if (!(byte & 0x80))
+			return 1;
+	}
+
+	return vtbt__corrupt(r);
+}
+
+static int vtbt__read_name(vtbt_reader* r)
+{
+	uint64_t length;
+	if (!vtbt__read_varint(r, &length) || length > r->vtb__m_size - r->vtb__m_position)
+		return vtbt__corrupt(r);
+
+	if (r->vtb__m_num_names == r->vtb__m_names_capacity)
+	{
+		r->vtb__m_names_capacity = r->vtb__m_names_capacity ? r->vtb__m_names_capacity*2 : 64;
+		r->vtb__m_names = (char**)realloc(r->vtb__m_names, r->vtb__m_names_capacity*sizeof(char*));
+		VTBT__CHECK(r->vtb__m_names);
+	}
+
+	char* name = (char*)malloc((size_t)length + 1);
+	VTBT__CHECK(name);
+	memcpy(name, r->vtb__m_data + r->vtb__m_position, (size_t)length);
+	name[length] = '\0';
+
+	r->vtb__m_names[r->vtb__m_num_names++] = name;
+	r->vtb__m_position += (size_t)length;
+
+	return 1;
+}
+
+VTBTDEF int vtbt_open(vtbt_reader* r, const void* data, size_t size)
+{
+	VTBT__CHECK(r);
+	VTBT__CHECK(data || !size);
+
+	const uint8_t* bytes = (const uint8_t*)data;
+	if (size < 13 || memcmp(bytes, "VTBT", 4) != 0 || bytes[4] != VTBT_VERSION)
+		return 0;
+
+	memset(r, 0, sizeof(*r));
+	r->vtb__m_data = bytes;
+	r->vtb__m_size = size;
+	r->vtb__m_position = 13;
+
+	uint64_t bits = 0;
+	for (int k = 0; k < 8; k++)
+		bits |= (uint64_t)bytes[5 + k] << (8*k);
+	memcpy(&r->vtb__m_ticks_per_us, &bits, sizeof(bits));
+
+	return 1;
+}
+
+VTBTDEF int vtbt_next(vtbt_reader* r, vtbt_event* e)
+{
+	VTBT__CHECK(r->vtb__m_data); // Call vtbt_open first
+
+	while (!r->vtb__m_remaining)
+	{
+		if (r->vtb__m_position >= r->vtb__m_size)
+			return 0;
+
+		uint8_t tag = r->vtb__m_data[r->vtb__m_position++];
+		if (tag == VTBT_TAG_NAME)
+		{
+			if (!vtbt__read_name(r))
+				return 0;
+		}
+		else if (tag == VTBT_TAG_THREAD)
+		{
+			uint64_t thread_id;
+			if (!vtbt__read_varint(r, &thread_id) || !vtbt__read_varint(r, &r->vtb__m_remaining))
+				return 0;
+
+			r->vtb__m_thread_id = (uint32_t)thread_id;
+			r->vtb__m_previous_begin = 0;
+		}
+		else
+			return vtbt__corrupt(r);
+	}
+
+	uint64_t begin_delta, duration, name_id;
+	if (!vtbt__read_varint(r, &begin_delta) || !vtbt__read_varint(r, &duration) || !vtbt__read_varint(r, &name_id))
+		return 0;
+
+	if (name_id >= r->vtb__m_num_names)
+		return vtbt__corrupt(r);
+
+	uint64_t begin = r->vtb__m_previous_begin + (uint64_t)vtbt__unzigzag(begin_delta);
+	r->vtb__m_previous_begin = begin;
+	r->vtb__m_remaining--;
+
+	e->m_thread_id = r->vtb__m_thread_id;
+	e->m_name_id = (uint32_t)name_id;
+	e->m_name = r->vtb__m_names[name_id];
+	e->m_begin = begin;
+	e->m_end = begin + duration;
+
+	return 1;
+}
+
+VTBTDEF int vtbt_iscorrupt(vtbt_reader* r)
+{
+	return r->vtb__m_corrupt;
+}
+
+VTBTDEF double vtbt_getticksperus(vtbt_reader* r)
+{
+	return r->vtb__m_ticks_per_us;
+}
+
+VTBTDEF uint32_t vtbt_getnumnames(vtbt_reader* r)
+{
+	return r->vtb__m_num_names;
+}
+
+VTBTDEF const char* vtbt_getname(vtbt_reader* r, uint32_t name_id)
+{
+	VTBT__CHECK(name_id < r->vtb__m_num_names);
+
+	return r->vtb__m_names[name_id];
+}
+
+VTBTDEF void vtbt_close(vtbt_reader* r)
+{
+	for (uint32_t k = 0; k < r->vtb__m_num_names; k++)
+		free(r->vtb__m_names[k]);
+
+	free(r->vtb__m_names);
+
+	memset(r, 0, sizeof(*r));
+}
+
+#endif